@@ -0,0 +1,139 @@
+/** @defgroup CM3_bitband_defines Cortex-M Bit-band Defines
+ *
+ * @brief <b>libopencm3 Cortex-M bit-band alias accessors</b>
+ *
+ * @ingroup CM3_defines
+ *
+ * On cores with bit-banding every bit of the first MiB of SRAM and of the
+ * peripheral space has an alias word. Writing the alias sets or clears just
+ * that bit in a single bus transaction, so flags shared with interrupt
+ * handlers can be updated without a read-modify-write race.
+ *
+ * The bitband_*() helpers take the address of a register or SRAM word and
+ * use the alias when the target core and address support it. Otherwise they
+ * fall back to a read-modify-write with interrupts masked, so callers get the
+ * same atomicity everywhere. With a constant address the choice is made at
+ * compile time.
+ *
+ * @code
+ * bitband_set(&TIM_DIER(TIM2), 0);		// UIE
+ * if (bitband_get(&flags, 3)) { ... }
+ * @endcode
+ *
+ * LGPL License Terms @ref lgpl_license
+ */
+/*
+ * This file is part of the libopencm3 project.
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**@{*/
+
+#ifndef LIBOPENCM3_CM3_BITBAND_H
+#define LIBOPENCM3_CM3_BITBAND_H
+
+#include <libopencm3/cm3/common.h>
+#include <libopencm3/cm3/cortex.h>
+#include <libopencm3/cm3/memorymap.h>
+
+#if defined(CM3_BITBAND_AVAILABLE)
+
+/** Alias address of bit @p bit of the word at @p addr, which must lie in
+ * one of the bit-band regions. Usable in constant expressions. */
+#define BITBAND_ADDR(addr, bit)						\
+	((((uint32_t)(addr)) & 0xF0000000U) + 0x02000000U +		\
+	 ((((uint32_t)(addr)) & 0x000FFFFFU) << 5) + ((uint32_t)(bit) << 2))
+
+/** Alias word for a single bit, e.g. MMIO32_BIT(GPIOA_ODR, 5) = 1; */
+#define MMIO32_BIT(addr, bit)		MMIO32(BITBAND_ADDR(addr, bit))
+
+/** Whether the word at @p addr has a bit-band alias */
+#define BITBAND_IN_REGION(addr)						\
+	(((uint32_t)(addr) - BITBAND_SRAM_BASE < BITBAND_REGION_SIZE) ||	\
+	 ((uint32_t)(addr) - BITBAND_PERIPH_BASE < BITBAND_REGION_SIZE))
+
+#else
+
+#define BITBAND_IN_REGION(addr)		(false)
+
+#endif
+
+/*---------------------------------------------------------------------------*/
+/** @brief Atomically write one bit of a 32 bit word.
+ *
+ * @param[in] addr Address of the register or SRAM word
+ * @param[in] bit Bit number, 0 to 31
+ * @param[in] value Bit value
+ */
+static inline void bitband_write(volatile uint32_t *addr, uint8_t bit,
+				 bool value)
+{
+#if defined(CM3_BITBAND_AVAILABLE)
+	if (BITBAND_IN_REGION(addr)) {
+		MMIO32(BITBAND_ADDR(addr, bit)) = value;
+		return;
+	}
+#endif
+	CM_ATOMIC_BLOCK() {
+		if (value) {
+			*addr |= 1U << bit;
+		} else {
+			*addr &= ~(1U << bit);
+		}
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Atomically set one bit of a 32 bit word.
+ *
+ * @param[in] addr Address of the register or SRAM word
+ * @param[in] bit Bit number, 0 to 31
+ */
+static inline void bitband_set(volatile uint32_t *addr, uint8_t bit)
+{
+	bitband_write(addr, bit, true);
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Atomically clear one bit of a 32 bit word.
+ *
+ * @param[in] addr Address of the register or SRAM word
+ * @param[in] bit Bit number, 0 to 31
+ */
+static inline void bitband_clear(volatile uint32_t *addr, uint8_t bit)
+{
+	bitband_write(addr, bit, false);
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Read one bit of a 32 bit word.
+ *
+ * @param[in] addr Address of the register or SRAM word
+ * @param[in] bit Bit number, 0 to 31
+ * @returns The bit value
+ */
+static inline bool bitband_get(const volatile uint32_t *addr, uint8_t bit)
+{
+#if defined(CM3_BITBAND_AVAILABLE)
+	if (BITBAND_IN_REGION(addr)) {
+		return MMIO32(BITBAND_ADDR(addr, bit));
+	}
+#endif
+	return (*addr >> bit) & 1;
+}
+
+#endif
+
+/**@}*/
@@ -0,0 +1,81 @@
+/** @defgroup CM3_executor_defines Cortex-M Deferred Work Executor Defines
+ *
+ * @brief <b>libopencm3 Defined Constants and Types for the PendSV executor</b>
+ *
+ * @ingroup CM3_defines
+ *
+ * A tiny run-to-completion executor for deferring work out of interrupt
+ * handlers without an RTOS. Interrupt handlers post work items into one of
+ * @ref EXECUTOR_CLASSES lock-free queues and pend PendSV, which runs at the
+ * lowest priority and drains the queues, most urgent class (0) first.
+ *
+ * A work item can only be queued once at a time: posting it again before it
+ * ran is a no-op, so an event raised many times is handled once. The item is
+ * released just before its function is called, which may repost it.
+ *
+ * Classes selected in executor_init() are run in deadline order instead of
+ * posting order. Deadlines are in whatever time base the caller uses (for
+ * example SysTick ticks) and may wrap around.
+ *
+ * LGPL License Terms @ref lgpl_license
+ */
+/*
+ * This file is part of the libopencm3 project.
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**@{*/
+
+#ifndef LIBOPENCM3_EXECUTOR_H
+#define LIBOPENCM3_EXECUTOR_H
+
+#include <libopencm3/cm3/common.h>
+
+/** Number of priority classes, class 0 is the most urgent */
+#ifndef EXECUTOR_CLASSES
+#define EXECUTOR_CLASSES		4
+#endif
+
+/* --- Executor types ------------------------------------------------------ */
+
+typedef void (*executor_fn_t)(void *arg);
+
+/** A deferred work item. Only fn and arg are to be set by the user. */
+struct executor_work {
+	executor_fn_t fn;
+	void *arg;
+	uint32_t deadline;
+	struct executor_work *next;
+	volatile uint32_t queued;
+};
+
+/** Static initialiser for a struct executor_work */
+#define EXECUTOR_WORK_INIT(func, argument)	{ .fn = (func), .arg = (argument) }
+
+/* --- Executor functions -------------------------------------------------- */
+
+BEGIN_DECLS
+
+void executor_init(uint32_t deadline_classes);
+bool executor_post(struct executor_work *work, uint8_t cls);
+bool executor_post_deadline(struct executor_work *work, uint8_t cls,
+			    uint32_t deadline);
+void executor_run(void);
+
+END_DECLS
+
+#endif
+
+/**@}*/
@@ -82,6 +82,30 @@
 #define ID_BASE                         (SCS_BASE + 0x0FD0)
 #endif
 
+/* --- Bit-band regions --- */
+
+/*
+ * Bit-banding is an optional ARMv7-M feature, present on the Cortex-M3/M4
+ * parts supported here but not on the Cortex-M7. GCC does not tell those
+ * apart, so the M7 families are excluded by name. Define CM3_NO_BITBAND to
+ * opt out on other parts without it.
+ */
+#if (defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__)) && \
+	!defined(STM32F7) && !defined(STM32H7) && !defined(CM3_NO_BITBAND)
+#define CM3_BITBAND_AVAILABLE		1
+
+/* SRAM bit-band region and its alias */
+#define BITBAND_SRAM_BASE               (0x20000000U)
+#define BITBAND_SRAM_ALIAS_BASE         (0x22000000U)
+
+/* Peripheral bit-band region and its alias */
+#define BITBAND_PERIPH_BASE             (0x40000000U)
+#define BITBAND_PERIPH_ALIAS_BASE       (0x42000000U)
+
+/* Each region covers 1MiB, every bit of it maps to one alias word */
+#define BITBAND_REGION_SIZE             (0x00100000U)
+#endif
+
 /**
  * @defgroup coresight_registers Coresight Registers
  * @{
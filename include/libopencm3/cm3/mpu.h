@@ -126,12 +126,34 @@
 #define MPU_RASR_ATTR_B			(1 << 16) /**< Bufferable */
 #define MPU_RASR_ATTR_SCB		(7 << 16) /**< SCB mask */
 /**@}*/
+
+/** @defgroup mpu_rasr_memtypes MPU RASR memory types
+ * @ingroup CM3_mpu_rasr
+ * Common TEX/C/B combinations, to be or'd with the access permissions.
+ * The cache policies only matter on cores with a cache (Cortex-M7), where
+ * the non-cacheable and write-through types are used for DMA buffers.
+ *
+ *@{*/
+#define MPU_RASR_ATTR_STRONGLY_ORDERED	(0) /**< Strongly ordered, shareable */
+#define MPU_RASR_ATTR_DEVICE		(MPU_RASR_ATTR_B) /**< Shared device */
+#define MPU_RASR_ATTR_NORMAL_NC		(1 << 19) /**< Normal, non-cacheable */
+#define MPU_RASR_ATTR_NORMAL_WT		(MPU_RASR_ATTR_C) /**< Normal, write-through, no write allocate */
+#define MPU_RASR_ATTR_NORMAL_WB		(MPU_RASR_ATTR_C | MPU_RASR_ATTR_B) /**< Normal, write-back, no write allocate */
+#define MPU_RASR_ATTR_NORMAL_WBWA	((1 << 19) | MPU_RASR_ATTR_C | MPU_RASR_ATTR_B) /**< Normal, write-back, write and read allocate */
+/**@}*/
 /**@}*/
 
 /* --- MPU functions ------------------------------------------------------- */
 
 BEGIN_DECLS
 
+void mpu_enable(uint32_t ctrl);
+void mpu_disable(void);
+void mpu_set_region(uint8_t region, uint32_t base, uint32_t size,
+		    uint32_t attrs);
+void mpu_disable_region(uint8_t region);
+void mpu_set_dma_region(uint8_t region, uint32_t base, uint32_t size,
+			bool write_through);
 
 END_DECLS
 
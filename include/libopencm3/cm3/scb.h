@@ -31,6 +31,7 @@
  * Manual" for either ARMv7-M or ARMV6-m.
  * @{
  */
+#include <stddef.h>
 #include <libopencm3/cm3/memorymap.h>
 #include <libopencm3/cm3/common.h>
 
@@ -192,6 +193,18 @@
 
 /** BPIALL: Branch predictor invalidate all */
 #define SCB_BPIALL				MMIO32(SCB_BASE + 0x278)
+
+/** ITCMCR: Instruction TCM Control Register (Cortex-M7) */
+#define SCB_ITCMCR				MMIO32(SCB_BASE + 0x290)
+
+/** DTCMCR: Data TCM Control Register (Cortex-M7) */
+#define SCB_DTCMCR				MMIO32(SCB_BASE + 0x294)
+
+/** AHBPCR: AHBP Control Register (Cortex-M7) */
+#define SCB_AHBPCR				MMIO32(SCB_BASE + 0x298)
+
+/** CACR: L1 Cache Control Register (Cortex-M7) */
+#define SCB_CACR				MMIO32(SCB_BASE + 0x29C)
 #endif
 
 /**@}*/
@@ -517,6 +530,51 @@
 #define SCB_CTR_IMINLINE_SHIFT	0
 #define SCB_CTR_IMINLINE_MASK	0xf
 
+/* --- SCB_CCSIDR values --------------------------------------------------- */
+/* WT: Write-through supported */
+#define SCB_CCSIDR_WT			(1 << 31)
+/* WB: Write-back supported */
+#define SCB_CCSIDR_WB			(1 << 30)
+/* RA: Read-allocate supported */
+#define SCB_CCSIDR_RA			(1 << 29)
+/* WA: Write-allocate supported */
+#define SCB_CCSIDR_WA			(1 << 28)
+/* NUMSETS: number of sets - 1 */
+#define SCB_CCSIDR_NUMSETS_SHIFT	13
+#define SCB_CCSIDR_NUMSETS_MASK		0x7fff
+/* ASSOCIATIVITY: number of ways - 1 */
+#define SCB_CCSIDR_ASSOCIATIVITY_SHIFT	3
+#define SCB_CCSIDR_ASSOCIATIVITY_MASK	0x3ff
+/* LINESIZE: log2 of number of words per line - 2 */
+#define SCB_CCSIDR_LINESIZE_SHIFT	0
+#define SCB_CCSIDR_LINESIZE_MASK	0x7
+
+/* --- SCB_CCSELR values --------------------------------------------------- */
+/* LEVEL: cache level selected, 0 for L1 */
+#define SCB_CCSELR_LEVEL_SHIFT	1
+#define SCB_CCSELR_LEVEL_MASK	0x7
+/* IND: select the instruction cache instead of the data cache */
+#define SCB_CCSELR_IND			(1 << 0)
+
+/* --- SCB_ITCMCR/SCB_DTCMCR values ---------------------------------------- */
+/* SZ: TCM size, 0 if not implemented, else 2^(SZ + 9) bytes */
+#define SCB_TCMCR_SZ_SHIFT		3
+#define SCB_TCMCR_SZ_MASK		0xf
+/* RETEN: retry phase enable */
+#define SCB_TCMCR_RETEN			(1 << 2)
+/* RMW: read-modify-write enable */
+#define SCB_TCMCR_RMW			(1 << 1)
+/* EN: TCM enable */
+#define SCB_TCMCR_EN			(1 << 0)
+
+/* --- SCB_CACR values ----------------------------------------------------- */
+/* FORCEWT: force write-through for all cacheable memory */
+#define SCB_CACR_FORCEWT		(1 << 2)
+/* ECCEN: cache ECC enable (ECCDIS on some revisions) */
+#define SCB_CACR_ECCEN			(1 << 1)
+/* SIWT: shared cacheable memory treated as write-through */
+#define SCB_CACR_SIWT			(1 << 0)
+
 #endif
 
 /* --- SCB_CPACR values ---------------------------------------------------- */
@@ -565,6 +623,31 @@ void scb_reset_core(void) __attribute__((noreturn));
 void scb_set_priority_grouping(uint32_t prigroup);
 #endif
 
+/* Cache and TCM control, only implemented on the Cortex-M7 parts */
+#if defined(__ARM_ARCH_7EM__) && (defined(STM32F7) || defined(STM32H7))
+void scb_enable_icache(void);
+void scb_disable_icache(void);
+void scb_invalidate_icache(void);
+void scb_invalidate_icache_range(const void *addr, size_t len);
+
+void scb_enable_dcache(void);
+void scb_disable_dcache(void);
+void scb_invalidate_dcache(void);
+void scb_clean_dcache(void);
+void scb_clean_invalidate_dcache(void);
+void scb_invalidate_dcache_range(const void *addr, size_t len);
+void scb_clean_dcache_range(const void *addr, size_t len);
+void scb_clean_invalidate_dcache_range(const void *addr, size_t len);
+uint32_t scb_get_dcache_line_size(void);
+
+void scb_enable_itcm(void);
+void scb_disable_itcm(void);
+void scb_enable_dtcm(void);
+void scb_disable_dtcm(void);
+uint32_t scb_get_itcm_size(void);
+uint32_t scb_get_dtcm_size(void);
+#endif
+
 END_DECLS
 
 /**@}*/
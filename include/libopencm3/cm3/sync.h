@@ -25,6 +25,8 @@
 BEGIN_DECLS
 
 void __dmb(void);
+void __dsb(void);
+void __isb(void);
 
 /* Implements synchronisation primitives as discussed in the ARM document
  * DHT0008A (ID081709) "ARM Synchronization Primitives" and the ARM v7-M
@@ -0,0 +1,115 @@
+/** @defgroup CM3_txq_defines Cortex-M Transmit Queue Defines
+ *
+ * @brief <b>libopencm3 single producer, single consumer byte queue</b>
+ *
+ * @ingroup CM3_defines
+ *
+ * The byte ring shared by the interrupt and DMA driven serial transmit
+ * queues of the vendor libraries. The producer only moves @c head, the
+ * consumer (an interrupt handler or DMA completion) only moves @c tail, so
+ * no locking is needed as long as each side is a single context. One byte
+ * of the storage is kept free to tell a full ring from an empty one.
+ *
+ * LGPL License Terms @ref lgpl_license
+ */
+/*
+ * This file is part of the libopencm3 project.
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**@{*/
+
+#ifndef LIBOPENCM3_CM3_TXQ_H
+#define LIBOPENCM3_CM3_TXQ_H
+
+#include <libopencm3/cm3/common.h>
+
+struct txq {
+	uint8_t *buf;
+	uint16_t size;
+	volatile uint16_t head;
+	volatile uint16_t tail;
+};
+
+static inline void txq_init(struct txq *q, uint8_t *buf, uint16_t size)
+{
+	q->buf = buf;
+	q->size = size;
+	q->head = 0;
+	q->tail = 0;
+}
+
+/** Number of queued bytes. */
+static inline uint16_t txq_used(const struct txq *q)
+{
+	return (q->head + q->size - q->tail) % q->size;
+}
+
+/** Number of bytes that can be queued without blocking. */
+static inline uint16_t txq_space(const struct txq *q)
+{
+	return q->size - 1 - txq_used(q);
+}
+
+/** Queue up to @p len bytes, returns the number actually queued. */
+static inline uint16_t txq_put(struct txq *q, const void *data, uint16_t len)
+{
+	const uint8_t *src = data;
+	uint16_t head = q->head;
+	uint16_t n = txq_space(q);
+	uint16_t i;
+
+	if (len < n) {
+		n = len;
+	}
+	for (i = 0; i < n; i++) {
+		q->buf[head] = src[i];
+		if (++head == q->size) {
+			head = 0;
+		}
+	}
+	q->head = head;
+	return n;
+}
+
+/** Contiguous run of queued bytes starting at the tail, returns its length. */
+static inline uint16_t txq_span(const struct txq *q, const uint8_t **data)
+{
+	uint16_t head = q->head;
+	uint16_t tail = q->tail;
+
+	*data = &q->buf[tail];
+	return (head >= tail) ? head - tail : q->size - tail;
+}
+
+/** Retire @p len bytes from the tail. */
+static inline void txq_advance(struct txq *q, uint16_t len)
+{
+	q->tail = (q->tail + len) % q->size;
+}
+
+/** Take one byte from the tail, the queue must not be empty. */
+static inline uint8_t txq_get(struct txq *q)
+{
+	uint16_t tail = q->tail;
+	uint8_t c = q->buf[tail];
+
+	q->tail = (tail + 1 == q->size) ? 0 : tail + 1;
+	return c;
+}
+
+#endif
+
+/**@}*/
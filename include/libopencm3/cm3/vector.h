@@ -61,8 +61,27 @@ typedef struct {
 	vector_table_entry_t irq[NVIC_IRQ_COUNT];
 } vector_table_t;
 
+/** Startup copy table entry: [start, end) is loaded from load_addr. */
+typedef struct {
+	const uint32_t *load_addr;
+	uint32_t *start;
+	uint32_t *end;
+} init_copy_region_t;
+
+/** Startup zero table entry: [start, end) is cleared. */
+typedef struct {
+	uint32_t *start;
+	uint32_t *end;
+} init_zero_region_t;
+
 /* Common symbols exported by the linker script(s): */
 extern unsigned _data_loadaddr, _data, _edata, _ebss, _stack;
 extern vector_table_t vector_table;
 
+/* Startup region tables, weak so older linker scripts still link. */
+extern const init_copy_region_t __copy_table_start[] __attribute__((weak));
+extern const init_copy_region_t __copy_table_end[] __attribute__((weak));
+extern const init_zero_region_t __zero_table_start[] __attribute__((weak));
+extern const init_zero_region_t __zero_table_end[] __attribute__((weak));
+
 #endif
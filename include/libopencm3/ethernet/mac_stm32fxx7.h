@@ -576,6 +576,7 @@
 #define ETH_DMAMFBOCR_MFC_SHIFT		0
 #define ETH_DMAMFBOCR_MFC		(0xFFFF << ETH_DMAMFBOCR_MFC_SHIFT)
 #define ETH_DMAMFBOCR_OMFC		(1<<16)
+#define ETH_DMAMFBOCR_MFA_SHIFT		17
 #define ETH_DMAMFBOCR_MFA		(0x7FF << ETH_DMAMFBOCR_MFA_SHIFT)
 #define ETH_DMAMFBOCR_OFOC		(1<<28)
 
@@ -729,6 +730,69 @@ enum eth_clk {
 	ETH_CLK_150_168MHZ = ETH_MACMIIAR_CR_HCLK_DIV_102,
 };
 
+/** Called when the DMA is done with a buffer passed to eth_tx_frame() or
+ * eth_tx_gather() */
+typedef void (*eth_tx_callback)(uint8_t *frame);
+
+/** One buffer of a frame sent with eth_tx_gather() */
+struct eth_iovec {
+	/** Start of the buffer */
+	uint8_t *base;
+	/** Length of the buffer, at most 8191 bytes */
+	uint32_t len;
+};
+
+/** Called by eth_rx_poll() with a received frame. Returns the buffer to
+ * give back to the descriptor: the frame itself, or a fresh buffer when the
+ * frame is kept, see eth_rx_release(). */
+typedef uint8_t *(*eth_rx_callback)(uint8_t *frame, uint32_t len);
+
+/** Receive statistics, see eth_rx_get_stats() */
+struct eth_rx_stats {
+	/** Frames delivered */
+	uint32_t frames;
+	/** Frames dropped for a CRC error */
+	uint32_t crc_errors;
+	/** Frames dropped for a length/type field mismatch */
+	uint32_t length_errors;
+	/** Frames dropped for a receive error signalled by the PHY */
+	uint32_t phy_errors;
+	/** Frames dropped for a late collision */
+	uint32_t collisions;
+	/** Frames dropped for being longer than the receive watchdog allows */
+	uint32_t watchdog;
+	/** Frames damaged by a receive FIFO overflow */
+	uint32_t overflows;
+	/** Frames truncated by a descriptor error */
+	uint32_t truncated;
+	/** Frames dropped for spreading over several descriptors */
+	uint32_t split;
+	/** Frames missed by the controller for lack of a free descriptor */
+	uint32_t missed;
+	/** Frames missed for lack of space in the receive FIFO */
+	uint32_t fifo_missed;
+	/** Number of times the DMA ran out of descriptors */
+	uint32_t ring_full;
+	/** Largest number of received descriptors found waiting by
+	 * eth_rx_poll(), lent ones included */
+	uint32_t ring_high;
+};
+
+/* eth_tx_gather() flags */
+/** More frames follow, do not issue the poll demand yet */
+#define ETH_TX_MORE			(1 << 0)
+
+#define ETH_TX_CIC_SHIFT		1
+#define ETH_TX_CIC_MASK			(7 << ETH_TX_CIC_SHIFT)
+/** Insert no checksum */
+#define ETH_TX_CIC_DISABLED		(1 << ETH_TX_CIC_SHIFT)
+/** Insert the IPv4 header checksum */
+#define ETH_TX_CIC_IP			(2 << ETH_TX_CIC_SHIFT)
+/** Insert the IPv4 header and TCP/UDP/ICMP checksums */
+#define ETH_TX_CIC_IPPL			(3 << ETH_TX_CIC_SHIFT)
+/** As ETH_TX_CIC_IPPL, with the pseudo-header checksum computed in hardware */
+#define ETH_TX_CIC_IPPLPH		(4 << ETH_TX_CIC_SHIFT)
+
 /*****************************************************************************/
 /* API Functions                                                             */
 /*****************************************************************************/
@@ -742,11 +806,27 @@ void eth_smi_bit_clear(uint8_t phy, uint8_t reg, uint16_t clearbits);
 void eth_smi_bit_set(uint8_t phy, uint8_t reg, uint16_t setbits);
 
 void eth_set_mac(const uint8_t *mac);
+void eth_filter_init(void);
+void eth_filter_add(const uint8_t *mac);
+bool eth_filter_remove(const uint8_t *mac);
+void eth_set_promiscuous(bool enable);
+void eth_set_pass_all_multicast(bool enable);
 void eth_desc_init(uint8_t *buf, uint32_t nTx, uint32_t nRx, uint32_t cTx,
 		    uint32_t cRx, bool isext);
 bool eth_tx(uint8_t *ppkt, uint32_t n);
 bool eth_rx(uint8_t *ppkt, uint32_t *len, uint32_t maxlen);
 
+void eth_set_tx_callback(eth_tx_callback callback);
+bool eth_tx_frame(uint8_t *frame, uint32_t n);
+bool eth_tx_gather(const struct eth_iovec *iov, uint32_t niov, uint32_t flags);
+void eth_tx_flush(void);
+uint32_t eth_tx_reclaim(void);
+bool eth_rx_acquire(uint8_t **ppkt, uint32_t *len);
+void eth_rx_release(uint8_t *buf);
+bool eth_rx_irq_handler(void);
+uint32_t eth_rx_poll(eth_rx_callback callback, uint32_t budget);
+void eth_rx_get_stats(struct eth_rx_stats *stats, bool clear);
+
 void eth_init(uint8_t phy, enum eth_clk clock);
 void eth_start(void);
 
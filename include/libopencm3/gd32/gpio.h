@@ -26,3 +26,4 @@
 #       error "gd32 family not defined."
 #endif
 
+#include <libopencm3/stm32/common/gpio_common_all_inline.h>
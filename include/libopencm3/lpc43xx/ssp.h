@@ -202,6 +202,14 @@ void ssp_init(ssp_num_t ssp_num,
 
 uint16_t ssp_transfer(ssp_num_t ssp_num, uint16_t data);
 
+/*
+ * Exchange len frames, keeping the 8 frame FIFOs full. tx may be NULL to
+ * send all ones and rx NULL to discard received frames. Frames wider than
+ * 8 bits are stored as uint16_t.
+ */
+void ssp_transfer_buffer(ssp_num_t ssp_num, const void *tx, void *rx,
+				uint16_t len);
+
 END_DECLS
 
 /**@}*/
@@ -22,6 +22,7 @@
 
 #include <libopencm3/cm3/common.h>
 #include <libopencm3/lpc43xx/memorymap.h>
+#include <libopencm3/cm3/txq.h>
 
 /* --- Convenience macros -------------------------------------------------- */
 
@@ -418,6 +419,24 @@ typedef enum {
 	UART_RX_DATA_ERROR = 2
 } uart_rx_data_ready_t;
 
+/* Depth of the transmit FIFO, filled in one go on each THRE interrupt */
+#define UART_TX_FIFO_DEPTH		16
+
+struct uart_txq;
+
+/* Called from interrupt context once the queue has drained into the
+ * transmit FIFO. */
+typedef void (*uart_txq_callback)(struct uart_txq *q);
+
+/* Interrupt driven transmit queue */
+struct uart_txq {
+	uart_num_t uart_num;
+	struct txq ring;
+	volatile bool active;
+	uart_txq_callback callback;
+	void *user;
+};
+
 /* function prototypes */
 
 BEGIN_DECLS
@@ -433,6 +452,16 @@ uint8_t uart_read_timeout(uart_num_t uart_num, uint32_t rx_timeout_nb_cycles,
 	    uart_error_t *error);
 void uart_write(uart_num_t uart_num, uint8_t data);
 
+/* Non-blocking transmit queue, uart_txq_irq_handler() must be called from
+ * the UART interrupt */
+void uart_txq_init(struct uart_txq *q, uart_num_t uart_num,
+	    uint8_t *buf, uint16_t size);
+uint16_t uart_txq_write(struct uart_txq *q, const void *data, uint16_t len);
+uint16_t uart_txq_space(const struct uart_txq *q);
+bool uart_txq_busy(const struct uart_txq *q);
+void uart_txq_flush(struct uart_txq *q);
+void uart_txq_irq_handler(struct uart_txq *q);
+
 END_DECLS
 
 #endif
@@ -22,6 +22,7 @@
 
 #include <libopencm3/cm3/common.h>
 #include <libopencm3/sam/memorymap.h>
+#include <libopencm3/cm3/txq.h>
 
 #define USART0		USART0_BASE
 #define USART1		USART1_BASE
@@ -213,6 +214,21 @@ enum usart_chrl {
 	USART_CHRL_8BIT,
 };
 
+struct usart_txq;
+
+/* Called from interrupt context once the queue has drained and the
+ * transmitter is empty. */
+typedef void (*usart_txq_callback)(struct usart_txq *q);
+
+/* Interrupt driven transmit queue */
+struct usart_txq {
+	uint32_t usart;
+	struct txq ring;
+	volatile bool active;
+	usart_txq_callback callback;
+	void *user;
+};
+
 BEGIN_DECLS
 
 void usart_set_baudrate(uint32_t usart, uint32_t baud);
@@ -236,6 +252,15 @@ void usart_wp_disable(uint32_t usart);
 void usart_wp_enable(uint32_t usart);
 void usart_select_clock(uint32_t usart, enum usart_clock clk);
 
+void usart_txq_init(struct usart_txq *q, uint32_t usart,
+		    uint8_t *buf, uint16_t size);
+uint16_t usart_txq_write(struct usart_txq *q, const void *data,
+			 uint16_t len);
+uint16_t usart_txq_space(const struct usart_txq *q);
+bool usart_txq_busy(const struct usart_txq *q);
+void usart_txq_flush(struct usart_txq *q);
+void usart_txq_irq_handler(struct usart_txq *q);
+
 END_DECLS
 
 #endif
@@ -0,0 +1,94 @@
+/** @defgroup adc_dma_defines ADC DMA Defines
+ *
+ * @ingroup STM32_defines
+ *
+ * @brief <b>Defined Constants and Types for streaming ADC acquisition</b>
+ *
+ * A regular sequence is converted over and over, normally on a timer
+ * trigger, and the results are moved by circular DMA into a buffer split in
+ * two halves. While the DMA fills one half, the other is handed to a
+ * callback as a completed block of samples, so the core only sees two
+ * interrupts per buffer whatever the sample rate.
+ *
+ * On the F4 and F7, the ADCs can be combined in one of the dual or triple
+ * modes, for example interleaved to multiply the sample rate of a single
+ * channel. The samples of all ADCs are then streamed from the common data
+ * register in conversion order.
+ *
+ * Supported on the F0, F3, F4, F7, G0, G4, L1 and L4.
+ *
+ * LGPL License Terms @ref lgpl_license
+ */
+/*
+ * This file is part of the libopencm3 project.
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBOPENCM3_ADC_DMA_H
+#define LIBOPENCM3_ADC_DMA_H
+
+#include <libopencm3/stm32/adc.h>
+#include <libopencm3/stm32/dma.h>
+
+/**@{*/
+
+struct adc_stream;
+
+/** Called from interrupt context with a completed half of the buffer. The
+ * block is overwritten once the DMA wraps around to it again. */
+typedef void (*adc_stream_callback)(struct adc_stream *s,
+				    const uint16_t *block, uint16_t n);
+
+/** Streaming acquisition state. */
+struct adc_stream {
+	/** ADC block register base address, the master in multi ADC mode */
+	uint32_t adc;
+	/** Block callback */
+	adc_stream_callback callback;
+	/** Free for use by the callback */
+	void *user;
+
+	/* Statistics, updated from interrupt context */
+	/** Number of blocks handed to the callback */
+	volatile uint32_t blocks;
+	/** Number of samples handed to the callback */
+	volatile uint32_t samples;
+	/** Number of overruns; each one discards the block being filled */
+	volatile uint32_t overruns;
+
+	/* Private to the library */
+	uint16_t *buf;
+	uint16_t len;
+	uint32_t multi;
+	struct dma_xfer xfer;
+};
+
+BEGIN_DECLS
+
+bool adc_stream_init(struct adc_stream *s, uint32_t adc, uint32_t dma,
+		     uint8_t channel, uint8_t request);
+#if defined(STM32F4) || defined(STM32F7)
+void adc_stream_set_multi_mode(struct adc_stream *s, uint32_t mode);
+#endif
+void adc_stream_start(struct adc_stream *s, uint8_t *channels,
+		      uint8_t length, uint16_t *buf, uint16_t len);
+void adc_stream_stop(struct adc_stream *s);
+void adc_stream_irq_handler(struct adc_stream *s);
+
+END_DECLS
+
+/**@}*/
+
+#endif
@@ -0,0 +1,125 @@
+/** @defgroup can_queue_defines CAN queue Defines
+ *
+ * @ingroup STM32F_defines
+ *
+ * @brief <b>Defined Constants and Types for interrupt driven CAN</b>
+ *
+ * The bxCAN only holds three received frames per FIFO and three frames to
+ * transmit. With bursty traffic at high bit rates, polling can_receive()
+ * loses frames and can_transmit() keeps failing. This layer moves frames
+ * between the peripheral and software queues from the interrupts:
+ * - both receive FIFOs are drained into a ring, each frame timestamped,
+ * - frames to transmit wait in a queue ordered by bus priority, and the
+ *   mailboxes are refilled as they empty. When a frame outranks all three
+ *   mailboxes, the lowest priority one is aborted and requeued so that it
+ *   cannot hold the higher priority frame back.
+ *
+ * The storage for both queues is provided by the application.
+ *
+ * LGPL License Terms @ref lgpl_license
+ */
+/*
+ * This file is part of the libopencm3 project.
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBOPENCM3_CAN_QUEUE_H
+#define LIBOPENCM3_CAN_QUEUE_H
+
+#include <libopencm3/stm32/can.h>
+
+/**@{*/
+
+/** One CAN frame. */
+struct can_frame {
+	/** Standard or extended identifier */
+	uint32_t id;
+	/** Receive time, see struct can_bus */
+	uint32_t timestamp;
+	/** The identifier is extended */
+	bool ext;
+	/** Remote transmission request */
+	bool rtr;
+	/** Payload length, 0 to 8 */
+	uint8_t length;
+	/** Received: index of the matching filter */
+	uint8_t fmi;
+	/** Payload */
+	uint8_t data[8];
+};
+
+struct can_bus;
+
+/** Called from interrupt context after frames have been received. */
+typedef void (*can_bus_callback)(struct can_bus *bus);
+
+/** Returns the current time, for the receive timestamps. */
+typedef uint32_t (*can_bus_clock)(void);
+
+/** CAN peripheral driven from interrupts. */
+struct can_bus {
+	/** CAN block register base address @ref can_reg_base */
+	uint32_t canport;
+	/** Optional time source. Without it, frames are timestamped with the
+	 * 16 bit time of the peripheral, only running in time triggered mode */
+	can_bus_clock clock;
+	/** Optional receive notification */
+	can_bus_callback callback;
+	/** Free for use by the callback */
+	void *user;
+
+	/* Statistics, updated from interrupt context */
+	/** Receive FIFO overruns, each losing one or more frames */
+	volatile uint32_t rx_overruns;
+	/** Frames lost because the receive ring was full */
+	volatile uint32_t rx_dropped;
+	/** Frames not transmitted: failed without automatic retransmission,
+	 * or preempted and found no room to be requeued */
+	volatile uint32_t tx_errors;
+	/** Number of times the error warning limit was reached */
+	volatile uint32_t error_warnings;
+	/** Number of times the peripheral went error passive */
+	volatile uint32_t error_passive;
+	/** Number of times the peripheral went bus off */
+	volatile uint32_t bus_off;
+
+	/* Private to the library */
+	struct can_frame *rx;
+	uint16_t rx_size;
+	volatile uint16_t rx_head;
+	volatile uint16_t rx_tail;
+	struct can_frame *tx;
+	uint16_t tx_size;
+	volatile uint16_t tx_count;
+	struct can_frame mailbox[3];
+	uint8_t aborting;
+};
+
+BEGIN_DECLS
+
+void can_bus_init(struct can_bus *bus, uint32_t canport,
+		  struct can_frame *rx, uint16_t rx_size,
+		  struct can_frame *tx, uint16_t tx_size);
+bool can_bus_send(struct can_bus *bus, const struct can_frame *frame);
+bool can_bus_receive(struct can_bus *bus, struct can_frame *frame);
+uint16_t can_bus_rx_pending(const struct can_bus *bus);
+uint16_t can_bus_tx_pending(const struct can_bus *bus);
+void can_bus_irq_handler(struct can_bus *bus);
+
+END_DECLS
+
+/**@}*/
+
+#endif
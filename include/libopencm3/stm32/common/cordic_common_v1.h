@@ -113,8 +113,10 @@ specific memorymap.h header before including this header file.*/
 #define CORDIC_CSR_FUNC_COSH            (0x5)
 #define CORDIC_CSR_FUNC_SINH            (0x6)
 #define CORDIC_CSR_FUNC_ATANH           (0x7)
-#define CORDIC_CSR_FUNC_COSINE          (0x8)
+#define CORDIC_CSR_FUNC_LN              (0x8)
 #define CORDIC_CSR_FUNC_SQRT            (0x9)
+/** @deprecated misnamed alias for LN, the cosine is CORDIC_CSR_FUNC_COS */
+#define CORDIC_CSR_FUNC_COSINE          CORDIC_CSR_FUNC_LN
 /**@}*/
 #define CORDIC_CSR_FUNC_SHIFT           (0)
 #define CORDIC_CSR_FUNC_MASK            (0xF << CORDIC_CSR_FUNC_SHIFT)
@@ -160,6 +162,12 @@ void cordic_cos_16bit_async(int16_t x);
 void cordic_cos_32bit_async(int32_t x);
 void cordic_sin_16bit_async(int16_t x);
 void cordic_sin_32bit_async(int32_t x);
+uint8_t cordic_function_arguments(uint8_t function);
+uint8_t cordic_function_results(uint8_t function);
+void cordic_configure_q15(uint8_t function);
+void cordic_configure_q31(uint8_t function);
+void cordic_compute_q15(uint8_t function, const int16_t *in, int16_t *out, uint32_t n);
+void cordic_compute_q31(uint8_t function, const int32_t *in, int32_t *out, uint32_t n);
 END_DECLS
 
 #endif
@@ -98,6 +98,19 @@ uint32_t crc_calculate(uint32_t data);
  */
 uint32_t crc_calculate_block(uint32_t *datap, int size);
 
+/**
+ * Add a byte stream to the CRC calculator and return the result.
+ * Bytes are processed in memory order, the first byte of the buffer going
+ * into the most significant bits of the first word. Whole words are fed to
+ * the hardware; trailing bytes are fed as bytes on parts with a
+ * programmable polynomial and folded in by software on the others, where
+ * the result then can not be continued by another call.
+ * @param[in] data pointer to the data, no alignment required
+ * @param[in] len length of data, in bytes
+ * @return final CRC calculator value
+ */
+uint32_t crc_calculate_bytes(const void *data, uint32_t len);
+
 END_DECLS
 
 /**@}*/
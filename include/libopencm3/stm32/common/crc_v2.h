@@ -101,6 +101,9 @@ void crc_set_polysize(uint32_t polysize);
 void crc_set_polynomial(uint32_t polynomial);
 void crc_set_initial(uint32_t initial);
 
+void crc_configure(uint32_t polynomial, uint32_t polysize,
+		   uint32_t initial, bool reflected);
+
 END_DECLS
 
 /**@}*/
@@ -269,6 +269,12 @@ enum crypto_datatype {
 	CRYPTO_DATA_BIT,
 };
 
+/** Saved state of a suspended operation, see crypto_context_save() */
+struct crypto_context {
+	uint32_t cr;
+	uint32_t iv[4];
+};
+
 BEGIN_DECLS
 void crypto_wait_busy(void);
 void crypto_set_key(enum crypto_keysize keysize, uint64_t key[]);
@@ -278,6 +284,8 @@ void crypto_set_algorithm(enum crypto_mode mode);
 void crypto_start(void);
 void crypto_stop(void);
 uint32_t crypto_process_block(uint32_t *inp, uint32_t *outp, uint32_t length);
+void crypto_context_save(struct crypto_context *ctx);
+void crypto_context_restore(const struct crypto_context *ctx);
 END_DECLS
 /**@}*/
 /**@}*/
@@ -184,5 +184,76 @@
 /** DMA2D Background Color Lookup table */
 #define DMA2D_BG_CLUT			(uint32_t *)(DMA2D_BASE + 0x800U)
 
+/* --- Queued 2D operations ------------------------------------------------ */
+
+/** A rectangle of pixels in memory, or a whole frame buffer. */
+struct dma2d_surface {
+	/** Address of the top left pixel */
+	void *pixels;
+	/** Distance between the starts of two lines, in pixels */
+	uint16_t stride;
+	/** Pixel format, DMA2D_xPFCCR_CM_* (DMA2D_OPFCCR_CM_* as output) */
+	uint8_t format;
+};
+
+struct dma2d_op;
+
+/** Called from interrupt context once an operation has finished. */
+typedef void (*dma2d_op_callback)(struct dma2d_op *op);
+
+/** One queued operation, set up by one of the dma2d_op_*() helpers. */
+struct dma2d_op {
+	/** Optional completion callback */
+	dma2d_op_callback callback;
+	/** Free for use by the callback */
+	void *user;
+	/** Set if the operation failed with a transfer or configuration
+	 * error */
+	bool error;
+
+	/* Private to the library */
+	struct dma2d_op *next;
+	uint32_t cr;
+	uint32_t fgmar;
+	uint32_t fgor;
+	uint32_t fgpfccr;
+	uint32_t fgcolr;
+	uint32_t fgcmar;
+	uint32_t bgmar;
+	uint32_t bgor;
+	uint32_t bgpfccr;
+	uint32_t opfccr;
+	uint32_t ocolr;
+	uint32_t omar;
+	uint32_t oor;
+	uint32_t nlr;
+};
+
+BEGIN_DECLS
+
+uint32_t dma2d_color(uint8_t format, uint32_t argb8888);
+void dma2d_op_fill(struct dma2d_op *op, const struct dma2d_surface *dst,
+		   uint16_t x, uint16_t y, uint16_t w, uint16_t h,
+		   uint32_t argb8888);
+void dma2d_op_copy(struct dma2d_op *op,
+		   const struct dma2d_surface *src, uint16_t sx, uint16_t sy,
+		   const struct dma2d_surface *dst, uint16_t dx, uint16_t dy,
+		   uint16_t w, uint16_t h);
+void dma2d_op_blend(struct dma2d_op *op,
+		    const struct dma2d_surface *fg, uint16_t fx, uint16_t fy,
+		    const struct dma2d_surface *bg, uint16_t bx, uint16_t by,
+		    const struct dma2d_surface *dst, uint16_t dx, uint16_t dy,
+		    uint16_t w, uint16_t h, uint32_t alpha_mode, uint8_t alpha);
+void dma2d_op_set_color(struct dma2d_op *op, uint32_t rgb888);
+void dma2d_op_load_clut(struct dma2d_op *op, const void *clut,
+			uint16_t entries, bool rgb888);
+void dma2d_submit(struct dma2d_op *op);
+void dma2d_irq_handler(void);
+void dma2d_set_software(bool enable);
+bool dma2d_busy(void);
+void dma2d_wait(void);
+
+END_DECLS
+
 /**@}*/
 #endif
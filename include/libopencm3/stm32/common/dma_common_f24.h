@@ -617,6 +617,8 @@ uint16_t dma_get_number_of_data(uint32_t dma, uint8_t stream);
 void dma_set_number_of_data(uint32_t dma, uint8_t stream, uint16_t number);
 
 END_DECLS
+
+#include <libopencm3/stm32/common/dma_xfer_common_all.h>
 /**@}*/
 #endif
 /** @cond */
@@ -415,6 +415,8 @@ void dma_set_number_of_data(uint32_t dma, uint8_t channel, uint16_t number);
 
 END_DECLS
 
+#include <libopencm3/stm32/common/dma_xfer_common_all.h>
+
 #endif
 /** @cond */
 #else
@@ -0,0 +1,149 @@
+/** @addtogroup dma_defines
+ */
+/*
+ * This file is part of the libopencm3 project.
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* THIS FILE SHOULD NOT BE INCLUDED DIRECTLY, BUT ONLY VIA DMA.H
+It is included by the common dma header of each controller variant and
+describes the same transfer descriptor for all of them. */
+
+/** @cond */
+#ifdef LIBOPENCM3_DMA_H
+/** @endcond */
+#ifndef LIBOPENCM3_DMA_XFER_COMMON_ALL_H
+#define LIBOPENCM3_DMA_XFER_COMMON_ALL_H
+
+/**@{*/
+
+/* --- Descriptor based transfers ------------------------------------------ */
+
+/** Number of streams/channels per controller tracked by the transfer pool */
+#define DMA_XFER_MAX_CHANNELS		8
+
+/** First stream/channel number of the controller variant */
+#if defined(LIBOPENCM3_DMA_COMMON_F24_H)
+#define DMA_XFER_FIRST_CHANNEL		DMA_STREAM0
+#else
+#define DMA_XFER_FIRST_CHANNEL		DMA_CHANNEL1
+#endif
+
+/** @defgroup dma_xfer_dir DMA transfer direction
+@{*/
+#define DMA_XFER_PERIPH_TO_MEM		0
+#define DMA_XFER_MEM_TO_PERIPH		1
+#define DMA_XFER_MEM_TO_MEM		2
+/**@}*/
+
+/** @defgroup dma_xfer_width DMA transfer data width
+@{*/
+#define DMA_XFER_WIDTH_8BIT		0
+#define DMA_XFER_WIDTH_16BIT		1
+#define DMA_XFER_WIDTH_32BIT		2
+/**@}*/
+
+/** @defgroup dma_xfer_flags DMA transfer mode flags
+@{*/
+/** Increment the source address after each data item */
+#define DMA_XFER_SRC_INC		(1 << 0)
+/** Increment the destination address after each data item */
+#define DMA_XFER_DST_INC		(1 << 1)
+/** Restart from the beginning when count reaches zero (not for mem-to-mem) */
+#define DMA_XFER_CIRCULAR		(1 << 2)
+/** Call back when half of the data items have been transferred */
+#define DMA_XFER_HALF_IRQ		(1 << 3)
+/**@}*/
+
+/** @defgroup dma_xfer_evt DMA transfer callback events
+@{*/
+#define DMA_XFER_EVT_HALF		(1 << 0)
+#define DMA_XFER_EVT_COMPLETE		(1 << 1)
+#define DMA_XFER_EVT_ERROR		(1 << 2)
+/**@}*/
+
+struct dma_xfer;
+
+/** Transfer event callback, called from dma_xfer_irq_handler().
+ * @param xfer descriptor the event belongs to
+ * @param events bitwise OR of @ref dma_xfer_evt
+ */
+typedef void (*dma_xfer_callback)(struct dma_xfer *xfer, uint32_t events);
+
+/** DMA transfer descriptor.
+ *
+ * Fill in the transfer description, bind the descriptor to a stream or
+ * channel with dma_xfer_claim() or dma_xfer_claim_any() and start it with
+ * dma_xfer_submit(). A claimed descriptor may be submitted again once the
+ * previous transfer has finished.
+ */
+struct dma_xfer {
+	/** Source address (peripheral data register or memory) */
+	uint32_t src;
+	/** Destination address (peripheral data register or memory) */
+	uint32_t dst;
+	/** Number of data items, in units of the peripheral side width */
+	uint16_t count;
+	/** Direction, @ref dma_xfer_dir */
+	uint8_t direction;
+	/** Source data width, @ref dma_xfer_width */
+	uint8_t src_width;
+	/** Destination data width, @ref dma_xfer_width */
+	uint8_t dst_width;
+	/** Arbiter priority, 0 (low) to 3 (very high) */
+	uint8_t priority;
+	/** Bitwise OR of @ref dma_xfer_flags */
+	uint16_t flags;
+	/** Request routing: stream channel (CHSEL) on F2/F4/F7, request
+	 * selection (CSELR) on F0/L0/L4 or request line id on parts with a
+	 * DMAMUX. Ignored on parts with hardwired requests. */
+	uint8_t request;
+	/** Optional event callback */
+	dma_xfer_callback callback;
+	/** Free for use by the callback */
+	void *user;
+
+	/* Filled in by the library */
+	/** Controller the descriptor is bound to, 0 when unbound */
+	uint32_t dma;
+	/** Stream or channel the descriptor is bound to */
+	uint8_t channel;
+	/** Set while a transfer is in progress */
+	volatile bool busy;
+};
+
+/* --- Function prototypes ------------------------------------------------- */
+
+BEGIN_DECLS
+
+bool dma_xfer_claim(struct dma_xfer *xfer, uint32_t dma, uint8_t channel);
+bool dma_xfer_claim_any(struct dma_xfer *xfer, uint32_t dma,
+			uint32_t channel_mask);
+void dma_xfer_release(struct dma_xfer *xfer);
+struct dma_xfer *dma_xfer_get_owner(uint32_t dma, uint8_t channel);
+bool dma_xfer_submit(struct dma_xfer *xfer);
+void dma_xfer_abort(struct dma_xfer *xfer);
+uint16_t dma_xfer_remaining(const struct dma_xfer *xfer);
+void dma_xfer_irq_handler(uint32_t dma, uint8_t channel);
+
+END_DECLS
+
+/**@}*/
+#endif
+/** @cond */
+#else
+#warning "dma_xfer_common_all.h should not be included explicitly, only via dma.h"
+#endif
+/** @endcond */
@@ -257,6 +257,13 @@
 #define DSI_GHCR_VCID_MASK		0x3
 #define DSI_GHCR_DT_SHIFT		0
 #define DSI_GHCR_DT_MASK		0x3f
+#define DSI_GHCR_DT_DCS_SHORT_WRITE0	0x05
+#define DSI_GHCR_DT_DCS_SHORT_WRITE1	0x15
+#define DSI_GHCR_DT_DCS_LONG_WRITE	0x39
+
+/* DCS commands used for partial refreshes */
+#define DSI_DCS_SET_COLUMN_ADDRESS	0x2a
+#define DSI_DCS_SET_PAGE_ADDRESS	0x2b
 
 /**
  * DSI Host Generic Payload Data Register
@@ -818,6 +825,17 @@
 #define DSI_WRPCR_NDIV_MASK		0x7f
 #define DSI_WRPCR_PLLEN			(1 << 0)
 
+BEGIN_DECLS
+
+void dsi_dcs_write(uint8_t vcid, uint8_t cmd, const uint8_t *params,
+		   uint16_t len);
+void dsi_set_update_area(uint8_t vcid, uint16_t x, uint16_t y,
+			 uint16_t w, uint16_t h);
+void dsi_refresh(void);
+bool dsi_refresh_busy(void);
+
+END_DECLS
+
 /** @cond */
 #endif
 /** @endcond */
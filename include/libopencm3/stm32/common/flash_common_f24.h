@@ -156,6 +156,11 @@ void flash_program_word(uint32_t address, uint32_t data);
 void flash_program_half_word(uint32_t address, uint16_t data);
 void flash_program_byte(uint32_t address, uint8_t data);
 void flash_program(uint32_t address, const uint8_t *data, uint32_t len);
+uint32_t flash_program_size_for_voltage(uint32_t vdd_mv, bool external_vpp);
+uint32_t flash_program_fast(uint32_t address, const uint8_t *data,
+			    uint32_t len, uint32_t program_size);
+uint32_t flash_program_fast_ram(uint32_t address, const uint8_t *data,
+				uint32_t len, uint32_t program_size);
 void flash_program_option_bytes(uint32_t data);
 
 END_DECLS
@@ -0,0 +1,82 @@
+/** @addtogroup gpio_defines
+ */
+/*
+ * This file is part of the libopencm3 project.
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* THIS FILE SHOULD NOT BE INCLUDED DIRECTLY, BUT ONLY VIA GPIO.H
+It needs the port registers, so gpio.h includes it after the family header. */
+
+/** @cond */
+#if defined(LIBOPENCM3_GPIO_H)
+/** @endcond */
+#ifndef LIBOPENCM3_GPIO_COMMON_ALL_INLINE_H
+#define LIBOPENCM3_GPIO_COMMON_ALL_INLINE_H
+
+/**@{*/
+
+/* --- Inline fast path ---------------------------------------------------- */
+
+/* Bodies of gpio_set() and friends, used directly when
+ * LIBOPENCM3_INLINE_ACCESSORS is defined before including gpio.h. */
+
+static inline void gpio_set_inline(uint32_t gpioport, uint16_t gpios)
+{
+	GPIO_BSRR(gpioport) = gpios;
+}
+
+static inline void gpio_clear_inline(uint32_t gpioport, uint16_t gpios)
+{
+	GPIO_BSRR(gpioport) = (uint32_t)gpios << 16;
+}
+
+static inline uint16_t gpio_port_read_inline(uint32_t gpioport)
+{
+	return (uint16_t)GPIO_IDR(gpioport);
+}
+
+static inline uint16_t gpio_get_inline(uint32_t gpioport, uint16_t gpios)
+{
+	return gpio_port_read_inline(gpioport) & gpios;
+}
+
+static inline void gpio_toggle_inline(uint32_t gpioport, uint16_t gpios)
+{
+	uint32_t port = GPIO_ODR(gpioport);
+	GPIO_BSRR(gpioport) = ((port & gpios) << 16) | (~port & gpios);
+}
+
+static inline void gpio_port_write_inline(uint32_t gpioport, uint16_t data)
+{
+	GPIO_ODR(gpioport) = data;
+}
+
+#if defined(LIBOPENCM3_INLINE_ACCESSORS)
+#define gpio_set(gpioport, gpios)	gpio_set_inline(gpioport, gpios)
+#define gpio_clear(gpioport, gpios)	gpio_clear_inline(gpioport, gpios)
+#define gpio_get(gpioport, gpios)	gpio_get_inline(gpioport, gpios)
+#define gpio_toggle(gpioport, gpios)	gpio_toggle_inline(gpioport, gpios)
+#define gpio_port_read(gpioport)	gpio_port_read_inline(gpioport)
+#define gpio_port_write(gpioport, data)	gpio_port_write_inline(gpioport, data)
+#endif
+
+/**@}*/
+#endif
+/** @cond */
+#else
+#warning "gpio_common_all_inline.h should not be included explicitly, only via gpio.h"
+#endif
+/** @endcond */
@@ -62,8 +62,8 @@
 /* HASH status register (HASH_SR) */
 #define HASH_SR		MMIO32(HASH + 0x28)
 
-/* HASH context swap registers (HASH_CSR[51]) */
-#define HASH_CSR	(&MMIO32(HASH + 0xF8)) /* x51 */
+/* HASH context swap registers (HASH_CSR[51], HASH_CSR[54] with SHA-224/256) */
+#define HASH_CSR	(&MMIO32(HASH + 0xF8)) /* x51, x54 */
 
 /* --- HASH_CR values ------------------------------------------------------ */
 
@@ -114,6 +114,9 @@
 /* DINNE: DIN(Data input register) not empty */
 #define HASH_CR_DINNE		(1 << 12)
 
+/* MDMAT: Multiple DMA transfers, digest not started at the end of one */
+#define HASH_CR_MDMAT		(1 << 13)
+
 /* LKEY: Long key selection */
 /****************************************************************************/
 /** @defgroup hash_key_length HASH Key length
@@ -156,6 +159,27 @@
 /* BUSY: Busy bit */
 #define HASH_SR_BUSY		(1 << 3)
 
+/* --- HASH context ------------------------------------------------------- */
+
+/** Number of HASH_CSR registers making up the context, at most. The
+ * processor with SHA-224/256 of the F42x/43x and F469/479 has HASH_CSR0..53,
+ * the one of the F2 and F405/415/407/417 HASH_CSR0..50. All of them are
+ * needed in HMAC mode. */
+#define HASH_CSR_COUNT		54
+/** Number of them without SHA-224/256 */
+#define HASH_CSR_COUNT_SHA1	51
+
+/** Number of HASH_CSR registers making up the context in hash mode */
+#define HASH_CSR_COUNT_HASH	38
+
+/** Saved state of a suspended message, see hash_context_save() */
+struct hash_context {
+	uint32_t imr;
+	uint32_t str;
+	uint32_t cr;
+	uint32_t csr[HASH_CSR_COUNT];
+};
+
 /* --- HASH function prototypes -------------------------------------------- */
 
 BEGIN_DECLS
@@ -169,6 +193,8 @@ void hash_init(void);
 void hash_add_data(uint32_t data);
 void hash_digest(void);
 void hash_get_result(uint32_t *data);
+void hash_context_save(struct hash_context *ctx);
+void hash_context_restore(const struct hash_context *ctx);
 
 END_DECLS
 /**@}*/
@@ -512,6 +512,59 @@ void ltdc_setup_windowing(
 
 
 
+/**
+ * double buffered layer
+ */
+
+struct ltdc_fb;
+
+/** Called from interrupt context by ltdc_fb_irq_handler() */
+typedef void (*ltdc_fb_callback)(struct ltdc_fb *fb);
+
+/** Front and back frame buffers of one layer, swapped during vertical
+ * blanking. */
+struct ltdc_fb {
+	/** Called once a swap has taken effect, the old front buffer is
+	 * the new back buffer */
+	ltdc_fb_callback swap_callback;
+	/** Called when the line set with ltdc_fb_set_line_interrupt() is
+	 * reached */
+	ltdc_fb_callback line_callback;
+	/** Free for use by the callbacks */
+	void *user;
+	/** Number of completed swaps */
+	volatile uint32_t swaps;
+	/** Number of FIFO underruns and transfer errors */
+	volatile uint32_t underruns;
+
+	/* Private to the library */
+	uint32_t buffer[2];
+	uint32_t offset;
+	uint16_t width;
+	uint16_t height;
+	uint16_t pitch;
+	uint8_t bpp;
+	uint8_t layer;
+	volatile uint8_t front;
+	volatile bool pending;
+};
+
+BEGIN_DECLS
+
+uint32_t ltdc_fb_init(struct ltdc_fb *fb, uint8_t layer, uint32_t base,
+		      uint16_t width, uint16_t height);
+void *ltdc_fb_front(const struct ltdc_fb *fb);
+void *ltdc_fb_back(const struct ltdc_fb *fb);
+bool ltdc_fb_swap(struct ltdc_fb *fb);
+bool ltdc_fb_swap_pending(const struct ltdc_fb *fb);
+void ltdc_fb_wait_swap(const struct ltdc_fb *fb);
+void ltdc_fb_set_line_interrupt(struct ltdc_fb *fb, uint16_t line);
+void ltdc_fb_set_window(struct ltdc_fb *fb, uint16_t x, uint16_t y,
+			uint16_t w, uint16_t h);
+void ltdc_fb_irq_handler(struct ltdc_fb *fb);
+
+END_DECLS
+
 /**
  * Helper function to wait for SRCR reload to complete or so
  */
@@ -351,6 +351,7 @@ void spi_write(uint32_t spi, uint16_t data);
 void spi_send(uint32_t spi, uint16_t data);
 uint16_t spi_read(uint32_t spi);
 uint16_t spi_xfer(uint32_t spi, uint16_t data);
+void spi_transfer(uint32_t spi, const void *tx, void *rx, uint16_t len);
 void spi_set_bidirectional_mode(uint32_t spi);
 void spi_set_unidirectional_mode(uint32_t spi);
 void spi_set_bidirectional_receive_only_mode(uint32_t spi);
@@ -390,6 +391,42 @@ void spi_set_standard_mode(uint32_t spi, uint8_t mode);
 
 END_DECLS
 
+/* --- Inline fast path ---------------------------------------------------- */
+
+/* Data register accesses for polled loops, in place of the library calls
+ * with LIBOPENCM3_INLINE_ACCESSORS. */
+
+static inline void spi_write_inline(uint32_t spi, uint16_t data)
+{
+	SPI_DR(spi) = data;
+}
+
+static inline void spi_send_inline(uint32_t spi, uint16_t data)
+{
+	while (!(SPI_SR(spi) & SPI_SR_TXE));
+	SPI_DR(spi) = data;
+}
+
+static inline uint16_t spi_read_inline(uint32_t spi)
+{
+	while (!(SPI_SR(spi) & SPI_SR_RXNE));
+	return SPI_DR(spi);
+}
+
+static inline uint16_t spi_xfer_inline(uint32_t spi, uint16_t data)
+{
+	SPI_DR(spi) = data;
+	while (!(SPI_SR(spi) & SPI_SR_RXNE));
+	return SPI_DR(spi);
+}
+
+#if defined(LIBOPENCM3_INLINE_ACCESSORS)
+#define spi_write(spi, data)		spi_write_inline(spi, data)
+#define spi_send(spi, data)		spi_send_inline(spi, data)
+#define spi_read(spi)			spi_read_inline(spi)
+#define spi_xfer(spi, data)		spi_xfer_inline(spi, data)
+#endif
+
 /**@}*/
 
 #endif
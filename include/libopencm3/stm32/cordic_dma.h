@@ -0,0 +1,85 @@
+/** @defgroup cordic_dma_defines CORDIC DMA Defines
+ *
+ * @ingroup STM32_defines
+ *
+ * @brief <b>Defined Constants and Types for DMA driven CORDIC batches</b>
+ *
+ * Two DMA channels keep the CORDIC pipeline full: one writes the arguments
+ * whenever the argument register is free, the other reads the results as
+ * soon as they are ready. The core is free until the whole batch is done.
+ *
+ * Arguments and results use the layout of cordic_compute_q15() and
+ * cordic_compute_q31(). In q1.15 batches the DMA widens single arguments
+ * and narrows single results, so arrays of halfwords are used as they are.
+ *
+ * LGPL License Terms @ref lgpl_license
+ */
+/*
+ * This file is part of the libopencm3 project.
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBOPENCM3_CORDIC_DMA_H
+#define LIBOPENCM3_CORDIC_DMA_H
+
+#include <libopencm3/stm32/cordic.h>
+#include <libopencm3/stm32/dma.h>
+
+/**@{*/
+
+struct cordic_dma;
+
+/** Called from interrupt context once all results have been stored. */
+typedef void (*cordic_dma_callback)(struct cordic_dma *c);
+
+/** DMA driven CORDIC batch. */
+struct cordic_dma {
+	/** Optional completion callback */
+	cordic_dma_callback callback;
+	/** Free for use by the callback */
+	void *user;
+	/** Set if a DMA error cut the batch short */
+	bool error;
+
+	/* Private to the library */
+	uint32_t in;
+	uint32_t out;
+	uint32_t left;
+	uint8_t in_step;
+	uint8_t out_step;
+	uint8_t in_words;
+	uint8_t out_words;
+	volatile bool busy;
+	struct dma_xfer wr_xfer;
+	struct dma_xfer rd_xfer;
+};
+
+BEGIN_DECLS
+
+bool cordic_dma_init(struct cordic_dma *c, uint32_t dma,
+		     uint8_t wr_channel, uint8_t wr_request,
+		     uint8_t rd_channel, uint8_t rd_request);
+bool cordic_compute_q15_dma(struct cordic_dma *c, uint8_t function,
+			    const int16_t *in, int16_t *out, uint32_t n);
+bool cordic_compute_q31_dma(struct cordic_dma *c, uint8_t function,
+			    const int32_t *in, int32_t *out, uint32_t n);
+bool cordic_dma_busy(const struct cordic_dma *c);
+void cordic_dma_wait(const struct cordic_dma *c);
+
+END_DECLS
+
+/**@}*/
+
+#endif
@@ -0,0 +1,76 @@
+/** @defgroup crc_dma_defines CRC DMA Defines
+ *
+ * @ingroup STM32_defines
+ *
+ * @brief <b>Defined Constants and Types for DMA fed CRC calculations</b>
+ *
+ * Feeds a region of memory to the CRC unit with a memory to memory DMA
+ * transfer, leaving the core free while for example a firmware image is
+ * verified at boot. Regions of any size are split into DMA transfers of at
+ * most 65535 words internally.
+ *
+ * The words are fed as they are read from memory, like
+ * crc_calculate_block(). On parts with a programmable polynomial, setting
+ * CRC_CR_REV_IN_WORD and CRC_CR_REV_OUT turns this into a byte stream CRC
+ * for reflected algorithms such as the CRC-32 of zlib.
+ *
+ * LGPL License Terms @ref lgpl_license
+ */
+/*
+ * This file is part of the libopencm3 project.
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBOPENCM3_CRC_DMA_H
+#define LIBOPENCM3_CRC_DMA_H
+
+#include <libopencm3/stm32/crc.h>
+#include <libopencm3/stm32/dma.h>
+
+/**@{*/
+
+struct crc_dma;
+
+/** Called from interrupt context with the CRC once the region is done. */
+typedef void (*crc_dma_callback)(struct crc_dma *c, uint32_t crc);
+
+/** DMA fed CRC calculation. */
+struct crc_dma {
+	/** Optional completion callback */
+	crc_dma_callback callback;
+	/** Free for use by the callback */
+	void *user;
+	/** Set if a DMA error cut the calculation short */
+	bool error;
+
+	/* Private to the library */
+	uint32_t next;
+	uint32_t left;
+	volatile bool busy;
+	struct dma_xfer xfer;
+};
+
+BEGIN_DECLS
+
+bool crc_dma_init(struct crc_dma *c, uint32_t dma, uint8_t channel);
+bool crc_dma_start(struct crc_dma *c, const uint32_t *data, uint32_t words);
+bool crc_dma_busy(const struct crc_dma *c);
+uint32_t crc_dma_wait(const struct crc_dma *c);
+
+END_DECLS
+
+/**@}*/
+
+#endif
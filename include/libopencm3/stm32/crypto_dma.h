@@ -0,0 +1,116 @@
+/** @defgroup crypto_dma_defines HASH and CRYP DMA Defines
+ *
+ * @ingroup STM32_defines
+ *
+ * @brief <b>Defined Constants and Types for DMA streaming to the HASH and
+ * CRYP processors</b>
+ *
+ * The HASH processor is fed by one DMA stream. A message can be given in
+ * several buffers, using the multiple DMA transfer mode (MDMAT) until the
+ * last one, whose length sets the number of valid bits in the final word
+ * before the digest calculation starts by itself. Its end is signalled by
+ * the HASH_RNG interrupt, whose vector must call hash_dma_irq_handler().
+ *
+ * The CRYP processor is fed and drained by a pair of DMA streams, so the
+ * core is free while a buffer is processed.
+ *
+ * Several messages can be interleaved by saving and restoring the processor
+ * contexts between buffers with hash_context_save(), hash_context_restore(),
+ * crypto_context_save() and crypto_context_restore().
+ *
+ * On the F2/F4, the requests are on DMA2: HASH_IN is stream 7 channel 2,
+ * CRYP_IN stream 6 channel 2 and CRYP_OUT stream 5 channel 2.
+ *
+ * LGPL License Terms @ref lgpl_license
+ */
+/*
+ * This file is part of the libopencm3 project.
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBOPENCM3_CRYPTO_DMA_H
+#define LIBOPENCM3_CRYPTO_DMA_H
+
+#include <libopencm3/stm32/crypto.h>
+#include <libopencm3/stm32/dma.h>
+#include <libopencm3/stm32/hash.h>
+
+/**@{*/
+
+struct hash_dma;
+struct crypto_dma;
+
+/** Called from interrupt context when a buffer has been hashed. */
+typedef void (*hash_dma_callback)(struct hash_dma *h);
+
+/** Called from interrupt context when a buffer has been processed. */
+typedef void (*crypto_dma_callback)(struct crypto_dma *c);
+
+/** DMA fed HASH processor. */
+struct hash_dma {
+	/** Optional completion callback */
+	hash_dma_callback callback;
+	/** Free for use by the callback */
+	void *user;
+	/** Set if a DMA error cut the message short */
+	bool error;
+
+	/* Private to the library */
+	uint32_t next;
+	uint32_t left;
+	uint8_t last_bits;
+	bool last;
+	volatile bool busy;
+	struct dma_xfer xfer;
+};
+
+/** DMA fed CRYP processor. */
+struct crypto_dma {
+	/** Optional completion callback */
+	crypto_dma_callback callback;
+	/** Free for use by the callback */
+	void *user;
+	/** Set if a DMA error cut the buffer short */
+	bool error;
+
+	/* Private to the library */
+	volatile bool busy;
+	struct dma_xfer in;
+	struct dma_xfer out;
+};
+
+BEGIN_DECLS
+
+bool hash_dma_init(struct hash_dma *h, uint32_t dma, uint8_t stream,
+		   uint8_t request);
+bool hash_dma_update(struct hash_dma *h, const void *data, uint32_t len,
+		     bool last);
+bool hash_dma_busy(const struct hash_dma *h);
+void hash_dma_wait(const struct hash_dma *h);
+void hash_dma_irq_handler(struct hash_dma *h);
+
+bool crypto_dma_init(struct crypto_dma *c, uint32_t dma,
+		     uint8_t in_stream, uint8_t in_request,
+		     uint8_t out_stream, uint8_t out_request);
+bool crypto_process_block_dma(struct crypto_dma *c, const uint32_t *inp,
+			      uint32_t *outp, uint16_t length);
+bool crypto_dma_busy(const struct crypto_dma *c);
+void crypto_dma_wait(const struct crypto_dma *c);
+
+END_DECLS
+
+/**@}*/
+
+#endif
@@ -724,6 +724,37 @@ struct fdcan_tx_buffer_element {
 #define FDCAN_FIFO_RXTS_SHIFT			0
 #define FDCAN_FIFO_RXTS_MASK			0xFFFF
 
+#define FDCAN_FIFO_TXTS_SHIFT			0
+#define FDCAN_FIFO_TXTS_MASK			0xFFFF
+
+/** Structure describing one frame for batched transmit and receive.
+ * See @ref fdcan_transmit_batch and @ref fdcan_receive_batch.
+ */
+struct fdcan_frame {
+	/** Message ID */
+	uint32_t id;
+	/** Extended message ID */
+	bool ext;
+	/** Remote transmission request */
+	bool rtr;
+	/** FDCAN frame format */
+	bool fdcan_fmt;
+	/** Bitrate switch for data portion of frame */
+	bool btr_switch;
+	/** Transmit only: store transmit event tagged with marker */
+	bool event;
+	/** Transmit only: message marker copied into transmit event */
+	uint8_t marker;
+	/** Receive only: ID of the filter which matched this frame */
+	uint8_t fmi;
+	/** Payload length in bytes. Must be valid CAN or FDCAN frame length */
+	uint8_t length;
+	/** Receive only: timestamp of received frame */
+	uint16_t timestamp;
+	/** Message payload data */
+	uint8_t data[64];
+};
+
 
 /** @defgroup fdcan_error FDCAN error return values
  * @{
@@ -792,6 +823,13 @@ int fdcan_receive(uint32_t canport, uint8_t fifo, bool release, uint32_t *id,
 
 void fdcan_release_fifo(uint32_t canport, uint8_t fifo);
 
+int fdcan_transmit_batch(uint32_t canport, const struct fdcan_frame *frames,
+		unsigned count);
+int fdcan_receive_batch(uint32_t canport, uint8_t fifo_id,
+		struct fdcan_frame *frames, unsigned max);
+int fdcan_get_tx_event(uint32_t canport, uint32_t *id, bool *ext,
+		uint8_t *marker, uint16_t *timestamp);
+
 bool fdcan_available_tx(uint32_t canport);
 bool fdcan_available_rx(uint32_t canport, uint8_t fifo);
 
@@ -802,10 +840,12 @@ struct fdcan_extended_filter *fdcan_get_flesa_addr(uint32_t canport);
 struct fdcan_rx_fifo_element *fdcan_get_rxfifo_addr(uint32_t canport,
 		unsigned fifo_id, unsigned element_id);
 unsigned fdcan_get_fifo_element_size(uint32_t canport, unsigned fifo_id);
+unsigned fdcan_get_fifo_size(uint32_t canport, unsigned fifo_id);
 
 struct fdcan_tx_event_element *fdcan_get_txevt_addr(uint32_t canport);
 struct fdcan_tx_buffer_element *fdcan_get_txbuf_addr(uint32_t canport, unsigned element_id);
 unsigned fdcan_get_txbuf_element_size(uint32_t canport);
+unsigned fdcan_get_txbuf_count(uint32_t canport);
 void fdcan_set_fifo_locked_mode(uint32_t canport, bool locked);
 uint32_t fdcan_length_to_dlc(uint8_t length);
 uint8_t fdcan_dlc_to_length(uint32_t dlc);
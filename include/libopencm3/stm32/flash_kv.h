@@ -0,0 +1,103 @@
+/** @defgroup flash_kv_defines Flash key/value store Defines
+ *
+ * @ingroup STM32_defines
+ *
+ * @brief <b>Defined Constants and Types for the flash key/value store</b>
+ *
+ * A log structured store for configuration values and counters in internal
+ * flash. Updates are appended as records to a log that runs over a ring of
+ * two or more erase sectors, so an update costs a few program operations
+ * instead of a sector erase, and the sectors wear evenly. A RAM index with
+ * one entry per key gives constant time lookups.
+ *
+ * When the log reaches the last free sector, the oldest sector is compacted:
+ * its live records are copied to the head of the log and it is erased. An
+ * application can do this ahead of time from its idle loop with
+ * flash_kv_gc() so that flash_kv_set() never has to wait for an erase.
+ *
+ * Every record carries a CRC. After a reset during a write, erase or
+ * compaction, flash_kv_mount() rebuilds the index from the intact records;
+ * a torn update reads back as the previous value.
+ *
+ * Supported on the families with the F0/F1, F2/F4/F7 and L0/L1 flash
+ * controllers. The flash must be unlocked while the store is modified.
+ *
+ * LGPL License Terms @ref lgpl_license
+ */
+/*
+ * This file is part of the libopencm3 project.
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBOPENCM3_FLASH_KV_H
+#define LIBOPENCM3_FLASH_KV_H
+
+#include <libopencm3/stm32/flash.h>
+
+/**@{*/
+
+/** Largest value that can be stored under a key */
+#define FLASH_KV_MAX_LEN	0xfff0
+
+/** One erase unit of the store. */
+struct flash_kv_sector {
+	/** Start address, 8 byte aligned */
+	uint32_t address;
+	/** Size in bytes, a multiple of 8 */
+	uint32_t size;
+	/** F2/F4/F7: sector number for flash_erase_sector().
+	 * Other families: erase page size in bytes. */
+	uint32_t erase;
+};
+
+/** Key/value store state. */
+struct flash_kv {
+	/** Sectors of the ring, at least two */
+	const struct flash_kv_sector *sectors;
+	/** Number of sectors */
+	uint8_t nsectors;
+	/** Index storage, one entry per key */
+	uint32_t *index;
+	/** Number of keys, keys range from 0 to keys - 1 */
+	uint16_t keys;
+	/** F2/F4/F7: programming size, @ref flash_cr_program_width */
+	uint32_t program_size;
+
+	/* Private to the library */
+	uint32_t seq;
+	uint32_t write;
+	uint8_t oldest;
+	uint8_t used;
+	bool compacting;
+};
+
+BEGIN_DECLS
+
+bool flash_kv_mount(struct flash_kv *kv);
+bool flash_kv_format(struct flash_kv *kv);
+const void *flash_kv_find(const struct flash_kv *kv, uint16_t key,
+			  uint16_t *len);
+int32_t flash_kv_get(const struct flash_kv *kv, uint16_t key,
+		     void *buf, uint16_t size);
+bool flash_kv_set(struct flash_kv *kv, uint16_t key,
+		  const void *data, uint16_t len);
+bool flash_kv_delete(struct flash_kv *kv, uint16_t key);
+bool flash_kv_gc(struct flash_kv *kv);
+
+END_DECLS
+
+/**@}*/
+
+#endif
@@ -52,3 +52,4 @@
 #       error "stm32 family not defined."
 #endif
 
+#include <libopencm3/stm32/common/gpio_common_all_inline.h>
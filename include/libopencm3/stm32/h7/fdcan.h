@@ -246,6 +246,7 @@ BEGIN_DECLS
 void fdcan_init_std_filter_ram(uint32_t canport, uint32_t flssa, uint8_t lss);
 void fdcan_init_ext_filter_ram(uint32_t canport, uint32_t flesa, uint8_t lse);
 void fdcan_init_fifo_ram(uint32_t canport, unsigned fifo_id, uint32_t fxsa, uint8_t fxs);
+void fdcan_set_rx_watermark(uint32_t canport, unsigned fifo_id, uint8_t level);
 void fdcan_init_tx_event_ram(uint32_t canport, uint32_t tesa, uint8_t tes);
 void fdcan_init_tx_buffer_ram(uint32_t canport, uint32_t tbsa, uint8_t tbs);
 int fdcan_set_rx_element_size(uint32_t canport, uint8_t rxbuf, uint8_t rxfifo0, uint8_t rxfifo1);
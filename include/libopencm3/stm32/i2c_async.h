@@ -0,0 +1,145 @@
+/** @defgroup i2c_async_defines I2C transaction engine Defines
+ *
+ * @ingroup STM32_defines
+ *
+ * @brief <b>Defined Constants and Types for interrupt driven I2C transactions</b>
+ *
+ * Transactions are queued on a bus and run back to back from the I2C event
+ * and error interrupts. Each one is a write, a read, or a write followed by
+ * a repeated start and a read, of any length: transfers of more than 255
+ * bytes are split with the RELOAD mechanism without releasing the bus.
+ *
+ * Only the I2C peripheral found on the F0, F3, F7, G0, G4, L0, L4 and U5
+ * is supported. On parts with the DMA transfer API the data phases can
+ * optionally be moved by DMA, leaving only a few interrupts per transaction.
+ *
+ * LGPL License Terms @ref lgpl_license
+ */
+/*
+ * This file is part of the libopencm3 project.
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBOPENCM3_I2C_ASYNC_H
+#define LIBOPENCM3_I2C_ASYNC_H
+
+#include <stddef.h>
+#include <libopencm3/stm32/i2c.h>
+#if !defined(STM32U5)
+/* The U5 GPDMA is not supported by the DMA transfer API yet */
+#include <libopencm3/stm32/dma.h>
+#endif
+
+/**@{*/
+
+/** Outcome of a transaction */
+enum i2c_transaction_status {
+	/** Queued or in progress */
+	I2C_TRANSACTION_PENDING,
+	/** Completed */
+	I2C_TRANSACTION_OK,
+	/** Address or data byte not acknowledged */
+	I2C_TRANSACTION_NACK,
+	/** Arbitration lost to another master */
+	I2C_TRANSACTION_ARLO,
+	/** Misplaced START/STOP, overrun, or a DMA error */
+	I2C_TRANSACTION_BUS_ERROR,
+	/** Timed out, the bus has been reset */
+	I2C_TRANSACTION_TIMEOUT,
+};
+
+struct i2c_transaction;
+struct i2c_bus;
+
+/** Called from interrupt context when a transaction has finished. */
+typedef void (*i2c_transaction_callback)(struct i2c_transaction *t);
+
+/** Called with the peripheral disabled to free a stuck bus, typically by
+ * switching SCL to a GPIO and clocking it until the slave releases SDA. */
+typedef void (*i2c_bus_recover_callback)(struct i2c_bus *bus);
+
+/** One addressed exchange. */
+struct i2c_transaction {
+	/** 7 bit slave address */
+	uint8_t addr;
+	/** Bytes to write, may be NULL if @ref wn is 0 */
+	const uint8_t *w;
+	/** Number of bytes to write */
+	size_t wn;
+	/** Buffer for read bytes, may be NULL if @ref rn is 0 */
+	uint8_t *r;
+	/** Number of bytes to read after a repeated start */
+	size_t rn;
+	/** Timeout in i2c_bus_tick() periods, 0 waits forever */
+	uint16_t timeout;
+	/** Optional completion callback */
+	i2c_transaction_callback callback;
+	/** Free for use by the callback */
+	void *user;
+
+	/* Filled in by the library */
+	/** Result, see @ref i2c_transaction_status */
+	volatile uint8_t status;
+	/** Queue link */
+	struct i2c_transaction *next;
+};
+
+/** I2C bus driven from interrupts. */
+struct i2c_bus {
+	/** I2C peripheral identifier @ref i2c_reg_base */
+	uint32_t i2c;
+	/** Transaction in progress, followed by the queued ones */
+	struct i2c_transaction *volatile head;
+	/** Last queued transaction */
+	struct i2c_transaction *tail;
+	/** Optional hook run by i2c_bus_recover() */
+	i2c_bus_recover_callback recover;
+	/** Free for use by the recover hook */
+	void *user;
+
+	/* Private to the library */
+	size_t pos;
+	size_t pending;
+	volatile uint16_t ticks;
+	uint8_t phase;
+	uint8_t result;
+#if defined(LIBOPENCM3_DMA_XFER_COMMON_ALL_H)
+	bool use_dma;
+	bool dma_phase;
+	struct dma_xfer rx_xfer;
+	struct dma_xfer tx_xfer;
+#endif
+};
+
+BEGIN_DECLS
+
+void i2c_bus_init(struct i2c_bus *bus, uint32_t i2c);
+#if defined(LIBOPENCM3_DMA_XFER_COMMON_ALL_H)
+bool i2c_bus_enable_dma(struct i2c_bus *bus, uint32_t dma,
+			uint8_t rx_channel, uint8_t rx_request,
+			uint8_t tx_channel, uint8_t tx_request);
+#endif
+void i2c_transfer_async(struct i2c_bus *bus, struct i2c_transaction *t);
+void i2c_bus_irq_handler(struct i2c_bus *bus);
+void i2c_bus_tick(struct i2c_bus *bus);
+bool i2c_bus_busy(const struct i2c_bus *bus);
+void i2c_bus_wait(const struct i2c_bus *bus);
+void i2c_bus_recover(struct i2c_bus *bus);
+
+END_DECLS
+
+/**@}*/
+
+#endif
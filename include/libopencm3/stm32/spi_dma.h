@@ -0,0 +1,104 @@
+/** @defgroup spi_dma_defines SPI DMA transaction Defines
+ *
+ * @ingroup STM32_defines
+ *
+ * @brief <b>Defined Constants and Types for DMA driven SPI transactions</b>
+ *
+ * Transactions are queued on a bus and run back to back by a pair of DMA
+ * streams/channels, one for each direction. A transaction without transmit
+ * data clocks out all ones, one without a receive buffer discards what
+ * comes in. An optional GPIO chip select is asserted for the duration of
+ * the transaction, or across several of them.
+ *
+ * LGPL License Terms @ref lgpl_license
+ */
+/*
+ * This file is part of the libopencm3 project.
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBOPENCM3_SPI_DMA_H
+#define LIBOPENCM3_SPI_DMA_H
+
+#include <libopencm3/stm32/dma.h>
+#include <libopencm3/stm32/spi.h>
+
+/**@{*/
+
+struct spi_transaction;
+
+/** Called from interrupt context when a transaction has finished, see
+ * spi_transfer_async() for those without frames. */
+typedef void (*spi_transaction_callback)(struct spi_transaction *t);
+
+/** One chip select framed exchange. */
+struct spi_transaction {
+	/** Frames to send, NULL to send all ones */
+	const void *tx;
+	/** Buffer for received frames, NULL to discard them */
+	void *rx;
+	/** Number of frames, 0 to only drive the chip select */
+	uint16_t len;
+	/** Chip select GPIO port, 0 when the transaction has none */
+	uint32_t cs_port;
+	/** Chip select GPIO pin, driven low while selected */
+	uint16_t cs_gpio;
+	/** Leave the chip selected for the following transaction */
+	bool cs_hold;
+	/** Optional completion callback */
+	spi_transaction_callback callback;
+	/** Free for use by the callback */
+	void *user;
+
+	/* Filled in by the library */
+	/** Set if a DMA error aborted the transaction, or the SPI did not
+	 * finish the last frame */
+	bool error;
+	/** Queue link */
+	struct spi_transaction *next;
+};
+
+/** SPI bus driven by DMA. */
+struct spi_dma {
+	/** SPI peripheral identifier @ref spi_reg_base */
+	uint32_t spi;
+	/** Transaction in progress, followed by the queued ones */
+	struct spi_transaction *volatile head;
+	/** Last queued transaction */
+	struct spi_transaction *tail;
+	/** Source of the all ones frames sent for transactions without tx */
+	uint16_t dummy_tx;
+	/** Sink for frames received by transactions without rx */
+	uint16_t discard_rx;
+	/** Receive direction DMA */
+	struct dma_xfer rx_xfer;
+	/** Transmit direction DMA */
+	struct dma_xfer tx_xfer;
+};
+
+BEGIN_DECLS
+
+bool spi_dma_init(struct spi_dma *bus, uint32_t spi, uint32_t dma,
+		  uint8_t rx_channel, uint8_t rx_request,
+		  uint8_t tx_channel, uint8_t tx_request);
+void spi_transfer_async(struct spi_dma *bus, struct spi_transaction *t);
+bool spi_dma_busy(const struct spi_dma *bus);
+void spi_dma_wait(const struct spi_dma *bus);
+
+END_DECLS
+
+/**@}*/
+
+#endif
@@ -0,0 +1,133 @@
+/** @defgroup usart_dma_defines USART DMA streaming Defines
+ *
+ * @ingroup STM32_defines
+ *
+ * @brief <b>Defined Constants and Types for DMA driven USART streams</b>
+ *
+ * The receive side runs a DMA channel in circular mode into a caller
+ * supplied ring buffer. The write index is published from the half and full
+ * transfer interrupts of the DMA and from the USART idle line interrupt, so
+ * a burst costs a handful of interrupts regardless of its length. Consumers
+ * read contiguous spans straight out of the ring.
+ *
+ * The transmit side coalesces small writes into a ring that is drained
+ * without blocking the caller, either by DMA in contiguous chunks or by the
+ * transmit interrupt. On parts with USART FIFOs the interrupt is the FIFO
+ * threshold interrupt, so each interrupt moves several characters.
+ *
+ * LGPL License Terms @ref lgpl_license
+ */
+/*
+ * This file is part of the libopencm3 project.
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBOPENCM3_USART_DMA_H
+#define LIBOPENCM3_USART_DMA_H
+
+#include <libopencm3/stm32/dma.h>
+#include <libopencm3/stm32/usart.h>
+#include <libopencm3/cm3/txq.h>
+
+/**@{*/
+
+struct usart_rx_dma;
+
+/** Called from interrupt context when new data has been published. */
+typedef void (*usart_rx_dma_callback)(struct usart_rx_dma *rx);
+
+/** Circular DMA receive ring.
+ *
+ * The DMA owns @ref head, the consumer owns @ref tail. The ring is empty
+ * when both are equal; data that overtakes the consumer is counted in
+ * @ref overruns and the oldest bytes are lost: @ref tail is moved on so that
+ * the ring holds the newest size - 1 bytes.
+ */
+struct usart_rx_dma {
+	/** USART block register address base */
+	uint32_t usart;
+	/** Ring storage */
+	uint8_t *buf;
+	/** Ring size in bytes */
+	uint16_t size;
+	/** Write index, updated from interrupt context */
+	volatile uint16_t head;
+	/** Read index, updated by usart_rx_dma_consume() */
+	volatile uint16_t tail;
+	/** Number of times received data overtook the consumer */
+	volatile uint32_t overruns;
+	/** Optional data available callback */
+	usart_rx_dma_callback callback;
+	/** Free for use by the callback */
+	void *user;
+	/** DMA transfer backing the ring */
+	struct dma_xfer xfer;
+};
+
+struct usart_txq;
+
+/** Called from interrupt context once the queue has drained and the last
+ * character has left the shift register. */
+typedef void (*usart_txq_callback)(struct usart_txq *q);
+
+/** Transmit queue. */
+struct usart_txq {
+	/** USART block register address base */
+	uint32_t usart;
+	/** Queued bytes */
+	struct txq ring;
+	/** Set from the first queued byte until the transmitter is idle */
+	volatile bool active;
+	/** Drain by DMA instead of the transmit interrupt */
+	bool use_dma;
+	/** Length of the chunk currently owned by the DMA */
+	uint16_t dma_len;
+	/** Optional drained callback */
+	usart_txq_callback callback;
+	/** Free for use by the callback */
+	void *user;
+	/** DMA transfer used when @ref use_dma is set */
+	struct dma_xfer xfer;
+};
+
+BEGIN_DECLS
+
+bool usart_rx_dma_start(struct usart_rx_dma *rx, uint32_t usart,
+			uint32_t dma, uint8_t channel, uint8_t request,
+			uint8_t *buf, uint16_t size);
+void usart_rx_dma_stop(struct usart_rx_dma *rx);
+void usart_rx_dma_irq_handler(struct usart_rx_dma *rx);
+void usart_rx_dma_poll(struct usart_rx_dma *rx);
+uint16_t usart_rx_dma_available(const struct usart_rx_dma *rx);
+uint16_t usart_rx_dma_peek(const struct usart_rx_dma *rx,
+			   const uint8_t **data);
+void usart_rx_dma_consume(struct usart_rx_dma *rx, uint16_t len);
+
+void usart_txq_init(struct usart_txq *q, uint32_t usart,
+		    uint8_t *buf, uint16_t size);
+bool usart_txq_enable_dma(struct usart_txq *q, uint32_t dma,
+			  uint8_t channel, uint8_t request);
+uint16_t usart_txq_write(struct usart_txq *q, const void *data,
+			 uint16_t len);
+uint16_t usart_txq_space(const struct usart_txq *q);
+bool usart_txq_busy(const struct usart_txq *q);
+void usart_txq_flush(struct usart_txq *q);
+void usart_txq_irq_handler(struct usart_txq *q);
+
+END_DECLS
+
+/**@}*/
+
+#endif
@@ -0,0 +1,245 @@
+/** @defgroup CM3_executor_file Executor
+ *
+ * @ingroup CM3_files
+ *
+ * @brief <b>libopencm3 PendSV deferred work executor</b>
+ *
+ * Work items are pushed onto per class intrusive stacks with LDREX/STREX on
+ * ARMv7-M, or with interrupts briefly masked on ARMv6-M. The PendSV handler
+ * detaches a whole stack at once, restores posting (or deadline) order and
+ * runs it, then starts over from the most urgent class.
+ *
+ * This file provides pend_sv_handler(), so it cannot be combined with an
+ * RTOS that uses PendSV for context switching.
+ *
+ * LGPL License Terms @ref lgpl_license
+ */
+/*
+ * This file is part of the libopencm3 project.
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**@{*/
+
+#include <libopencm3/cm3/cortex.h>
+#include <libopencm3/cm3/executor.h>
+#include <libopencm3/cm3/nvic.h>
+#include <libopencm3/cm3/scb.h>
+#include <libopencm3/cm3/sync.h>
+
+static struct executor_work *volatile executor_queue[EXECUTOR_CLASSES];
+static uint32_t executor_deadline_classes;
+
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__)
+
+static bool executor_claim(struct executor_work *work)
+{
+	do {
+		if (__ldrex(&work->queued)) {
+			return false;
+		}
+	} while (__strex(1, &work->queued));
+	return true;
+}
+
+static void executor_push(struct executor_work *work, uint8_t cls)
+{
+	volatile uint32_t *head = (volatile uint32_t *)&executor_queue[cls];
+
+	do {
+		work->next = (struct executor_work *)__ldrex(head);
+	} while (__strex((uint32_t)work, head));
+}
+
+static struct executor_work *executor_take(uint8_t cls)
+{
+	volatile uint32_t *head = (volatile uint32_t *)&executor_queue[cls];
+	uint32_t list;
+
+	do {
+		list = __ldrex(head);
+	} while (list && __strex(0, head));
+	return (struct executor_work *)list;
+}
+
+#else
+
+static bool executor_claim(struct executor_work *work)
+{
+	bool claimed = false;
+
+	CM_ATOMIC_BLOCK() {
+		if (!work->queued) {
+			work->queued = 1;
+			claimed = true;
+		}
+	}
+	return claimed;
+}
+
+static void executor_push(struct executor_work *work, uint8_t cls)
+{
+	CM_ATOMIC_BLOCK() {
+		work->next = executor_queue[cls];
+		executor_queue[cls] = work;
+	}
+}
+
+static struct executor_work *executor_take(uint8_t cls)
+{
+	struct executor_work *list;
+
+	CM_ATOMIC_BLOCK() {
+		list = executor_queue[cls];
+		executor_queue[cls] = NULL;
+	}
+	return list;
+}
+
+#endif
+
+/* Queues are LIFO, turn a detached list back into posting order */
+static struct executor_work *executor_reverse(struct executor_work *list)
+{
+	struct executor_work *out = NULL;
+
+	while (list) {
+		struct executor_work *next = list->next;
+		list->next = out;
+		out = list;
+		list = next;
+	}
+	return out;
+}
+
+/* Stable insertion sort by deadline, wrap-around safe */
+static struct executor_work *executor_sort(struct executor_work *list)
+{
+	struct executor_work *out = NULL;
+
+	list = executor_reverse(list);
+	while (list) {
+		struct executor_work *work = list;
+		struct executor_work **pos = &out;
+
+		list = work->next;
+		while (*pos && (int32_t)(work->deadline - (*pos)->deadline) >= 0) {
+			pos = &(*pos)->next;
+		}
+		work->next = *pos;
+		*pos = work;
+	}
+	return out;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Set up the executor.
+ *
+ * Gives PendSV the lowest priority, so deferred work never delays an
+ * interrupt handler.
+ *
+ * @param[in] deadline_classes Bitmask of the classes to run in deadline order
+ */
+void executor_init(uint32_t deadline_classes)
+{
+	executor_deadline_classes = deadline_classes;
+	nvic_set_priority(NVIC_PENDSV_IRQ, 0xff);
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Queue a work item.
+ *
+ * Safe to call from any interrupt handler and from thread mode.
+ *
+ * @param[in] work Work item, must stay valid until it has run
+ * @param[in] cls Priority class, 0 is the most urgent
+ * @returns true if queued, false if it was already queued
+ */
+bool executor_post(struct executor_work *work, uint8_t cls)
+{
+	if (cls >= EXECUTOR_CLASSES || !executor_claim(work)) {
+		return false;
+	}
+
+	executor_push(work, cls);
+	SCB_ICSR = SCB_ICSR_PENDSVSET;
+	return true;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Queue a work item with a deadline.
+ *
+ * The deadline is only used to order classes selected in executor_init().
+ *
+ * @param[in] work Work item, must stay valid until it has run
+ * @param[in] cls Priority class, 0 is the most urgent
+ * @param[in] deadline Deadline, items with earlier deadlines run first
+ * @returns true if queued, false if it was already queued
+ */
+bool executor_post_deadline(struct executor_work *work, uint8_t cls,
+			    uint32_t deadline)
+{
+	if (cls >= EXECUTOR_CLASSES || !executor_claim(work)) {
+		return false;
+	}
+
+	work->deadline = deadline;
+	executor_push(work, cls);
+	SCB_ICSR = SCB_ICSR_PENDSVSET;
+	return true;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Run all queued work.
+ *
+ * Called from the PendSV handler. A batch taken from one class always runs
+ * to completion, after which the most urgent non-empty class is taken next.
+ */
+void executor_run(void)
+{
+	uint8_t cls = 0;
+
+	while (cls < EXECUTOR_CLASSES) {
+		struct executor_work *list = executor_take(cls);
+
+		if (!list) {
+			cls++;
+			continue;
+		}
+
+		if (executor_deadline_classes & (1 << cls)) {
+			list = executor_sort(list);
+		} else {
+			list = executor_reverse(list);
+		}
+
+		while (list) {
+			struct executor_work *work = list;
+
+			list = work->next;
+			__dmb();
+			work->queued = 0;
+			work->fn(work->arg);
+		}
+		cls = 0;
+	}
+}
+
+void pend_sv_handler(void)
+{
+	executor_run();
+}
+
+/**@}*/
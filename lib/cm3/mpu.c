@@ -0,0 +1,112 @@
+/** @defgroup CM3_mpu_file MPU
+ *
+ * @ingroup CM3_files
+ *
+ * @brief <b>libopencm3 Cortex-M Memory Protection Unit</b>
+ *
+ * Helpers to set up MPU regions. On the Cortex-M7 the region attributes also
+ * select the cache policy, which is how DMA buffers are kept coherent without
+ * cache maintenance: place them in a region set up with mpu_set_dma_region().
+ *
+ * LGPL License Terms @ref lgpl_license
+ * @{
+ */
+/*
+ * This file is part of the libopencm3 project.
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <libopencm3/cm3/mpu.h>
+#include <libopencm3/cm3/sync.h>
+
+/** @brief Enable the MPU.
+ *
+ * @param[in] ctrl Extra @ref CM3_mpu_ctrl bits, usually MPU_CTRL_PRIVDEFENA
+ */
+void mpu_enable(uint32_t ctrl)
+{
+	MPU_CTRL = ctrl | MPU_CTRL_ENABLE;
+	__dsb();
+	__isb();
+}
+
+/** @brief Disable the MPU. */
+void mpu_disable(void)
+{
+	__dmb();
+	MPU_CTRL = 0;
+	__dsb();
+	__isb();
+}
+
+/** @brief Configure and enable an MPU region.
+ *
+ * @param[in] region Region number
+ * @param[in] base Base address, aligned to @p size
+ * @param[in] size Region size in bytes, a power of two of at least 32
+ * @param[in] attrs RASR attributes (@ref mpu_rasr_attributes and
+ * @ref mpu_rasr_memtypes)
+ */
+void mpu_set_region(uint8_t region, uint32_t base, uint32_t size,
+		    uint32_t attrs)
+{
+	/* SIZE encodes 2^(SIZE + 1) bytes */
+	uint32_t size_field = 30 - __builtin_clz(size);
+
+	__dmb();
+	MPU_RNR = region;
+	MPU_RBAR = base & MPU_RBAR_ADDR;
+	MPU_RASR = (attrs & ~(MPU_RASR_SIZE | MPU_RASR_ENABLE)) |
+		   (size_field << MPU_RASR_SIZE_LSB) | MPU_RASR_ENABLE;
+	__dsb();
+	__isb();
+}
+
+/** @brief Disable an MPU region.
+ *
+ * @param[in] region Region number
+ */
+void mpu_disable_region(uint8_t region)
+{
+	__dmb();
+	MPU_RNR = region;
+	MPU_RASR = 0;
+	__dsb();
+	__isb();
+}
+
+/** @brief Set up a region for DMA buffers.
+ *
+ * The region is read/write, never executable and either non-cacheable or
+ * write-through. Write-through keeps CPU reads cached, but the CPU must
+ * still invalidate the D-cache after the DMA wrote to the buffer.
+ *
+ * @param[in] region Region number
+ * @param[in] base Base address, aligned to @p size
+ * @param[in] size Region size in bytes, a power of two of at least 32
+ * @param[in] write_through Use write-through instead of non-cacheable
+ */
+void mpu_set_dma_region(uint8_t region, uint32_t base, uint32_t size,
+			bool write_through)
+{
+	uint32_t type = write_through ? MPU_RASR_ATTR_NORMAL_WT :
+					MPU_RASR_ATTR_NORMAL_NC;
+
+	/* Not shareable: the Cortex-M7 does not cache shareable memory */
+	mpu_set_region(region, base, size, MPU_RASR_ATTR_XN |
+		       MPU_RASR_ATTR_AP_PRW_URW | type);
+}
+
+/**@}*/
@@ -40,6 +40,7 @@
 #include <stdlib.h>
 
 #include <libopencm3/cm3/scb.h>
+#include <libopencm3/cm3/sync.h>
 
 /* Those are defined only on CM3 or CM4 */
 #if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__)
@@ -86,4 +87,262 @@ void scb_set_priority_grouping(uint32_t prigroup)
 }
 #endif
 
+/* Cache and TCM control, only implemented on the Cortex-M7 */
+#if defined(__ARM_ARCH_7EM__) && (defined(STM32F7) || defined(STM32H7))
+
+/* Apply a set/way maintenance operation to every line of the L1 D-cache */
+static void scb_dcache_setway_all(volatile uint32_t *op)
+{
+	uint32_t ccsidr, sets, ways, set_shift, way_shift, set, way;
+
+	SCB_CCSELR = 0;
+	__dsb();
+	ccsidr = SCB_CCSIDR;
+
+	sets = (ccsidr >> SCB_CCSIDR_NUMSETS_SHIFT) & SCB_CCSIDR_NUMSETS_MASK;
+	ways = (ccsidr >> SCB_CCSIDR_ASSOCIATIVITY_SHIFT) &
+		SCB_CCSIDR_ASSOCIATIVITY_MASK;
+	set_shift = ((ccsidr >> SCB_CCSIDR_LINESIZE_SHIFT) &
+		     SCB_CCSIDR_LINESIZE_MASK) + 4;
+	/* The way number is left aligned in the register */
+	way_shift = ways ? __builtin_clz(ways) : 0;
+
+	set = sets;
+	do {
+		way = ways;
+		do {
+			*op = (way << way_shift) | (set << set_shift);
+		} while (way-- != 0);
+	} while (set-- != 0);
+
+	__dsb();
+	__isb();
+}
+
+/* Apply a by-address maintenance operation to every line covering a range */
+static void scb_cache_op_range(volatile uint32_t *op, uint32_t line,
+			       const void *addr, size_t len)
+{
+	uint32_t start = (uint32_t)addr & ~(line - 1);
+	uint32_t end = (uint32_t)addr + len;
+
+	__dsb();
+	for (; start < end; start += line) {
+		*op = start;
+	}
+	__dsb();
+	__isb();
+}
+
+/** @brief Invalidate and enable the L1 instruction cache. */
+void scb_enable_icache(void)
+{
+	if (SCB_CCR & SCB_CCR_IC) {
+		return;
+	}
+
+	__dsb();
+	__isb();
+	SCB_ICIALLU = 0;
+	__dsb();
+	__isb();
+	SCB_CCR |= SCB_CCR_IC;
+	__dsb();
+	__isb();
+}
+
+/** @brief Disable and invalidate the L1 instruction cache. */
+void scb_disable_icache(void)
+{
+	__dsb();
+	__isb();
+	SCB_CCR &= ~SCB_CCR_IC;
+	SCB_ICIALLU = 0;
+	__dsb();
+	__isb();
+}
+
+/** @brief Invalidate the whole L1 instruction cache. */
+void scb_invalidate_icache(void)
+{
+	__dsb();
+	__isb();
+	SCB_ICIALLU = 0;
+	__dsb();
+	__isb();
+}
+
+/** @brief Invalidate the instruction cache lines covering a memory range.
+ *
+ * Needed after writing code to RAM, once the D-cache has been cleaned.
+ *
+ * @param[in] addr Start of the range
+ * @param[in] len Length of the range in bytes
+ */
+void scb_invalidate_icache_range(const void *addr, size_t len)
+{
+	uint32_t line = 4 << ((SCB_CTR >> SCB_CTR_IMINLINE_SHIFT) &
+			      SCB_CTR_IMINLINE_MASK);
+
+	scb_cache_op_range(&SCB_ICIMVAU, line, addr, len);
+}
+
+/** @brief Invalidate and enable the L1 data cache. */
+void scb_enable_dcache(void)
+{
+	if (SCB_CCR & SCB_CCR_DC) {
+		return;
+	}
+
+	scb_dcache_setway_all(&SCB_DCISW);
+	SCB_CCR |= SCB_CCR_DC;
+	__dsb();
+	__isb();
+}
+
+/** @brief Disable the L1 data cache, writing back any dirty lines. */
+void scb_disable_dcache(void)
+{
+	/* Once the cache is off, stack accesses go straight to memory: no
+	 * dirty line may be left to be written back over them later. Nothing
+	 * is stored between the clean and the disable, so the second pass
+	 * only has clean lines to invalidate. */
+	scb_dcache_setway_all(&SCB_DCCSW);
+	SCB_CCR &= ~SCB_CCR_DC;
+	__dsb();
+	__isb();
+	scb_dcache_setway_all(&SCB_DCCISW);
+}
+
+/** @brief Invalidate the whole L1 data cache, discarding dirty lines. */
+void scb_invalidate_dcache(void)
+{
+	scb_dcache_setway_all(&SCB_DCISW);
+}
+
+/** @brief Write back all dirty lines of the L1 data cache. */
+void scb_clean_dcache(void)
+{
+	scb_dcache_setway_all(&SCB_DCCSW);
+}
+
+/** @brief Write back and invalidate the whole L1 data cache. */
+void scb_clean_invalidate_dcache(void)
+{
+	scb_dcache_setway_all(&SCB_DCCISW);
+}
+
+/** @brief Get the L1 data cache line size.
+ *
+ * Buffers handed to DMA should be aligned to, and sized in multiples of,
+ * this value so maintenance operations do not touch unrelated data.
+ *
+ * @returns Line size in bytes
+ */
+uint32_t scb_get_dcache_line_size(void)
+{
+	return 4 << ((SCB_CTR >> SCB_CTR_DMINLINE_SHIFT) &
+		     SCB_CTR_DMINLINE_MASK);
+}
+
+/** @brief Invalidate the data cache lines covering a memory range.
+ *
+ * Call after a DMA transfer into memory, before the CPU reads the data.
+ * Lines only partially covered by the range are invalidated as a whole.
+ *
+ * @param[in] addr Start of the range
+ * @param[in] len Length of the range in bytes
+ */
+void scb_invalidate_dcache_range(const void *addr, size_t len)
+{
+	scb_cache_op_range(&SCB_DCIMVAC, scb_get_dcache_line_size(), addr, len);
+}
+
+/** @brief Write back the data cache lines covering a memory range.
+ *
+ * Call before starting a DMA transfer out of memory.
+ *
+ * @param[in] addr Start of the range
+ * @param[in] len Length of the range in bytes
+ */
+void scb_clean_dcache_range(const void *addr, size_t len)
+{
+	scb_cache_op_range(&SCB_DCCMVAC, scb_get_dcache_line_size(), addr, len);
+}
+
+/** @brief Write back and invalidate the data cache lines covering a range.
+ *
+ * @param[in] addr Start of the range
+ * @param[in] len Length of the range in bytes
+ */
+void scb_clean_invalidate_dcache_range(const void *addr, size_t len)
+{
+	scb_cache_op_range(&SCB_DCCIMVAC, scb_get_dcache_line_size(), addr, len);
+}
+
+static uint32_t scb_tcm_size(uint32_t tcmcr)
+{
+	uint32_t sz = (tcmcr >> SCB_TCMCR_SZ_SHIFT) & SCB_TCMCR_SZ_MASK;
+
+	return sz ? 1 << (sz + 9) : 0;
+}
+
+/** @brief Enable the instruction TCM. */
+void scb_enable_itcm(void)
+{
+	__dsb();
+	__isb();
+	SCB_ITCMCR |= SCB_TCMCR_EN | SCB_TCMCR_RMW | SCB_TCMCR_RETEN;
+	__dsb();
+	__isb();
+}
+
+/** @brief Disable the instruction TCM. */
+void scb_disable_itcm(void)
+{
+	__dsb();
+	__isb();
+	SCB_ITCMCR &= ~SCB_TCMCR_EN;
+	__dsb();
+	__isb();
+}
+
+/** @brief Enable the data TCM. */
+void scb_enable_dtcm(void)
+{
+	__dsb();
+	__isb();
+	SCB_DTCMCR |= SCB_TCMCR_EN | SCB_TCMCR_RMW | SCB_TCMCR_RETEN;
+	__dsb();
+	__isb();
+}
+
+/** @brief Disable the data TCM. */
+void scb_disable_dtcm(void)
+{
+	__dsb();
+	__isb();
+	SCB_DTCMCR &= ~SCB_TCMCR_EN;
+	__dsb();
+	__isb();
+}
+
+/** @brief Get the size of the instruction TCM.
+ * @returns Size in bytes, 0 if not implemented
+ */
+uint32_t scb_get_itcm_size(void)
+{
+	return scb_tcm_size(SCB_ITCMCR);
+}
+
+/** @brief Get the size of the data TCM.
+ * @returns Size in bytes, 0 if not implemented
+ */
+uint32_t scb_get_dtcm_size(void)
+{
+	return scb_tcm_size(SCB_DTCMCR);
+}
+
+#endif
+
 /**@}*/
\ No newline at end of file
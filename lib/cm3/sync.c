@@ -25,6 +25,16 @@ void __dmb()
 	__asm__ volatile ("dmb");
 }
 
+void __dsb()
+{
+	__asm__ volatile ("dsb" : : : "memory");
+}
+
+void __isb()
+{
+	__asm__ volatile ("isb" : : : "memory");
+}
+
 /* Those are defined only on CM3 or CM4 */
 #if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__)
 
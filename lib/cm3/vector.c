@@ -59,20 +59,64 @@ vector_table_t vector_table = {
 	}
 };
 
-void __attribute__((weak, used)) reset_handler(void)
-{
-	volatile unsigned *src, *dest;
-	funcp_t *fp;
+/*
+ * The startup code runs before .data/.bss are set up, so its loops must not
+ * be turned into calls to memcpy()/memset() from a C library.
+ */
+#define STARTUP_CODE __attribute__((optimize("no-tree-loop-distribute-patterns")))
 
-	for (src = &_data_loadaddr, dest = &_data;
-		dest < &_edata;
-		src++, dest++) {
-		*dest = *src;
+static STARTUP_CODE void
+init_copy_region(const uint32_t *src, uint32_t *dest, uint32_t *end)
+{
+	/* Four words per iteration so the compiler can use ldm/stm */
+	while (end - dest >= 4) {
+		uint32_t a = src[0], b = src[1], c = src[2], d = src[3];
+		dest[0] = a;
+		dest[1] = b;
+		dest[2] = c;
+		dest[3] = d;
+		src += 4;
+		dest += 4;
+	}
+	while (dest < end) {
+		*dest++ = *src++;
 	}
+}
 
-	while (dest < &_ebss) {
+static STARTUP_CODE void
+init_zero_region(uint32_t *dest, uint32_t *end)
+{
+	while (end - dest >= 4) {
+		dest[0] = 0;
+		dest[1] = 0;
+		dest[2] = 0;
+		dest[3] = 0;
+		dest += 4;
+	}
+	while (dest < end) {
 		*dest++ = 0;
 	}
+}
+
+void __attribute__((weak, used)) STARTUP_CODE reset_handler(void)
+{
+	const init_copy_region_t *copy;
+	const init_zero_region_t *zero;
+	funcp_t *fp;
+
+	if (__copy_table_start && __zero_table_start) {
+		for (copy = __copy_table_start; copy < __copy_table_end; copy++) {
+			init_copy_region(copy->load_addr, copy->start, copy->end);
+		}
+		for (zero = __zero_table_start; zero < __zero_table_end; zero++) {
+			init_zero_region(zero->start, zero->end);
+		}
+	} else {
+		/* Linker script without tables: only .data and .bss */
+		init_copy_region((const uint32_t *)&_data_loadaddr,
+				 (uint32_t *)&_data, (uint32_t *)&_edata);
+		init_zero_region((uint32_t *)&_edata, (uint32_t *)&_ebss);
+	}
 
 	/* Ensure 8-byte alignment of stack pointer on interrupts */
 	/* Enabled by default on most Cortex-M parts, but not M3 r1 */
@@ -36,12 +36,52 @@
 #include <libopencm3/ethernet/phy.h>
 #include <libopencm3/stm32/gpio.h>
 #include <libopencm3/cm3/nvic.h>
+#include <libopencm3/cm3/sync.h>
 
 /**@{*/
 
 uint32_t TxBD;
 uint32_t RxBD;
 
+/* Oldest transmit descriptor not reclaimed yet, in flight and ring count */
+static uint32_t TxDone;
+static uint32_t TxBusy;
+static uint32_t TxCount;
+static eth_tx_callback TxCallback;
+
+/* Checksum insertion of frames not overriding it */
+static uint32_t TxCic;
+
+/* Oldest receive descriptor lent to the application, lent and ring count */
+static uint32_t RxLent;
+static uint32_t RxHeld;
+static uint32_t RxCount;
+
+/*
+ * While frames are lent, the descriptors from RxLent up to RxBD all stay
+ * owned by software, and their DES0, which the DMA does not touch then,
+ * tells the lent ones from those only waiting to be given back.
+ */
+#define ETH_RX_LENT			ETH_RDES0_FS
+#define ETH_RX_DROPPED			0
+
+static struct eth_rx_stats RxStats;
+
+/* Address filter: users of each hash bin, and unicast/multicast users */
+static uint8_t HashRefs[64];
+static uint32_t HashUc;
+static uint32_t HashMc;
+
+/* Perfect filter address registers, the first one holds the station MAC */
+#define ETH_MAC_ADDRESSES		4
+
+/* Size of one descriptor, the buffer follows it in eth_desc_init() layout */
+static uint32_t eth_desc_size(void)
+{
+	return (ETH_DMABMR & ETH_DMABMR_EDFE) ? ETH_DES_EXT_SIZE :
+						ETH_DES_STD_SIZE;
+}
+
 /*---------------------------------------------------------------------------*/
 /** @brief Set MAC to the PHY
  *
@@ -55,6 +95,198 @@ void eth_set_mac(const uint8_t *mac)
 			((uint32_t)mac[1] << 8) | mac[0];
 }
 
+/* Reads the address in a perfect filter slot */
+static void eth_filter_read(uint32_t i, uint8_t *mac)
+{
+	uint32_t hi = ETH_MACAHR(i);
+	uint32_t lo = ETH_MACALR(i);
+
+	mac[0] = lo;
+	mac[1] = lo >> 8;
+	mac[2] = lo >> 16;
+	mac[3] = lo >> 24;
+	mac[4] = hi;
+	mac[5] = hi >> 8;
+}
+
+/* Hash table bin of an address: the CRC32 of the address, bit reversed,
+ * top 6 bits */
+static uint32_t eth_filter_hash(const uint8_t *mac)
+{
+	uint32_t crc = 0xFFFFFFFF;
+	uint32_t bin = 0;
+	int i, j;
+
+	for (i = 0; i < 6; i++) {
+		crc ^= mac[i];
+		for (j = 0; j < 8; j++) {
+			crc = (crc >> 1) ^ ((crc & 1) ? 0xEDB88320 : 0);
+		}
+	}
+
+	crc = ~crc;
+	for (i = 0; i < 6; i++) {
+		bin = (bin << 1) | ((crc >> i) & 1);
+	}
+
+	return bin;
+}
+
+/* Enables the hash filter for the address types it holds */
+static void eth_filter_update(void)
+{
+	uint32_t ffr = ETH_MACFFR & ~(ETH_MACFFR_HU | ETH_MACFFR_HM);
+
+	if (HashUc) {
+		ffr |= ETH_MACFFR_HU;
+	}
+	if (HashMc) {
+		ffr |= ETH_MACFFR_HM;
+	}
+	ETH_MACFFR = ffr;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Start address filtering
+ *
+ * eth_init() leaves the MAC receiving every frame. This function switches to
+ * filtering: frames are received if addressed to the station MAC, broadcast,
+ * or to one of the addresses added with eth_filter_add(). All the added
+ * addresses are removed.
+ */
+void eth_filter_init(void)
+{
+	uint32_t i;
+
+	for (i = 1; i < ETH_MAC_ADDRESSES; i++) {
+		ETH_MACAHR(i) = 0;
+		ETH_MACALR(i) = 0;
+	}
+	memset(HashRefs, 0, sizeof(HashRefs));
+	HashUc = 0;
+	HashMc = 0;
+	ETH_MACHTHR = 0;
+	ETH_MACHTLR = 0;
+
+	ETH_MACFFR = ETH_MACFFR_HPF;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Add an address to the filter
+ *
+ * The address goes into a free perfect filter slot. Once these run out,
+ * it goes into the 64 bin hash table, which also lets through the other
+ * addresses sharing its bin. An address added several times must be removed
+ * as many times.
+ *
+ * @param[in] mac uint8_t* Unicast or multicast address
+ */
+void eth_filter_add(const uint8_t *mac)
+{
+	uint32_t bin;
+	uint32_t i;
+
+	for (i = 1; i < ETH_MAC_ADDRESSES; i++) {
+		if (!(ETH_MACAHR(i) & ETH_MACAHR_AE)) {
+			/* The filter takes the address on the low write */
+			ETH_MACAHR(i) = ((uint32_t)mac[5] << 8) | mac[4] |
+					ETH_MACAHR_AE;
+			ETH_MACALR(i) = ((uint32_t)mac[3] << 24) |
+					((uint32_t)mac[2] << 16) |
+					((uint32_t)mac[1] << 8) | mac[0];
+			return;
+		}
+	}
+
+	bin = eth_filter_hash(mac);
+	if (!HashRefs[bin]++) {
+		if (bin & 32) {
+			ETH_MACHTHR |= 1 << (bin & 31);
+		} else {
+			ETH_MACHTLR |= 1 << (bin & 31);
+		}
+	}
+	if (mac[0] & 1) {
+		HashMc++;
+	} else {
+		HashUc++;
+	}
+	eth_filter_update();
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Remove an address from the filter
+ *
+ * @param[in] mac uint8_t* Address previously added with eth_filter_add()
+ * @returns bool true, if the address was in the filter
+ */
+bool eth_filter_remove(const uint8_t *mac)
+{
+	uint8_t slot[6];
+	uint32_t bin;
+	uint32_t i;
+
+	for (i = 1; i < ETH_MAC_ADDRESSES; i++) {
+		eth_filter_read(i, slot);
+		if ((ETH_MACAHR(i) & ETH_MACAHR_AE) && !memcmp(slot, mac, 6)) {
+			ETH_MACAHR(i) = 0;
+			ETH_MACALR(i) = 0;
+			return true;
+		}
+	}
+
+	bin = eth_filter_hash(mac);
+	if (!HashRefs[bin] || !((mac[0] & 1) ? HashMc : HashUc)) {
+		return false;
+	}
+
+	if (!--HashRefs[bin]) {
+		if (bin & 32) {
+			ETH_MACHTHR &= ~(1 << (bin & 31));
+		} else {
+			ETH_MACHTLR &= ~(1 << (bin & 31));
+		}
+	}
+	if (mac[0] & 1) {
+		HashMc--;
+	} else {
+		HashUc--;
+	}
+	eth_filter_update();
+
+	return true;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Receive all frames
+ *
+ * @param[in] enable bool true to receive all frames whatever their
+ * destination, false to apply the address filter
+ */
+void eth_set_promiscuous(bool enable)
+{
+	if (enable) {
+		ETH_MACFFR |= ETH_MACFFR_PM;
+	} else {
+		ETH_MACFFR &= ~(ETH_MACFFR_PM | ETH_MACFFR_RA);
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Receive all multicast frames
+ *
+ * @param[in] enable bool true to receive all multicast frames, false to
+ * only receive those to the addresses added with eth_filter_add()
+ */
+void eth_set_pass_all_multicast(bool enable)
+{
+	if (enable) {
+		ETH_MACFFR |= ETH_MACFFR_PAM;
+	} else {
+		ETH_MACFFR &= ~ETH_MACFFR_PAM;
+	}
+}
+
 /*---------------------------------------------------------------------------*/
 /** @brief Initialize buffers and descriptors.
  *
@@ -86,6 +318,7 @@ void eth_desc_init(uint8_t *buf, uint32_t nTx, uint32_t nRx, uint32_t cTx,
 	}
 
 	TxBD = bd;
+	TxCount = nTx;
 	while (--nTx > 0) {
 		ETH_DES0(bd) = ETH_TDES0_TCH;
 		ETH_DES2(bd) = bd + sz;
@@ -99,6 +332,7 @@ void eth_desc_init(uint8_t *buf, uint32_t nTx, uint32_t nRx, uint32_t cTx,
 	bd += sz + cTx;
 
 	RxBD = bd;
+	RxCount = nRx;
 	while (--nRx > 0) {
 		ETH_DES0(bd) = ETH_RDES0_OWN;
 		ETH_DES1(bd) = ETH_RDES1_RCH | cRx;
@@ -114,10 +348,169 @@ void eth_desc_init(uint8_t *buf, uint32_t nTx, uint32_t nRx, uint32_t cTx,
 
 	ETH_DMARDLAR = (uint32_t) RxBD;
 	ETH_DMATDLAR = (uint32_t) TxBD;
+
+	TxDone = TxBD;
+	TxBusy = 0;
+	TxCic = ETH_TDES0_CIC_DISABLED;
+	RxLent = RxBD;
+	RxHeld = 0;
+	memset(&RxStats, 0, sizeof(RxStats));
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Set the transmit completion callback
+ *
+ * The callback is called by eth_tx_reclaim() for each buffer passed to
+ * eth_tx_frame() or eth_tx_gather() once the DMA is done with it, to hand it
+ * back to the network stack. Frames sent with eth_tx() are not reported.
+ *
+ * @param[in] callback eth_tx_callback Callback, or NULL
+ */
+void eth_set_tx_callback(eth_tx_callback callback)
+{
+	TxCallback = callback;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Reclaim the transmit descriptors of sent frames
+ *
+ * Called by the transmit functions when they need descriptors; call it from
+ * the same context, for example after the transmit interrupt, to have
+ * buffers handed back to the stack without waiting for the next frame.
+ *
+ * @returns uint32_t Number of frames reclaimed
+ */
+uint32_t eth_tx_reclaim(void)
+{
+	uint32_t sz = eth_desc_size();
+	uint32_t n = 0;
+
+	while (TxBusy && !(ETH_DES0(TxDone) & ETH_TDES0_OWN)) {
+		uint32_t buf = ETH_DES2(TxDone);
+
+		if (buf != TxDone + sz) {
+			/* Restore the descriptor buffer for eth_tx() */
+			ETH_DES2(TxDone) = TxDone + sz;
+			if (TxCallback) {
+				TxCallback((uint8_t *)buf);
+			}
+		}
+		if (ETH_DES0(TxDone) & ETH_TDES0_LS) {
+			n++;
+		}
+
+		TxDone = ETH_DES3(TxDone);
+		TxBusy--;
+	}
+
+	return n;
+}
+
+/* Makes sure n transmit descriptors are free */
+static bool eth_tx_reserve(uint32_t n)
+{
+	if (TxCount - TxBusy < n) {
+		eth_tx_reclaim();
+	}
+	return TxCount - TxBusy >= n;
+}
+
+/* Fills the next descriptor, handing it to the DMA unless it starts a frame */
+static void eth_tx_put(uint32_t buf, uint32_t n, uint32_t des0)
+{
+	ETH_DES2(TxBD) = buf;
+	ETH_DES1(TxBD) = n & ETH_TDES1_TBS1;
+	ETH_DES0(TxBD) = ETH_TDES0_TCH | des0 |
+			 ((des0 & ETH_TDES0_FS) ? 0 : ETH_TDES0_OWN);
+	TxBD = ETH_DES3(TxBD);
+	TxBusy++;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Resume transmission
+ *
+ * Issues the transmit poll demand for frames queued with ETH_TX_MORE.
+ */
+void eth_tx_flush(void)
+{
+	ETH_DMASR = ETH_DMASR_TBUS;
+	ETH_DMATPDR = 0;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Transmit a frame gathered from several buffers
+ *
+ * Each buffer is mapped onto its own descriptor, so headers and payload
+ * built separately go out as one frame without being copied together. The
+ * buffers must stay untouched until they are handed back by the transmit
+ * callback. They must be in memory the Ethernet DMA can read, and on cached
+ * cores cleaned to memory beforehand.
+ *
+ * With ETH_TX_MORE the DMA is not woken up, so a burst of small frames
+ * costs a single poll demand: queue all but the last with ETH_TX_MORE, or
+ * call eth_tx_flush() afterwards.
+ *
+ * The ETH_TX_CIC_* flags select the checksum insertion for this frame;
+ * without them the setting of eth_enable_checksum_offload() applies.
+ *
+ * @param[in] iov const struct eth_iovec* Buffers of the frame, in order
+ * @param[in] niov uint32_t Number of buffers, at most the descriptor count
+ * @param[in] flags uint32_t ETH_TX_MORE and an ETH_TX_CIC_* value
+ * @returns bool true, if success; false if not enough descriptors are free
+ */
+bool eth_tx_gather(const struct eth_iovec *iov, uint32_t niov, uint32_t flags)
+{
+	uint32_t first = TxBD;
+	uint32_t cic = TxCic;
+	uint32_t i;
+
+	if (!niov || !eth_tx_reserve(niov)) {
+		return false;
+	}
+
+	if (flags & ETH_TX_CIC_MASK) {
+		cic = (((flags & ETH_TX_CIC_MASK) >> ETH_TX_CIC_SHIFT) - 1) <<
+		      ETH_TDES0_CIC_SHIFT;
+	}
+
+	for (i = 0; i < niov; i++) {
+		eth_tx_put((uint32_t)iov[i].base, iov[i].len, cic |
+			   (i == 0 ? ETH_TDES0_FS : 0) |
+			   (i == niov - 1 ? ETH_TDES0_LS : 0));
+	}
+
+	/* The DMA must not see the frame before all of it is in place */
+	__dmb();
+	ETH_DES0(first) |= ETH_TDES0_OWN;
+
+	if (!(flags & ETH_TX_MORE)) {
+		eth_tx_flush();
+	}
+
+	return true;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Transmit a frame without copying it
+ *
+ * Same as eth_tx_gather() with a single buffer and no flags.
+ *
+ * @param[in] frame uint8_t* Pointer to the beginning of the frame
+ * @param[in] n uint32_t Size of the frame, at most 8191 bytes
+ * @returns bool true, if success; false if all descriptors are in flight
+ */
+bool eth_tx_frame(uint8_t *frame, uint32_t n)
+{
+	struct eth_iovec iov = { frame, n };
+
+	return eth_tx_gather(&iov, 1, 0);
 }
 
 /*---------------------------------------------------------------------------*/
 /** @brief Transmit packet
+ *
+ * The packet is copied into the descriptor buffer and can be reused when
+ * the function returns.
  *
  * @param[in] ppkt uint8_t* Pointer to the beginning of the packet
  * @param[in] n uint32_t Size of the packet
@@ -125,26 +518,297 @@ void eth_desc_init(uint8_t *buf, uint32_t nTx, uint32_t nRx, uint32_t cTx,
  */
 bool eth_tx(uint8_t *ppkt, uint32_t n)
 {
-	if (ETH_DES0(TxBD) & ETH_TDES0_OWN) {
+	uint32_t bd = TxBD;
+
+	if (!eth_tx_reserve(1)) {
 		return false;
 	}
 
-	memcpy((void *)ETH_DES2(TxBD), ppkt, n);
+	memcpy((void *)ETH_DES2(bd), ppkt, n);
+	eth_tx_put(ETH_DES2(bd), n, TxCic | ETH_TDES0_FS | ETH_TDES0_LS);
+	__dmb();
+	ETH_DES0(bd) |= ETH_TDES0_OWN;
+	eth_tx_flush();
 
-	ETH_DES1(TxBD) = n & ETH_TDES1_TBS1;
-	ETH_DES0(TxBD) |= ETH_TDES0_LS | ETH_TDES0_FS | ETH_TDES0_OWN;
-	TxBD = ETH_DES3(TxBD);
+	return true;
+}
+
+/* Lends the descriptor to the application or gives it back to the DMA */
+static void eth_rx_advance(bool lend)
+{
+	if (lend) {
+		ETH_DES0(RxBD) = ETH_RX_LENT;
+		RxHeld++;
+	} else if (RxHeld) {
+		/* Given back in order, by eth_rx_release() */
+		ETH_DES0(RxBD) = ETH_RX_DROPPED;
+	} else {
+		ETH_DES0(RxBD) = ETH_RDES0_OWN;
+		RxLent = ETH_DES3(RxBD);
+	}
+	RxBD = ETH_DES3(RxBD);
+}
+
+/* True if the next descriptor holds a frame not yet seen */
+static bool eth_rx_ready(void)
+{
+	return !(RxHeld && RxBD == RxLent) &&
+	       !(ETH_DES0(RxBD) & ETH_RDES0_OWN);
+}
+
+/* Sorts a received frame into the statistics, true if it can be delivered */
+static bool eth_rx_check(uint32_t des0)
+{
+	if ((des0 & (ETH_RDES0_FS | ETH_RDES0_LS)) !=
+	    (ETH_RDES0_FS | ETH_RDES0_LS)) {
+		/* Count a frame spread over several descriptors only once */
+		if (des0 & ETH_RDES0_LS) {
+			RxStats.split++;
+		}
+		return false;
+	}
+
+	/* Checksum errors are left to the stack, see ETH_DMAOMR_DTCEFD */
+	if (des0 & ETH_RDES0_ES) {
+		if (des0 & ETH_RDES0_CE) {
+			RxStats.crc_errors++;
+			return false;
+		}
+		if (des0 & ETH_RDES0_LE) {
+			RxStats.length_errors++;
+			return false;
+		}
+		if (des0 & ETH_RDES0_RE) {
+			RxStats.phy_errors++;
+			return false;
+		}
+		if (des0 & ETH_RDES0_LCO) {
+			RxStats.collisions++;
+			return false;
+		}
+		if (des0 & ETH_RDES0_RWT) {
+			RxStats.watchdog++;
+			return false;
+		}
+		if (des0 & ETH_RDES0_OE) {
+			RxStats.overflows++;
+			return false;
+		}
+		if (des0 & ETH_RDES0_DCE) {
+			RxStats.truncated++;
+			return false;
+		}
+	}
+
+	RxStats.frames++;
+	return true;
+}
+
+/* Resumes reception if the DMA ran out of descriptors */
+static void eth_rx_resume(void)
+{
+	if (ETH_DMASR & ETH_DMASR_RBUS) {
+		RxStats.ring_full++;
+		ETH_DMASR = ETH_DMASR_RBUS;
+		ETH_DMARPDR = 0;
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Borrow a received frame from the descriptor ring
+ *
+ * The frame stays in the descriptor buffer until it is given back with
+ * eth_rx_release(). Several frames can be borrowed at a time; they must be
+ * released in the order they were acquired. The DMA stops receiving when it
+ * reaches a borrowed descriptor, so the ring should be sized for the frames
+ * the stack may hold on to. Descriptors of frames dropped while others are
+ * borrowed are given back together with the borrowed frame before them.
+ *
+ * Frames are only lent out whole: the receive buffers must be large enough
+ * for the longest frame, frames spread over several descriptors are dropped.
+ * Frames with errors are dropped too, counted by cause in the statistics;
+ * only those with a bad IP or payload checksum are delivered.
+ *
+ * @param[out] ppkt uint8_t** Set to the beginning of the frame
+ * @param[out] len uint32_t* Set to the length of the frame
+ * @returns bool true, if a frame has been acquired
+ */
+bool eth_rx_acquire(uint8_t **ppkt, uint32_t *len)
+{
+	bool ok = false;
+
+	while (eth_rx_ready()) {
+		uint32_t des0 = ETH_DES0(RxBD);
+
+		ok = eth_rx_check(des0);
+		if (ok) {
+			*ppkt = (uint8_t *)ETH_DES2(RxBD);
+			*len = (des0 & ETH_RDES0_FL) >> ETH_RDES0_FL_SHIFT;
+		}
+		eth_rx_advance(ok);
+		if (ok) {
+			break;
+		}
+	}
+
+	eth_rx_resume();
+
+	return ok;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Give a borrowed frame back to the descriptor ring
+ *
+ * Releases the oldest frame obtained with eth_rx_acquire(). The descriptor
+ * is given back with @p buf as its buffer: either the frame itself, or a
+ * fresh buffer from the stack pool when the stack keeps the frame. A fresh
+ * buffer must be word aligned, as large as the receive buffers passed to
+ * eth_desc_init(), and in memory the Ethernet DMA can write.
+ *
+ * @param[in] buf uint8_t* Buffer for the descriptor
+ */
+void eth_rx_release(uint8_t *buf)
+{
+	if (!RxHeld) {
+		return;
+	}
+
+	ETH_DES2(RxLent) = (uint32_t)buf;
+	ETH_DES0(RxLent) = ETH_RDES0_OWN;
+	RxLent = ETH_DES3(RxLent);
+	RxHeld--;
 
-	if (ETH_DMASR & ETH_DMASR_TBUS) {
-		ETH_DMASR = ETH_DMASR_TBUS;
-		ETH_DMATPDR = 0;
+	/* Give back the frames dropped while this one was borrowed */
+	while (RxLent != RxBD && ETH_DES0(RxLent) == ETH_RX_DROPPED) {
+		ETH_DES0(RxLent) = ETH_RDES0_OWN;
+		RxLent = ETH_DES3(RxLent);
 	}
 
+	eth_rx_resume();
+}
+
+/* Accumulates the missed frame counters, which clear on read */
+static void eth_rx_count_missed(void)
+{
+	uint32_t mfbocr = ETH_DMAMFBOCR;
+
+	RxStats.missed += (mfbocr & ETH_DMAMFBOCR_MFC) >>
+			  ETH_DMAMFBOCR_MFC_SHIFT;
+	RxStats.fifo_missed += (mfbocr & ETH_DMAMFBOCR_MFA) >>
+			       ETH_DMAMFBOCR_MFA_SHIFT;
+}
+
+/* Updates the ring occupancy high-water mark */
+static void eth_rx_count_waiting(void)
+{
+	uint32_t bd = RxBD;
+	uint32_t n = RxHeld;
+
+	while (n < RxCount && !(ETH_DES0(bd) & ETH_RDES0_OWN)) {
+		bd = ETH_DES3(bd);
+		n++;
+	}
+
+	if (n > RxStats.ring_high) {
+		RxStats.ring_high = n;
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Receive interrupt handler
+ *
+ * Call this from the Ethernet interrupt, with ETH_DMAIER_NISE and
+ * ETH_DMAIER_RIE enabled. On a receive interrupt, the interrupt is masked
+ * and the function returns true: the application then schedules
+ * eth_rx_poll() to run outside of the interrupt, which unmasks it once the
+ * ring is empty. A flood of frames thus costs one interrupt per batch
+ * rather than per frame.
+ *
+ * ETH_DMASR_NIS must be acknowledged by the caller once all the normal
+ * interrupt sources have been handled.
+ *
+ * @returns bool true, if eth_rx_poll() has to be scheduled
+ */
+bool eth_rx_irq_handler(void)
+{
+	if (!(ETH_DMAIER & ETH_DMAIER_RIE) || !(ETH_DMASR & ETH_DMASR_RS)) {
+		return false;
+	}
+
+	ETH_DMAIER &= ~ETH_DMAIER_RIE;
+	ETH_DMASR = ETH_DMASR_RS;
+
 	return true;
 }
 
+/*---------------------------------------------------------------------------*/
+/** @brief Deliver a batch of received frames
+ *
+ * Passes up to @p budget frames to the callback, in place, and gives each
+ * descriptor back with the buffer it returns. If the budget is used up,
+ * frames may still be waiting and the receive interrupt stays masked: call
+ * the function again, after giving other work a chance to run. Otherwise
+ * the ring is empty and the receive interrupt is unmasked.
+ *
+ * Frames acquired with eth_rx_acquire() must all be released before.
+ *
+ * @param[in] callback eth_rx_callback Frame handler
+ * @param[in] budget uint32_t Maximum number of frames to deliver
+ * @returns uint32_t Number of frames delivered
+ */
+uint32_t eth_rx_poll(eth_rx_callback callback, uint32_t budget)
+{
+	uint8_t *frame;
+	uint32_t len;
+	uint32_t n = 0;
+
+	eth_rx_count_waiting();
+
+	for (;;) {
+		while (n < budget && eth_rx_acquire(&frame, &len)) {
+			eth_rx_release(callback(frame, len));
+			n++;
+		}
+		eth_rx_count_missed();
+
+		if (n == budget) {
+			return n;
+		}
+
+		/* A frame completing from now on sets RS again */
+		ETH_DMASR = ETH_DMASR_RS;
+		if (!eth_rx_ready()) {
+			break;
+		}
+	}
+
+	ETH_DMAIER |= ETH_DMAIER_RIE;
+
+	return n;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Read the receive statistics
+ *
+ * The counters are updated by all the receive functions.
+ *
+ * @param[out] stats struct eth_rx_stats* Copy of the counters
+ * @param[in] clear bool true to reset the counters
+ */
+void eth_rx_get_stats(struct eth_rx_stats *stats, bool clear)
+{
+	eth_rx_count_missed();
+	*stats = RxStats;
+	if (clear) {
+		memset(&RxStats, 0, sizeof(RxStats));
+	}
+}
+
 /*---------------------------------------------------------------------------*/
 /** @brief Receive packet
+ *
+ * The packet is copied out of the descriptor buffer, which is given back to
+ * the DMA straight away.
  *
  * @param[inout] ppkt uint8_t* Pointer to the data buffer where to store data
  * @param[inout] len uint32_t* Pointer to the variable with the packet length
@@ -153,36 +817,22 @@ bool eth_tx(uint8_t *ppkt, uint32_t n)
  */
 bool eth_rx(uint8_t *ppkt, uint32_t *len, uint32_t maxlen)
 {
-	bool fs = false;
-	bool ls = false;
-	bool overrun = false;
-	uint32_t l = 0;
-
-	while (!(ETH_DES0(RxBD) & ETH_RDES0_OWN) && !ls) {
-		l = (ETH_DES0(RxBD) & ETH_RDES0_FL) >> ETH_RDES0_FL_SHIFT;
-
-		fs |= ETH_DES0(RxBD) & ETH_RDES0_FS;
-		ls |= ETH_DES0(RxBD) & ETH_RDES0_LS;
-		/* frame buffer overrun ?*/
-		overrun |= fs && (maxlen < l);
+	uint8_t *frame;
+	uint32_t l;
+	bool ok;
 
-		if (fs && !overrun) {
-			memcpy(ppkt, (void *)ETH_DES2(RxBD), l);
-			ppkt += l;
-			*len += l;
-			maxlen -= l;
-		}
-
-		ETH_DES0(RxBD) = ETH_RDES0_OWN;
-		RxBD = ETH_DES3(RxBD);
+	if (!eth_rx_acquire(&frame, &l)) {
+		return false;
 	}
 
-	if (ETH_DMASR & ETH_DMASR_RBUS) {
-		ETH_DMASR = ETH_DMASR_RBUS;
-		ETH_DMARPDR = 0;
+	ok = l <= maxlen;
+	if (ok) {
+		memcpy(ppkt, frame, l);
+		*len += l;
 	}
+	eth_rx_release(frame);
 
-	return fs && ls && !overrun;
+	return ok;
 }
 
 /*---------------------------------------------------------------------------*/
@@ -273,17 +923,13 @@ bool eth_irq_ack_pending(uint32_t reason)
 /** @brief Enable checksum offload feature
  *
  * This function will enable the Checksum offload feature for all of the
- * transmit descriptors. Note to use this feature, descriptors must be in
- * extended format.
+ * transmitted frames, except those selecting their own with the
+ * ETH_TX_CIC_* flags of eth_tx_gather(). Note to use this feature,
+ * descriptors must be in extended format.
  */
 void eth_enable_checksum_offload(void)
 {
-	uint32_t tab = TxBD;
-	do {
-		ETH_DES0(tab) |= ETH_TDES0_CIC_IPPLPH;
-		tab = ETH_DES3(tab);
-	}
-	while (tab != TxBD);
+	TxCic = ETH_TDES0_CIC_IPPLPH;
 
 	ETH_MACCR |= ETH_MACCR_IPCO;
 }
@@ -138,3 +138,52 @@ uint16_t ssp_transfer(ssp_num_t ssp_num, uint16_t data)
 
 /**@}*/
 
+/* Depth of the transmit and receive FIFOs */
+#define SSP_FIFO_DEPTH 8
+
+void ssp_transfer_buffer(ssp_num_t ssp_num, const void *tx, void *rx,
+				uint16_t len)
+{
+	uint32_t ssp_port;
+	const uint8_t *tx8 = tx;
+	const uint16_t *tx16 = tx;
+	uint8_t *rx8 = rx;
+	uint16_t *rx16 = rx;
+	uint16_t sent = 0;
+	uint16_t received = 0;
+	uint16_t data;
+	bool wide;
+
+	if (ssp_num == SSP0_NUM) {
+		ssp_port = SSP0;
+	} else {
+		ssp_port = SSP1;
+	}
+
+	/* DSS holds the frame size minus one */
+	wide = (SSP_CR0(ssp_port) & 0xF) > 7;
+
+	while (received < len) {
+		/* Never more than a receive FIFO worth in flight */
+		while (sent < len && (uint16_t)(sent - received) < SSP_FIFO_DEPTH &&
+		       (SSP_SR(ssp_port) & SSP_SR_TNF)) {
+			data = 0xffff;
+			if (tx) {
+				data = wide ? tx16[sent] : tx8[sent];
+			}
+			SSP_DR(ssp_port) = data;
+			sent++;
+		}
+		while (SSP_SR(ssp_port) & SSP_SR_RNE) {
+			data = SSP_DR(ssp_port);
+			if (rx) {
+				if (wide) {
+					rx16[received] = data;
+				} else {
+					rx8[received] = data;
+				}
+			}
+			received++;
+		}
+	}
+}
@@ -19,6 +19,7 @@
 
 #include <libopencm3/lpc43xx/uart.h>
 #include <libopencm3/lpc43xx/cgu.h>
+#include <libopencm3/cm3/cortex.h>
 
 #define UART_SRC_32K             0x00
 #define UART_SRC_IRC             0x01
@@ -241,3 +242,84 @@ void uart_write(uart_num_t uart_num, uint8_t data)
 	UART_THR(uart_port) = data;
 }
 
+/* Refill the transmit FIFO, only called when THRE says it is empty */
+static void uart_txq_fill(struct uart_txq *q)
+{
+	uint32_t uart_port = q->uart_num;
+	int n = UART_TX_FIFO_DEPTH;
+
+	while (n-- && txq_used(&q->ring)) {
+		UART_THR(uart_port) = txq_get(&q->ring);
+	}
+}
+
+/*
+* Transmit queue init, enables the FIFOs (uart_init() leaves them disabled)
+*/
+void uart_txq_init(struct uart_txq *q, uart_num_t uart_num,
+	    uint8_t *buf, uint16_t size)
+{
+	q->uart_num = uart_num;
+	txq_init(&q->ring, buf, size);
+	q->active = false;
+
+	UART_FCR(uart_num) = UART_FCR_FIFO_EN | UART_FCR_TX_RS;
+}
+
+/* Queue as much of data as fits and start transmitting, never waits */
+uint16_t uart_txq_write(struct uart_txq *q, const void *data, uint16_t len)
+{
+	uint32_t uart_port = q->uart_num;
+	uint16_t n = txq_put(&q->ring, data, len);
+
+	CM_ATOMIC_BLOCK() {
+		if (!q->active && txq_used(&q->ring)) {
+			q->active = true;
+			if (UART_LSR(uart_port) & UART_LSR_THRE) {
+				uart_txq_fill(q);
+			}
+			UART_IER(uart_port) |= UART_IER_THREINT_EN;
+		}
+	}
+	return n;
+}
+
+uint16_t uart_txq_space(const struct uart_txq *q)
+{
+	return txq_space(&q->ring);
+}
+
+bool uart_txq_busy(const struct uart_txq *q)
+{
+	return q->active;
+}
+
+/* Wait until everything queued has left the transmitter */
+void uart_txq_flush(struct uart_txq *q)
+{
+	uint32_t uart_port = q->uart_num;
+
+	while (q->active);
+	while ((UART_LSR(uart_port) & UART_LSR_TEMT) == 0);
+}
+
+void uart_txq_irq_handler(struct uart_txq *q)
+{
+	uint32_t uart_port = q->uart_num;
+
+	if (!(UART_IER(uart_port) & UART_IER_THREINT_EN) ||
+	    !(UART_LSR(uart_port) & UART_LSR_THRE)) {
+		return;
+	}
+
+	if (txq_used(&q->ring)) {
+		uart_txq_fill(q);
+		return;
+	}
+
+	UART_IER(uart_port) &= ~UART_IER_THREINT_EN;
+	q->active = false;
+	if (q->callback) {
+		q->callback(q);
+	}
+}
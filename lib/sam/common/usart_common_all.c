@@ -18,6 +18,7 @@
  */
 
 #include <libopencm3/sam/usart.h>
+#include <libopencm3/cm3/cortex.h>
 
 void usart_set_databits(uint32_t usart, int bits)
 {
@@ -124,3 +125,82 @@ void usart_set_character_length(uint32_t usart, enum usart_chrl chrl)
 	uint32_t reg_mr = USART_MR(usart) & (~USART_MR_CHRL_MASK);
 	USART_MR(usart) = reg_mr | (chrl << USART_MR_CHRL_SHIFT);
 }
+
+/* Transmit queue, drained one character per TXRDY interrupt. The USART
+ * vector must call usart_txq_irq_handler(). */
+
+static void usart_txq_start(struct usart_txq *q)
+{
+	if (txq_used(&q->ring)) {
+		USART_THR(q->usart) = txq_get(&q->ring);
+		USART_IER(q->usart) = USART_CSR_TXRDY;
+	} else {
+		USART_IER(q->usart) = USART_CSR_TXEMPTY;
+	}
+}
+
+void usart_txq_init(struct usart_txq *q, uint32_t usart,
+		    uint8_t *buf, uint16_t size)
+{
+	q->usart = usart;
+	txq_init(&q->ring, buf, size);
+	q->active = false;
+}
+
+uint16_t usart_txq_write(struct usart_txq *q, const void *data,
+			 uint16_t len)
+{
+	uint16_t n = txq_put(&q->ring, data, len);
+
+	CM_ATOMIC_BLOCK() {
+		if (!q->active && txq_used(&q->ring)) {
+			q->active = true;
+			usart_txq_start(q);
+		}
+	}
+	return n;
+}
+
+uint16_t usart_txq_space(const struct usart_txq *q)
+{
+	return txq_space(&q->ring);
+}
+
+bool usart_txq_busy(const struct usart_txq *q)
+{
+	return q->active;
+}
+
+void usart_txq_flush(struct usart_txq *q)
+{
+	while (q->active);
+}
+
+void usart_txq_irq_handler(struct usart_txq *q)
+{
+	uint32_t usart = q->usart;
+	uint32_t pending = USART_CSR(usart) & USART_IMR(usart);
+
+	if (pending & USART_CSR_TXRDY) {
+		if (txq_used(&q->ring)) {
+			USART_THR(usart) = txq_get(&q->ring);
+		} else {
+			USART_IDR(usart) = USART_CSR_TXRDY;
+			USART_IER(usart) = USART_CSR_TXEMPTY;
+		}
+		return;
+	}
+
+	if (pending & USART_CSR_TXEMPTY) {
+		USART_IDR(usart) = USART_CSR_TXEMPTY;
+		if (txq_used(&q->ring)) {
+			/* Written while the last character was going out. */
+			usart_txq_start(q);
+			return;
+		}
+		q->active = false;
+		if (q->callback) {
+			q->callback(q);
+		}
+	}
+}
@@ -0,0 +1,399 @@
+/** @defgroup can_queue_file CAN queue
+
+@ingroup STM32F_files
+
+@brief Interrupt driven receive ring and priority ordered transmit queue for
+the STM32 bxCAN.
+
+The peripheral must be initialised with can_init() and its filters set up.
+Transmit FIFO priority must be off (txfp false in can_init()), so that the
+mailboxes go out in identifier order.
+
+All the CAN vectors of the peripheral (TX, RX0, RX1 and SCE, or the single
+shared vector) must call can_bus_irq_handler(), and must have the same
+priority.
+
+LGPL License Terms @ref lgpl_license
+*/
+/*
+ * This file is part of the libopencm3 project.
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**@{*/
+
+#include <libopencm3/cm3/cortex.h>
+#include <libopencm3/stm32/can_queue.h>
+
+#define CAN_BUS_TME_ALL		(CAN_TSR_TME0 | CAN_TSR_TME1 | CAN_TSR_TME2)
+
+static const uint32_t can_bus_mailboxes[] = {
+	CAN_MBOX0, CAN_MBOX1, CAN_MBOX2
+};
+
+/* Arbitration field as sent on the bus: the lower, the higher the priority.
+ * A standard frame wins over an extended one with the same base identifier,
+ * a data frame over a remote frame. */
+static uint32_t can_bus_key(const struct can_frame *frame)
+{
+	if (frame->ext) {
+		return ((frame->id >> 18) << 21) | (3 << 19) |
+		       ((frame->id & 0x3FFFF) << 1) | frame->rtr;
+	}
+	return ((frame->id & 0x7FF) << 21) | ((uint32_t)frame->rtr << 20);
+}
+
+static uint32_t can_bus_pack(const uint8_t *data)
+{
+	return data[0] | ((uint32_t)data[1] << 8) |
+	       ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+static void can_bus_unpack(uint8_t *data, uint32_t word)
+{
+	data[0] = word;
+	data[1] = word >> 8;
+	data[2] = word >> 16;
+	data[3] = word >> 24;
+}
+
+static void can_bus_load(struct can_bus *bus, uint8_t mb,
+			 const struct can_frame *frame)
+{
+	uint32_t canport = bus->canport;
+	uint32_t mailbox = can_bus_mailboxes[mb];
+	uint32_t tir;
+
+	bus->mailbox[mb] = *frame;
+
+	if (frame->ext) {
+		tir = (frame->id << CAN_TIxR_EXID_SHIFT) | CAN_TIxR_IDE;
+	} else {
+		tir = frame->id << CAN_TIxR_STID_SHIFT;
+	}
+	if (frame->rtr) {
+		tir |= CAN_TIxR_RTR;
+	}
+
+	CAN_TIxR(canport, mailbox) = tir;
+	CAN_TDTxR(canport, mailbox) = frame->length & CAN_TDTxR_DLC_MASK;
+	CAN_TDLxR(canport, mailbox) = can_bus_pack(&frame->data[0]);
+	CAN_TDHxR(canport, mailbox) = can_bus_pack(&frame->data[4]);
+	CAN_TIxR(canport, mailbox) = tir | CAN_TIxR_TXRQ;
+}
+
+/* Inserts a frame into the transmit queue, kept with the highest priority
+ * frame last; frames of equal priority keep their order. */
+static bool can_bus_queue(struct can_bus *bus, const struct can_frame *frame)
+{
+	uint32_t key = can_bus_key(frame);
+	uint16_t i = bus->tx_count;
+
+	if (i == bus->tx_size) {
+		return false;
+	}
+
+	while (i > 0 && can_bus_key(&bus->tx[i - 1]) <= key) {
+		bus->tx[i] = bus->tx[i - 1];
+		i--;
+	}
+	bus->tx[i] = *frame;
+	bus->tx_count++;
+
+	return true;
+}
+
+/* Collects the outcome of finished mailboxes; aborted frames are requeued.
+ * Must run before a mailbox is reloaded, which clears its status. */
+static void can_bus_complete(struct can_bus *bus)
+{
+	uint32_t tsr = CAN_TSR(bus->canport);
+	uint8_t mb;
+
+	for (mb = 0; mb < 3; mb++) {
+		uint8_t shift = mb * 8;
+
+		if (!(tsr & (CAN_TSR_RQCP0 << shift))) {
+			continue;
+		}
+
+		CAN_TSR(bus->canport) = CAN_TSR_RQCP0 << shift;
+		if (!(tsr & (CAN_TSR_TXOK0 << shift))) {
+			/* can_bus_send() keeps a slot for the aborted frame */
+			if (!(bus->aborting & (1 << mb)) ||
+			    !can_bus_queue(bus, &bus->mailbox[mb])) {
+				bus->tx_errors++;
+			}
+		}
+		bus->aborting &= ~(1 << mb);
+	}
+}
+
+/* Moves the highest priority queued frames into the empty mailboxes */
+static void can_bus_refill(struct can_bus *bus)
+{
+	uint32_t tsr;
+	uint8_t mb;
+
+	can_bus_complete(bus);
+
+	tsr = CAN_TSR(bus->canport);
+	for (mb = 0; mb < 3 && bus->tx_count; mb++) {
+		if (tsr & (CAN_TSR_TME0 << mb)) {
+			bus->tx_count--;
+			can_bus_load(bus, mb, &bus->tx[bus->tx_count]);
+		}
+	}
+}
+
+/* Aborts the lowest priority mailbox if the head of the queue outranks it.
+ * Only one abort at a time, and only with room to requeue the frame. */
+static void can_bus_preempt(struct can_bus *bus)
+{
+	uint32_t key;
+	uint32_t worst = 0;
+	int victim = -1;
+	uint8_t mb;
+
+	if (!bus->tx_count || bus->aborting || bus->tx_count == bus->tx_size ||
+	    (CAN_TSR(bus->canport) & CAN_BUS_TME_ALL)) {
+		return;
+	}
+
+	key = can_bus_key(&bus->tx[bus->tx_count - 1]);
+	for (mb = 0; mb < 3; mb++) {
+		uint32_t k = can_bus_key(&bus->mailbox[mb]);
+
+		if (k > key && k >= worst) {
+			worst = k;
+			victim = mb;
+		}
+	}
+
+	if (victim >= 0) {
+		bus->aborting = 1 << victim;
+		CAN_TSR(bus->canport) = CAN_TSR_ABRQ0 << (victim * 8);
+	}
+}
+
+/* Moves one frame from a receive FIFO into the ring */
+static void can_bus_read(struct can_bus *bus, uint8_t fifo)
+{
+	uint32_t canport = bus->canport;
+	uint32_t fifo_id = fifo ? CAN_FIFO1 : CAN_FIFO0;
+	uint16_t head = bus->rx_head;
+	uint16_t next = head + 1 == bus->rx_size ? 0 : head + 1;
+	struct can_frame *frame = &bus->rx[head];
+	uint32_t rir, rdtr;
+
+	if (next == bus->rx_tail) {
+		bus->rx_dropped++;
+		return;
+	}
+
+	rir = CAN_RIxR(canport, fifo_id);
+	rdtr = CAN_RDTxR(canport, fifo_id);
+
+	frame->ext = rir & CAN_RIxR_IDE;
+	if (frame->ext) {
+		frame->id = (rir >> CAN_RIxR_EXID_SHIFT) & CAN_RIxR_EXID_MASK;
+	} else {
+		frame->id = (rir >> CAN_RIxR_STID_SHIFT) & CAN_RIxR_STID_MASK;
+	}
+	frame->rtr = rir & CAN_RIxR_RTR;
+	frame->fmi = (rdtr & CAN_RDTxR_FMI_MASK) >> CAN_RDTxR_FMI_SHIFT;
+	frame->length = rdtr & CAN_RDTxR_DLC_MASK;
+	if (bus->clock) {
+		frame->timestamp = bus->clock();
+	} else {
+		frame->timestamp = (rdtr & CAN_RDTxR_TIME_MASK) >>
+				   CAN_RDTxR_TIME_SHIFT;
+	}
+	can_bus_unpack(&frame->data[0], CAN_RDLxR(canport, fifo_id));
+	can_bus_unpack(&frame->data[4], CAN_RDHxR(canport, fifo_id));
+
+	bus->rx_head = next;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief CAN Queue Initialise a Bus
+
+Sets up the queues and enables the receive, transmit and error interrupts of
+the peripheral; the interrupts must be enabled in the NVIC by the caller. The
+clock, callback and user fields must be set beforehand.
+
+@param[in] bus Bus state
+@param[in] canport CAN block register base @ref can_reg_base
+@param[in] rx Receive ring storage
+@param[in] rx_size Number of frames in @p rx, the ring holds one less
+@param[in] tx Transmit queue storage
+@param[in] tx_size Number of frames in @p tx, at least one
+*/
+void can_bus_init(struct can_bus *bus, uint32_t canport,
+		  struct can_frame *rx, uint16_t rx_size,
+		  struct can_frame *tx, uint16_t tx_size)
+{
+	bus->canport = canport;
+	bus->rx = rx;
+	bus->rx_size = rx_size;
+	bus->rx_head = 0;
+	bus->rx_tail = 0;
+	bus->tx = tx;
+	bus->tx_size = tx_size;
+	bus->tx_count = 0;
+	bus->aborting = 0;
+
+	bus->rx_overruns = 0;
+	bus->rx_dropped = 0;
+	bus->tx_errors = 0;
+	bus->error_warnings = 0;
+	bus->error_passive = 0;
+	bus->bus_off = 0;
+
+	can_enable_irq(canport, CAN_IER_TMEIE |
+		       CAN_IER_FMPIE0 | CAN_IER_FOVIE0 |
+		       CAN_IER_FMPIE1 | CAN_IER_FOVIE1 |
+		       CAN_IER_ERRIE | CAN_IER_EWGIE | CAN_IER_EPVIE |
+		       CAN_IER_BOFIE);
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief CAN Queue Send a Frame
+
+The frame is copied into a free mailbox, or queued by bus priority until one
+empties. While a mailbox is being preempted, one queue slot stays reserved
+for its frame.
+
+@param[in] bus Bus state
+@param[in] frame Frame to send
+@returns false if the transmit queue is full
+*/
+bool can_bus_send(struct can_bus *bus, const struct can_frame *frame)
+{
+	bool ok;
+
+	CM_ATOMIC_BLOCK() {
+		can_bus_refill(bus);
+		ok = (!bus->aborting || bus->tx_count + 1 < bus->tx_size) &&
+		     can_bus_queue(bus, frame);
+		if (ok) {
+			can_bus_refill(bus);
+			can_bus_preempt(bus);
+		}
+	}
+
+	return ok;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief CAN Queue Receive a Frame
+
+@param[in] bus Bus state
+@param[out] frame Oldest received frame
+@returns false if no frame has been received
+*/
+bool can_bus_receive(struct can_bus *bus, struct can_frame *frame)
+{
+	uint16_t tail = bus->rx_tail;
+
+	if (tail == bus->rx_head) {
+		return false;
+	}
+
+	*frame = bus->rx[tail];
+	bus->rx_tail = tail + 1 == bus->rx_size ? 0 : tail + 1;
+
+	return true;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief CAN Queue Number of Received Frames
+
+@param[in] bus Bus state
+@returns Frames waiting in the receive ring
+*/
+uint16_t can_bus_rx_pending(const struct can_bus *bus)
+{
+	uint16_t head = bus->rx_head;
+	uint16_t tail = bus->rx_tail;
+
+	return head >= tail ? head - tail : bus->rx_size - tail + head;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief CAN Queue Number of Frames to Transmit
+
+@param[in] bus Bus state
+@returns Frames waiting in the transmit queue, not counting the mailboxes
+*/
+uint16_t can_bus_tx_pending(const struct can_bus *bus)
+{
+	return bus->tx_count;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief CAN Queue Interrupt Handler
+
+Drains both receive FIFOs, refills the transmit mailboxes and counts the
+error state changes.
+
+@param[in] bus Bus state
+*/
+void can_bus_irq_handler(struct can_bus *bus)
+{
+	uint32_t canport = bus->canport;
+	uint16_t head = bus->rx_head;
+
+	/* Count overruns before the FIFO release clears the flag */
+	if (CAN_RF0R(canport) & CAN_RF0R_FOVR0) {
+		CAN_RF0R(canport) = CAN_RF0R_FOVR0;
+		bus->rx_overruns++;
+	}
+	while (CAN_RF0R(canport) & CAN_RF0R_FMP0_MASK) {
+		can_bus_read(bus, 0);
+		CAN_RF0R(canport) = CAN_RF0R_RFOM0;
+	}
+
+	if (CAN_RF1R(canport) & CAN_RF1R_FOVR1) {
+		CAN_RF1R(canport) = CAN_RF1R_FOVR1;
+		bus->rx_overruns++;
+	}
+	while (CAN_RF1R(canport) & CAN_RF1R_FMP1_MASK) {
+		can_bus_read(bus, 1);
+		CAN_RF1R(canport) = CAN_RF1R_RFOM1;
+	}
+
+	if (CAN_MSR(canport) & CAN_MSR_ERRI) {
+		uint32_t esr = CAN_ESR(canport);
+
+		CAN_MSR(canport) = CAN_MSR_ERRI;
+		if (esr & CAN_ESR_BOFF) {
+			bus->bus_off++;
+		} else if (esr & CAN_ESR_EPVF) {
+			bus->error_passive++;
+		} else if (esr & CAN_ESR_EWGF) {
+			bus->error_warnings++;
+		}
+	}
+
+	can_bus_refill(bus);
+	can_bus_preempt(bus);
+
+	if (bus->rx_head != head && bus->callback) {
+		bus->callback(bus);
+	}
+}
+
+/**@}*/
@@ -0,0 +1,317 @@
+/** @defgroup adc_dma_file ADC DMA streaming
+@ingroup peripheral_apis
+
+@brief Continuous ADC acquisition into a circular double buffer.
+
+The ADC must be calibrated, powered on and configured by the caller:
+resolution, sample times and, for timer driven sampling, the external
+trigger of the regular group with adc_enable_external_trigger_regular().
+Without an external trigger the ADC should be in continuous mode.
+
+Interrupts needed:
+- the DMA stream/channel vector must call dma_xfer_irq_handler(),
+- the ADC vector must call adc_stream_irq_handler(), it recovers from
+  overruns.
+
+LGPL License Terms @ref lgpl_license
+*/
+/*
+ * This file is part of the libopencm3 project.
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**@{*/
+
+#include <stddef.h>
+#include <libopencm3/stm32/adc_dma.h>
+
+#if defined(ADC_ISR_OVR)
+
+/* ADCs with a start/stop control (F0, F3, G0, G4, L4) */
+
+static bool adc_stream_overrun(const struct adc_stream *s)
+{
+	return adc_get_overrun_flag(s->adc);
+}
+
+static void adc_stream_halt(const struct adc_stream *s)
+{
+	uint32_t adc = s->adc;
+
+	if (ADC_CR(adc) & ADC_CR_ADSTART) {
+		ADC_CR(adc) |= ADC_CR_ADSTP;
+		while (ADC_CR(adc) & ADC_CR_ADSTP);
+	}
+	adc_disable_dma(adc);
+	adc_clear_overrun_flag(adc);
+}
+
+static void adc_stream_run(const struct adc_stream *s)
+{
+	uint32_t adc = s->adc;
+
+	adc_enable_dma_circular_mode(adc);
+	adc_enable_dma(adc);
+	/* Arms the external trigger, or starts continuous conversions. */
+	adc_start_conversion_regular(adc);
+}
+
+#else
+
+/* ADCs started with SWSTART or an external trigger (F4, F7, L1) */
+
+#if defined(STM32F4) || defined(STM32F7)
+static const uint32_t adc_stream_adcs[] = { ADC1, ADC2, ADC3 };
+
+static uint8_t adc_stream_nadc(const struct adc_stream *s)
+{
+	if (s->multi >= ADC_CCR_MULTI_TRIPLE_REG_SIMUL_AND_INJECTED_SIMUL) {
+		return 3;
+	}
+	return s->multi ? 2 : 1;
+}
+#endif
+
+static bool adc_stream_overrun(const struct adc_stream *s)
+{
+#if defined(STM32F4) || defined(STM32F7)
+	if (s->multi) {
+		return ADC_CSR & (ADC_CSR_OVR1 | ADC_CSR_OVR2 | ADC_CSR_OVR3);
+	}
+#endif
+	return adc_get_overrun_flag(s->adc);
+}
+
+static void adc_stream_halt(const struct adc_stream *s)
+{
+#if defined(STM32F4) || defined(STM32F7)
+	if (s->multi) {
+		uint8_t i;
+
+		ADC_CCR &= ~(ADC_CCR_DMA_MASK | ADC_CCR_DDS);
+		for (i = 0; i < adc_stream_nadc(s); i++) {
+			adc_clear_overrun_flag(adc_stream_adcs[i]);
+		}
+		return;
+	}
+#endif
+	ADC_CR2(s->adc) &= ~(ADC_CR2_DMA | ADC_CR2_DDS);
+	adc_clear_overrun_flag(s->adc);
+}
+
+static void adc_stream_run(const struct adc_stream *s)
+{
+	uint32_t adc = s->adc;
+
+#if defined(STM32F4) || defined(STM32F7)
+	if (s->multi) {
+		/* Mode 1 moves one result per request, mode 2 a pair. */
+		uint32_t dma_mode = ADC_CCR_DMA_MODE_2;
+
+		if (adc_stream_nadc(s) == 3 &&
+		    s->multi != ADC_CCR_MULTI_TRIPLE_INTERLEAVED) {
+			dma_mode = ADC_CCR_DMA_MODE_1;
+		}
+		ADC_CCR = (ADC_CCR & ~(ADC_CCR_MULTI_MASK | ADC_CCR_DMA_MASK)) |
+			  s->multi | dma_mode | ADC_CCR_DDS;
+	} else
+#endif
+	{
+		ADC_CR2(adc) |= ADC_CR2_DMA | ADC_CR2_DDS;
+	}
+
+	/* With an external trigger, the next trigger starts the sequence. */
+	if (!(ADC_CR2(adc) & ADC_CR2_EXTEN_MASK)) {
+		adc_start_conversion_regular(adc);
+	}
+}
+
+#endif
+
+static void adc_stream_event(struct dma_xfer *xfer, uint32_t events)
+{
+	struct adc_stream *s = xfer->user;
+	uint16_t half = s->len / 2;
+
+	if (events & DMA_XFER_EVT_ERROR) {
+		adc_stream_halt(s);
+		return;
+	}
+
+	if (events & DMA_XFER_EVT_HALF) {
+		s->blocks++;
+		s->samples += half;
+		s->callback(s, s->buf, half);
+	}
+	if (events & DMA_XFER_EVT_COMPLETE) {
+		s->blocks++;
+		s->samples += half;
+		s->callback(s, s->buf + half, half);
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief ADC DMA Initialise a Stream
+
+Claims the DMA stream or channel. The callback must be set before the stream
+is started.
+
+@param[in] s Stream state
+@param[in] adc ADC block register address base @ref adc_reg_base, ADC1 in
+	   multi ADC mode
+@param[in] dma DMA controller base address: DMA1 or DMA2
+@param[in] channel DMA stream or channel connected to the ADC request
+@param[in] request Request routing, see struct dma_xfer
+@returns false if the DMA stream or channel is in use
+*/
+bool adc_stream_init(struct adc_stream *s, uint32_t adc, uint32_t dma,
+		     uint8_t channel, uint8_t request)
+{
+	s->adc = adc;
+	s->multi = 0;
+
+	s->xfer.src = (uint32_t)&ADC_DR(adc);
+	s->xfer.direction = DMA_XFER_PERIPH_TO_MEM;
+	s->xfer.priority = 3;
+	s->xfer.flags = DMA_XFER_DST_INC | DMA_XFER_CIRCULAR | DMA_XFER_HALF_IRQ;
+	s->xfer.request = request;
+	s->xfer.callback = adc_stream_event;
+	s->xfer.user = s;
+
+	return dma_xfer_claim(&s->xfer, dma, channel);
+}
+
+#if defined(STM32F4) || defined(STM32F7)
+/*---------------------------------------------------------------------------*/
+/** @brief ADC DMA Select a Multi ADC Mode
+
+Takes effect at the next adc_stream_start(), the stream must be stopped. It
+must have been initialised on ADC1, the master. The slave ADCs are configured
+and powered on by the caller; in the interleaved modes they usually convert
+the same sequence as the master, and only the master is triggered.
+
+The results of all ADCs are read from the common data register and stored in
+conversion order: ADC1, ADC2(, ADC3), ADC1, ... In the dual modes and the
+triple interleaved mode they are moved in pairs, so the buffer must be word
+aligned and its length a multiple of four.
+
+@param[in] s Stream state
+@param[in] mode Multi ADC mode @ref adc_multi_mode, ADC_CCR_MULTI_INDEPENDENT
+	   to go back to a single ADC
+*/
+void adc_stream_set_multi_mode(struct adc_stream *s, uint32_t mode)
+{
+	if (!mode) {
+		ADC_CCR &= ~(ADC_CCR_MULTI_MASK | ADC_CCR_DMA_MASK |
+			     ADC_CCR_DDS);
+	}
+	s->multi = mode;
+	s->xfer.src = mode ? (uint32_t)&ADC_CDR : (uint32_t)&ADC_DR(s->adc);
+}
+#endif
+
+/*---------------------------------------------------------------------------*/
+/** @brief ADC DMA Start a Stream
+
+Programs the regular sequence, starts the DMA in circular mode and starts or
+arms the conversions. Each time half of the buffer has been filled, it is
+passed to the callback: @p len / 2 samples, the sequence repeated as many
+times as fits. A block length that is a multiple of the sequence length
+keeps every block starting with the first channel.
+
+The ADC overrun interrupt is enabled; the ADC interrupt must be enabled in
+the NVIC by the caller.
+
+@param[in] s Stream state
+@param[in] channels Regular sequence, ADC channel numbers
+@param[in] length Number of channels in the sequence
+@param[in] buf Double buffer, halfword aligned
+@param[in] len Buffer length in samples, a multiple of two
+*/
+void adc_stream_start(struct adc_stream *s, uint8_t *channels,
+		      uint8_t length, uint16_t *buf, uint16_t len)
+{
+	uint32_t adc = s->adc;
+
+	s->buf = buf;
+	s->len = len;
+	s->blocks = 0;
+	s->samples = 0;
+	s->overruns = 0;
+
+	s->xfer.dst = (uint32_t)buf;
+	s->xfer.count = len;
+	s->xfer.src_width = DMA_XFER_WIDTH_16BIT;
+	s->xfer.dst_width = DMA_XFER_WIDTH_16BIT;
+#if defined(STM32F4) || defined(STM32F7)
+	if (s->multi && (adc_stream_nadc(s) == 2 ||
+			 s->multi == ADC_CCR_MULTI_TRIPLE_INTERLEAVED)) {
+		s->xfer.count = len / 2;
+		s->xfer.src_width = DMA_XFER_WIDTH_32BIT;
+		s->xfer.dst_width = DMA_XFER_WIDTH_32BIT;
+	}
+#endif
+
+	adc_stream_halt(s);
+	adc_set_regular_sequence(adc, length, channels);
+#if !defined(ADC_ISR_OVR)
+	if (length > 1) {
+		adc_enable_scan_mode(adc);
+	}
+#endif
+
+	dma_xfer_submit(&s->xfer);
+	adc_enable_overrun_interrupt(adc);
+	adc_stream_run(s);
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief ADC DMA Stop a Stream
+
+Stops the DMA; on ADCs with a stop control the conversions are stopped too,
+otherwise the caller stops the trigger or continuous mode.
+
+@param[in] s Stream state
+*/
+void adc_stream_stop(struct adc_stream *s)
+{
+	adc_disable_overrun_interrupt(s->adc);
+	adc_stream_halt(s);
+	dma_xfer_abort(&s->xfer);
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief ADC DMA Stream Interrupt Handler
+
+Call this from the ADC interrupt vector. On an overrun, the DMA has stopped
+taking results: the partly filled block is dropped, counted in the overruns
+statistic, and the stream is restarted at the first half of the buffer.
+
+@param[in] s Stream state
+*/
+void adc_stream_irq_handler(struct adc_stream *s)
+{
+	if (!adc_stream_overrun(s)) {
+		return;
+	}
+
+	s->overruns++;
+	adc_stream_halt(s);
+	dma_xfer_abort(&s->xfer);
+	dma_xfer_submit(&s->xfer);
+	adc_stream_run(s);
+}
+
+/**@}*/
@@ -485,3 +485,178 @@ void cordic_sin_32bit_async(int32_t x) {
         cordic_configure_for_sin_32bit();
         cordic_write_32bit_argument((uint32_t) x);
 }
+
+/** @brief Number of arguments of a CORDIC function
+ *
+ * Sine and cosine take an angle and a modulus, phase and modulus take x and y,
+ * all other functions take a single argument.
+ * @param[in] function function of type @ref cordic_csr_function
+ * @returns 1 or 2
+ *
+ */
+uint8_t cordic_function_arguments(uint8_t function) {
+        return function <= CORDIC_CSR_FUNC_MODULUS ? 2 : 1;
+}
+
+/** @brief Number of results of a CORDIC function
+ *
+ * The circular functions except arctangent, and hyperbolic sine and cosine
+ * return a second result: the other one of the sine/cosine pair, the modulus
+ * or the phase. The remaining functions return a single result.
+ * @param[in] function function of type @ref cordic_csr_function
+ * @returns 1 or 2
+ *
+ */
+uint8_t cordic_function_results(uint8_t function) {
+        return function <= CORDIC_CSR_FUNC_MODULUS ||
+               function == CORDIC_CSR_FUNC_COSH ||
+               function == CORDIC_CSR_FUNC_SINH ? 2 : 1;
+}
+
+/** @brief Configure CORDIC for a batch of q1.15 operations
+ *
+ * Each operation takes one 32 bit write carrying both arguments and returns
+ * both results in one 32 bit read. The precision and scaling factor are
+ * left as set with cordic_set_precision() and cordic_set_scaling_factor(),
+ * DMA requests and the interrupt are disabled.
+ * @param[in] function function of type @ref cordic_csr_function
+ *
+ */
+void cordic_configure_q15(uint8_t function) {
+        CORDIC_CSR = (CORDIC_CSR & (CORDIC_CSR_PRECISION_MASK | CORDIC_CSR_SCALE_MASK)) |
+                     CORDIC_CSR_ARGSIZE | CORDIC_CSR_RESSIZE |
+                     (function << CORDIC_CSR_FUNC_SHIFT);
+}
+
+/** @brief Configure CORDIC for a batch of q1.31 operations
+ *
+ * Each operation takes one write per argument and returns one read per
+ * result, see cordic_function_arguments() and cordic_function_results().
+ * The precision and scaling factor are left as set with
+ * cordic_set_precision() and cordic_set_scaling_factor(), DMA requests and
+ * the interrupt are disabled.
+ * @param[in] function function of type @ref cordic_csr_function
+ *
+ */
+void cordic_configure_q31(uint8_t function) {
+        uint32_t csr = CORDIC_CSR & (CORDIC_CSR_PRECISION_MASK | CORDIC_CSR_SCALE_MASK);
+
+        if (cordic_function_arguments(function) == 2) {
+                csr |= CORDIC_CSR_NARGS;
+        }
+        if (cordic_function_results(function) == 2) {
+                csr |= CORDIC_CSR_NRES;
+        }
+        CORDIC_CSR = csr | (function << CORDIC_CSR_FUNC_SHIFT);
+}
+
+/** @brief Compute a batch of q1.15 operations
+ *
+ * The peripheral is configured once, then the arguments of the next
+ * operation are written while the current one is being computed, and the
+ * read of its results stalls the bus just until they are ready. This keeps
+ * the CORDIC busy without polling the ready flag.
+ *
+ * @p in holds cordic_function_arguments() values per operation and @p out
+ * receives cordic_function_results() values per operation. Paired arguments
+ * are packed into one write, paired results come from one read.
+ *
+ * Typical settings (precision is in units of 4 iterations, one per clock
+ * cycle of latency):
+ *
+ * | Function                     | Arguments    | Results          | q1.15 | q1.31 |
+ * |------------------------------|--------------|------------------|-------|-------|
+ * | COS                          | angle, m     | m.cos, m.sin     | 4     | 6     |
+ * | SIN                          | angle, m     | m.sin, m.cos     | 4     | 6     |
+ * | PHASE (atan2)                | x, y         | phase, modulus   | 4     | 6     |
+ * | MODULUS                      | x, y         | modulus, phase   | 4     | 6     |
+ * | ATAN                         | x            | atan(x)          | 4     | 6     |
+ * | COSH                         | x            | cosh, sinh       | 4     | 6     |
+ * | SINH                         | x            | sinh, cosh       | 4     | 6     |
+ * | ATANH                        | x            | atanh(x)         | 4     | 6     |
+ * | LN                           | x            | ln(x)            | 4     | 6     |
+ * | SQRT                         | x            | sqrt(x)          | 4     | 6     |
+ *
+ * Angles are in units of pi. ATAN, the hyperbolic functions, LN and SQRT
+ * need a scaling factor to bring their arguments into range, see the
+ * reference manual for the ranges and the residual error of each setting.
+ *
+ * @param[in] function function of type @ref cordic_csr_function
+ * @param[in] in arguments
+ * @param[out] out results
+ * @param[in] n number of operations
+ *
+ */
+void cordic_compute_q15(uint8_t function, const int16_t *in, int16_t *out, uint32_t n) {
+        uint8_t nargs = cordic_function_arguments(function);
+        uint8_t nres = cordic_function_results(function);
+        uint32_t result;
+
+        cordic_configure_q15(function);
+        if (n == 0) {
+                return;
+        }
+
+        CORDIC_WDATA = nargs == 2 ? (uint16_t)in[0] | (uint32_t)(uint16_t)in[1] << 16
+                                  : (uint16_t)in[0];
+        in += nargs;
+        while (--n) {
+                CORDIC_WDATA = nargs == 2 ? (uint16_t)in[0] | (uint32_t)(uint16_t)in[1] << 16
+                                          : (uint16_t)in[0];
+                in += nargs;
+                result = CORDIC_RDATA;
+                out[0] = result;
+                if (nres == 2) {
+                        out[1] = result >> 16;
+                }
+                out += nres;
+        }
+        result = CORDIC_RDATA;
+        out[0] = result;
+        if (nres == 2) {
+                out[1] = result >> 16;
+        }
+}
+
+/** @brief Compute a batch of q1.31 operations
+ *
+ * Like cordic_compute_q15(), with one 32 bit write per argument and one
+ * 32 bit read per result.
+ *
+ * @param[in] function function of type @ref cordic_csr_function
+ * @param[in] in arguments, cordic_function_arguments() per operation
+ * @param[out] out results, cordic_function_results() per operation
+ * @param[in] n number of operations
+ *
+ */
+void cordic_compute_q31(uint8_t function, const int32_t *in, int32_t *out, uint32_t n) {
+        uint8_t nargs = cordic_function_arguments(function);
+        uint8_t nres = cordic_function_results(function);
+
+        cordic_configure_q31(function);
+        if (n == 0) {
+                return;
+        }
+
+        CORDIC_WDATA = in[0];
+        if (nargs == 2) {
+                CORDIC_WDATA = in[1];
+        }
+        in += nargs;
+        while (--n) {
+                CORDIC_WDATA = in[0];
+                if (nargs == 2) {
+                        CORDIC_WDATA = in[1];
+                }
+                in += nargs;
+                out[0] = CORDIC_RDATA;
+                if (nres == 2) {
+                        out[1] = CORDIC_RDATA;
+                }
+                out += nres;
+        }
+        out[0] = CORDIC_RDATA;
+        if (nres == 2) {
+                out[1] = CORDIC_RDATA;
+        }
+}
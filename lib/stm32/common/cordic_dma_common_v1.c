@@ -0,0 +1,258 @@
+/** @defgroup cordic_dma_file CORDIC DMA batches
+@ingroup peripheral_apis
+
+@brief DMA driven batches of CORDIC operations.
+
+The vectors of both DMA channels must call dma_xfer_irq_handler(). Batches of
+any length are split into DMA transfers of at most 65535 items internally.
+
+LGPL License Terms @ref lgpl_license
+*/
+/*
+ * This file is part of the libopencm3 project.
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**@{*/
+
+#include <libopencm3/stm32/cordic_dma.h>
+
+#define CORDIC_DMA_CHUNK	0xffff
+
+static void cordic_dma_next(struct cordic_dma *c)
+{
+	uint8_t words = c->in_words > c->out_words ? c->in_words : c->out_words;
+	uint32_t n = CORDIC_DMA_CHUNK / words;
+
+	if (n > c->left) {
+		n = c->left;
+	}
+
+	c->wr_xfer.src = c->in;
+	c->wr_xfer.count = n * c->in_words;
+	c->rd_xfer.dst = c->out;
+	c->rd_xfer.count = n * c->out_words;
+	c->in += n * c->in_step;
+	c->out += n * c->out_step;
+	c->left -= n;
+
+	dma_xfer_submit(&c->rd_xfer);
+	dma_xfer_submit(&c->wr_xfer);
+}
+
+static void cordic_dma_finish(struct cordic_dma *c)
+{
+	cordic_disable_dma_write();
+	cordic_disable_dma_read();
+	c->busy = false;
+	if (c->callback) {
+		c->callback(c);
+	}
+}
+
+static void cordic_dma_rd_event(struct dma_xfer *xfer, uint32_t events)
+{
+	struct cordic_dma *c = xfer->user;
+
+	if (events & DMA_XFER_EVT_ERROR) {
+		c->error = true;
+		dma_xfer_abort(&c->wr_xfer);
+		cordic_dma_finish(c);
+	} else if (events & DMA_XFER_EVT_COMPLETE) {
+		if (c->left) {
+			cordic_dma_next(c);
+		} else {
+			cordic_dma_finish(c);
+		}
+	}
+}
+
+static void cordic_dma_wr_event(struct dma_xfer *xfer, uint32_t events)
+{
+	struct cordic_dma *c = xfer->user;
+
+	/* Completion is taken from the read side, which finishes last. */
+	if (events & DMA_XFER_EVT_ERROR) {
+		c->error = true;
+		dma_xfer_abort(&c->rd_xfer);
+		cordic_dma_finish(c);
+	}
+}
+
+static bool cordic_dma_start(struct cordic_dma *c, uint32_t in, uint32_t out,
+			     uint32_t n)
+{
+	c->error = false;
+	if (n == 0) {
+		if (c->callback) {
+			c->callback(c);
+		}
+		return true;
+	}
+
+	c->in = in;
+	c->out = out;
+	c->left = n;
+	c->busy = true;
+	cordic_dma_next(c);
+	cordic_enable_dma_read();
+	cordic_enable_dma_write();
+	return true;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief CORDIC DMA Initialise
+
+@param[in] c CORDIC DMA state, callback and user fields filled in
+@param[in] dma DMA controller base address: DMA1 or DMA2
+@param[in] wr_channel DMA channel connected to the CORDIC write request
+@param[in] wr_request Request routing of the write side, see struct dma_xfer
+@param[in] rd_channel DMA channel connected to the CORDIC read request
+@param[in] rd_request Request routing of the read side, see struct dma_xfer
+@returns false if one of the DMA channels is in use
+*/
+bool cordic_dma_init(struct cordic_dma *c, uint32_t dma,
+		     uint8_t wr_channel, uint8_t wr_request,
+		     uint8_t rd_channel, uint8_t rd_request)
+{
+	c->busy = false;
+	c->left = 0;
+
+	c->wr_xfer.dst = (uint32_t)&CORDIC_WDATA;
+	c->wr_xfer.direction = DMA_XFER_MEM_TO_PERIPH;
+	c->wr_xfer.flags = DMA_XFER_SRC_INC;
+	c->wr_xfer.priority = 2;
+	c->wr_xfer.request = wr_request;
+	c->wr_xfer.callback = cordic_dma_wr_event;
+	c->wr_xfer.user = c;
+
+	c->rd_xfer.src = (uint32_t)&CORDIC_RDATA;
+	c->rd_xfer.direction = DMA_XFER_PERIPH_TO_MEM;
+	c->rd_xfer.flags = DMA_XFER_DST_INC;
+	c->rd_xfer.priority = 3;
+	c->rd_xfer.request = rd_request;
+	c->rd_xfer.callback = cordic_dma_rd_event;
+	c->rd_xfer.user = c;
+
+	if (!dma_xfer_claim(&c->wr_xfer, dma, wr_channel)) {
+		return false;
+	}
+	if (!dma_xfer_claim(&c->rd_xfer, dma, rd_channel)) {
+		dma_xfer_release(&c->wr_xfer);
+		return false;
+	}
+	return true;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief CORDIC DMA Compute a Batch of q1.15 Operations
+
+The precision and scaling factor are taken from the CORDIC as set with
+cordic_set_precision() and cordic_set_scaling_factor().
+
+@param[in] c CORDIC DMA state
+@param[in] function Function of type @ref cordic_csr_function
+@param[in] in Arguments, word aligned for functions with two arguments
+@param[out] out Results, word aligned for functions with two results
+@param[in] n Number of operations
+@returns false if a batch is already in progress
+*/
+bool cordic_compute_q15_dma(struct cordic_dma *c, uint8_t function,
+			    const int16_t *in, int16_t *out, uint32_t n)
+{
+	uint8_t nargs = cordic_function_arguments(function);
+	uint8_t nres = cordic_function_results(function);
+
+	if (c->busy) {
+		return false;
+	}
+
+	/* One transfer per operation on each side, widened or narrowed by
+	 * the DMA when there is a single argument or result. */
+	c->in_words = 1;
+	c->out_words = 1;
+	c->in_step = nargs * 2;
+	c->out_step = nres * 2;
+	c->wr_xfer.src_width = nargs == 2 ? DMA_XFER_WIDTH_32BIT :
+					    DMA_XFER_WIDTH_16BIT;
+	c->wr_xfer.dst_width = DMA_XFER_WIDTH_32BIT;
+	c->rd_xfer.src_width = DMA_XFER_WIDTH_32BIT;
+	c->rd_xfer.dst_width = nres == 2 ? DMA_XFER_WIDTH_32BIT :
+					   DMA_XFER_WIDTH_16BIT;
+
+	cordic_configure_q15(function);
+	return cordic_dma_start(c, (uint32_t)in, (uint32_t)out, n);
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief CORDIC DMA Compute a Batch of q1.31 Operations
+
+The precision and scaling factor are taken from the CORDIC as set with
+cordic_set_precision() and cordic_set_scaling_factor().
+
+@param[in] c CORDIC DMA state
+@param[in] function Function of type @ref cordic_csr_function
+@param[in] in Arguments
+@param[out] out Results
+@param[in] n Number of operations
+@returns false if a batch is already in progress
+*/
+bool cordic_compute_q31_dma(struct cordic_dma *c, uint8_t function,
+			    const int32_t *in, int32_t *out, uint32_t n)
+{
+	uint8_t nargs = cordic_function_arguments(function);
+	uint8_t nres = cordic_function_results(function);
+
+	if (c->busy) {
+		return false;
+	}
+
+	c->in_words = nargs;
+	c->out_words = nres;
+	c->in_step = nargs * 4;
+	c->out_step = nres * 4;
+	c->wr_xfer.src_width = DMA_XFER_WIDTH_32BIT;
+	c->wr_xfer.dst_width = DMA_XFER_WIDTH_32BIT;
+	c->rd_xfer.src_width = DMA_XFER_WIDTH_32BIT;
+	c->rd_xfer.dst_width = DMA_XFER_WIDTH_32BIT;
+
+	cordic_configure_q31(function);
+	return cordic_dma_start(c, (uint32_t)in, (uint32_t)out, n);
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief CORDIC DMA Busy
+
+@param[in] c CORDIC DMA state
+@returns true while a batch is in progress
+*/
+bool cordic_dma_busy(const struct cordic_dma *c)
+{
+	return c->busy;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief CORDIC DMA Wait for Completion
+
+The DMA interrupts must be able to run.
+
+@param[in] c CORDIC DMA state
+*/
+void cordic_dma_wait(const struct cordic_dma *c)
+{
+	while (c->busy);
+}
+
+/**@}*/
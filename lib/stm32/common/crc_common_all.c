@@ -50,5 +50,41 @@ uint32_t crc_calculate_block(uint32_t *datap, int size)
 
 	return CRC_DR;
 }
+
+uint32_t crc_calculate_bytes(const void *data, uint32_t len)
+{
+	const uint8_t *p = data;
+
+	if (((uint32_t)p & 3) == 0) {
+		for (; len >= 4; len -= 4, p += 4) {
+			CRC_DR = __builtin_bswap32(*(const uint32_t *)p);
+		}
+	} else {
+		for (; len >= 4; len -= 4, p += 4) {
+			CRC_DR = ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+				 ((uint32_t)p[2] << 8) | p[3];
+		}
+	}
+
+#if defined(CRC_DR8)
+	while (len--) {
+		CRC_DR8 = *p++;
+	}
+	return CRC_DR;
+#else
+	/* The fixed CRC-32 polynomial, processed MSB first like the unit */
+	uint32_t crc = CRC_DR;
+	int k;
+
+	while (len--) {
+		crc ^= (uint32_t)*p++ << 24;
+		for (k = 0; k < 8; k++) {
+			crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04C11DB7 :
+			      crc << 1;
+		}
+	}
+	return crc;
+#endif
+}
 /**@}*/
 
@@ -0,0 +1,149 @@
+/** @defgroup crc_dma_file CRC DMA
+@ingroup peripheral_apis
+
+@brief DMA fed calculations for the STM32 CRC unit.
+
+The channel must be able to do memory to memory transfers (only DMA2 on
+F2/F4/F7), and its vector must call dma_xfer_irq_handler().
+
+LGPL License Terms @ref lgpl_license
+*/
+/*
+ * This file is part of the libopencm3 project.
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**@{*/
+
+#include <libopencm3/stm32/crc_dma.h>
+
+#define CRC_DMA_CHUNK	0xffff
+
+static void crc_dma_next(struct crc_dma *c)
+{
+	uint32_t n = (c->left > CRC_DMA_CHUNK) ? CRC_DMA_CHUNK : c->left;
+
+	c->xfer.src = c->next;
+	c->xfer.count = n;
+	c->next += n * 4;
+	c->left -= n;
+	dma_xfer_submit(&c->xfer);
+}
+
+static void crc_dma_event(struct dma_xfer *xfer, uint32_t events)
+{
+	struct crc_dma *c = xfer->user;
+
+	if (events & DMA_XFER_EVT_ERROR) {
+		c->error = true;
+		c->left = 0;
+	} else if (!(events & DMA_XFER_EVT_COMPLETE)) {
+		return;
+	}
+
+	if (c->left) {
+		crc_dma_next(c);
+		return;
+	}
+
+	c->busy = false;
+	if (c->callback) {
+		c->callback(c, CRC_DR);
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief CRC DMA Initialise
+
+@param[in] c CRC DMA state, callback and user fields filled in
+@param[in] dma DMA controller base address: DMA1 or DMA2
+@param[in] channel DMA stream or channel capable of memory to memory
+@returns false if the DMA stream or channel is in use
+*/
+bool crc_dma_init(struct crc_dma *c, uint32_t dma, uint8_t channel)
+{
+	c->busy = false;
+	c->left = 0;
+
+	c->xfer.dst = (uint32_t)&CRC_DR;
+	c->xfer.direction = DMA_XFER_MEM_TO_MEM;
+	c->xfer.src_width = DMA_XFER_WIDTH_32BIT;
+	c->xfer.dst_width = DMA_XFER_WIDTH_32BIT;
+	c->xfer.flags = DMA_XFER_SRC_INC;
+	c->xfer.priority = 0;
+	c->xfer.request = 0;
+	c->xfer.callback = crc_dma_event;
+	c->xfer.user = c;
+
+	return dma_xfer_claim(&c->xfer, dma, channel);
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief CRC DMA Start
+
+Adds a region of words to the current calculation. Use crc_reset() first to
+start a new one.
+
+@param[in] c CRC DMA state
+@param[in] data Start of the region, word aligned
+@param[in] words Length of the region, in 32 bit words
+@returns false if a calculation is already in progress
+*/
+bool crc_dma_start(struct crc_dma *c, const uint32_t *data, uint32_t words)
+{
+	if (c->busy) {
+		return false;
+	}
+	c->error = false;
+	if (words == 0) {
+		if (c->callback) {
+			c->callback(c, CRC_DR);
+		}
+		return true;
+	}
+
+	c->next = (uint32_t)data;
+	c->left = words;
+	c->busy = true;
+	crc_dma_next(c);
+	return true;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief CRC DMA Busy
+
+@param[in] c CRC DMA state
+@returns true while the region is being fed
+*/
+bool crc_dma_busy(const struct crc_dma *c)
+{
+	return c->busy;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief CRC DMA Wait for Completion
+
+The DMA interrupt must be able to run.
+
+@param[in] c CRC DMA state
+@returns CRC calculator value
+*/
+uint32_t crc_dma_wait(const struct crc_dma *c)
+{
+	while (c->busy);
+	return CRC_DR;
+}
+
+/**@}*/
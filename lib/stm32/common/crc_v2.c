@@ -112,5 +112,33 @@ void crc_set_initial(uint32_t initial)
 	CRC_INIT = initial;
 }
 
+/*---------------------------------------------------------------------------*/
+/** @brief Configure the CRC algorithm.
+
+ Sets polynomial, size and initial value in one go and restarts the
+ calculation. A reflected algorithm reverses the bits of each input byte and
+ of the result, for use with crc_calculate_bytes(). Any final XOR has to be
+ applied to the result by the caller.
+
+ For example the CRC-32 of zlib and Ethernet is
+ crc_configure(CRC_POL_DEFAULT, CRC_CR_POLYSIZE_32, 0xffffffff, true), with
+ the result inverted, and CRC-16/CCITT-FALSE is
+ crc_configure(0x1021, CRC_CR_POLYSIZE_16, 0xffff, false).
+
+ @param[in] polynomial Unsigned int32. Polynomial coefficient.
+ @param[in] polysize Unsigned int32. Size of polynomial @ref crc_polysize.
+ @param[in] initial Unsigned int32. CRC initial value.
+ @param[in] reflected Bool. Reflect input bytes and output.
+ */
+void crc_configure(uint32_t polynomial, uint32_t polysize,
+		   uint32_t initial, bool reflected)
+{
+	CRC_POL = polynomial;
+	CRC_INIT = initial;
+	CRC_CR = polysize |
+		 (reflected ? (CRC_CR_REV_IN_BYTE | CRC_CR_REV_OUT) : 0) |
+		 CRC_CR_RESET;
+}
+
 /**@}*/
 
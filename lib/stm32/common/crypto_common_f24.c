@@ -36,6 +36,9 @@
 
 #define CRYP_CR_ALGOMODE_MASK	((1 << 19) | CRYP_CR_ALGOMODE)
 
+/* IV0LR, IV0RR, IV1LR, IV1RR as 32 bit registers */
+#define CRYP_IVR32(i)		MMIO32(CRYP_BASE + 0x40 + (i) * 4)
+
 /**
  * @brief Wait, if the Controller is busy
  */
@@ -172,4 +175,49 @@ uint32_t crypto_process_block(uint32_t *inp, uint32_t *outp, uint32_t length)
 	return wr;
 }
 
+/**
+ * @brief Save the context of a suspended operation
+ *
+ * Stops the processor between blocks so that it can be used for another
+ * message. No transfer may be in progress. The key registers are write
+ * only: before crypto_context_restore(), set the key and the algorithm
+ * again with crypto_set_key() and crypto_set_algorithm(). The GCM/CCM
+ * context registers are not saved, see crypto_context_swap().
+ *
+ * @param[out] ctx Context storage
+ */
+void crypto_context_save(struct crypto_context *ctx)
+{
+	int i;
+
+	while (!(CRYP_SR & CRYP_SR_IFEM));
+	crypto_wait_busy();
+	crypto_stop();
+
+	ctx->cr = CRYP_CR & ~CRYP_CR_FFLUSH;
+	for (i = 0; i < 4; i++) {
+		ctx->iv[i] = CRYP_IVR32(i);
+	}
+}
+
+/**
+ * @brief Restore the context of a suspended operation
+ *
+ * The processor is left disabled, start it with crypto_start() or one of
+ * the processing functions.
+ *
+ * @param[in] ctx Context storage
+ */
+void crypto_context_restore(const struct crypto_context *ctx)
+{
+	int i;
+
+	crypto_wait_busy();
+	CRYP_CR = ctx->cr & ~CRYP_CR_CRYPEN;
+	for (i = 0; i < 4; i++) {
+		CRYP_IVR32(i) = ctx->iv[i];
+	}
+	CRYP_CR |= CRYP_CR_FFLUSH;
+}
+
 /**@}*/
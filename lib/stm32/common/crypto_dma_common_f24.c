@@ -0,0 +1,349 @@
+/** @defgroup crypto_dma_file HASH and CRYP DMA
+@ingroup peripheral_apis
+
+@brief DMA streaming to the STM32F2/F4 HASH and CRYP processors.
+
+The vectors of the DMA streams must call dma_xfer_irq_handler(), and the
+HASH_RNG vector hash_dma_irq_handler() when hashing.
+
+LGPL License Terms @ref lgpl_license
+*/
+/*
+ * This file is part of the libopencm3 project.
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**@{*/
+
+#include <libopencm3/stm32/crypto_dma.h>
+
+#define CRYPTO_DMA_CHUNK	0xffff
+
+/*---------------------------------------------------------------------------*/
+/* HASH */
+
+static void hash_dma_next(struct hash_dma *h)
+{
+	uint32_t n = (h->left > CRYPTO_DMA_CHUNK) ? CRYPTO_DMA_CHUNK : h->left;
+
+	h->left -= n;
+	if (h->last && h->left == 0) {
+		/* The end of this transfer starts the digest calculation. */
+		HASH_STR = (HASH_STR & ~HASH_STR_NBW) | h->last_bits;
+		HASH_CR &= ~HASH_CR_MDMAT;
+	} else {
+		HASH_CR |= HASH_CR_MDMAT;
+	}
+
+	h->xfer.src = h->next;
+	h->xfer.count = n;
+	h->next += n * 4;
+	HASH_CR |= HASH_CR_DMAE;
+	dma_xfer_submit(&h->xfer);
+}
+
+static void hash_dma_finish(struct hash_dma *h)
+{
+	h->busy = false;
+	if (h->callback) {
+		h->callback(h);
+	}
+}
+
+static void hash_dma_event(struct dma_xfer *xfer, uint32_t events)
+{
+	struct hash_dma *h = xfer->user;
+
+	if (events & DMA_XFER_EVT_ERROR) {
+		h->error = true;
+		h->left = 0;
+	} else if (!(events & DMA_XFER_EVT_COMPLETE)) {
+		return;
+	}
+
+	if (h->left) {
+		hash_dma_next(h);
+		return;
+	}
+
+	if (h->last && !h->error) {
+		/* Finished by hash_dma_irq_handler() once the digest is ready */
+		HASH_IMR |= HASH_IMR_DCIE;
+		return;
+	}
+	hash_dma_finish(h);
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief HASH DMA Initialise
+
+@param[in] h HASH DMA state, callback and user fields filled in
+@param[in] dma DMA controller base address: DMA2
+@param[in] stream DMA stream connected to HASH_IN
+@param[in] request Request routing, see struct dma_xfer
+@returns false if the DMA stream is in use
+*/
+bool hash_dma_init(struct hash_dma *h, uint32_t dma, uint8_t stream,
+		   uint8_t request)
+{
+	h->busy = false;
+	h->left = 0;
+
+	h->xfer.dst = (uint32_t)&HASH_DIN;
+	h->xfer.direction = DMA_XFER_MEM_TO_PERIPH;
+	h->xfer.src_width = DMA_XFER_WIDTH_32BIT;
+	h->xfer.dst_width = DMA_XFER_WIDTH_32BIT;
+	h->xfer.flags = DMA_XFER_SRC_INC;
+	h->xfer.priority = 1;
+	h->xfer.request = request;
+	h->xfer.callback = hash_dma_event;
+	h->xfer.user = h;
+
+	return dma_xfer_claim(&h->xfer, dma, stream);
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief HASH DMA Add a Buffer to the Message
+
+The processor must have been set up and initialised with hash_init() for
+the first buffer of a message. Once the last buffer has been hashed, the
+result can be read with hash_get_result().
+
+@param[in] h HASH DMA state
+@param[in] data Buffer, word aligned
+@param[in] len Length in bytes, a multiple of 4 unless @p last is set
+@param[in] last Set for the final buffer of the message
+@returns false if a buffer is still in progress or @p len is invalid
+*/
+bool hash_dma_update(struct hash_dma *h, const void *data, uint32_t len,
+		     bool last)
+{
+	if (h->busy || (!last && (len & 3))) {
+		return false;
+	}
+
+	h->error = false;
+	h->next = (uint32_t)data;
+	h->left = (len + 3) / 4;
+	h->last_bits = (len & 3) * 8;
+	h->last = last;
+
+	if (h->left == 0) {
+		if (last) {
+			h->busy = true;
+			HASH_STR = (HASH_STR & ~HASH_STR_NBW);
+			hash_digest();
+			HASH_IMR |= HASH_IMR_DCIE;
+		} else if (h->callback) {
+			h->callback(h);
+		}
+		return true;
+	}
+
+	h->busy = true;
+	hash_dma_next(h);
+	return true;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief HASH DMA Interrupt Handler
+
+Call this from the HASH_RNG vector, enabled in the NVIC. It completes the
+final buffer of a message once the digest has been calculated.
+
+@param[in] h HASH DMA state
+*/
+void hash_dma_irq_handler(struct hash_dma *h)
+{
+	if (!(HASH_IMR & HASH_IMR_DCIE) || !(HASH_SR & HASH_SR_DCIS)) {
+		return;
+	}
+
+	HASH_IMR &= ~HASH_IMR_DCIE;
+	hash_dma_finish(h);
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief HASH DMA Busy
+
+@param[in] h HASH DMA state
+@returns true while a buffer is being hashed
+*/
+bool hash_dma_busy(const struct hash_dma *h)
+{
+	return h->busy;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief HASH DMA Wait for the Buffer
+
+The DMA interrupt must be able to run.
+
+@param[in] h HASH DMA state
+*/
+void hash_dma_wait(const struct hash_dma *h)
+{
+	while (h->busy);
+}
+
+/*---------------------------------------------------------------------------*/
+/* CRYP */
+
+static void crypto_dma_finish(struct crypto_dma *c)
+{
+	CRYP_DMACR = 0;
+	c->busy = false;
+	if (c->callback) {
+		c->callback(c);
+	}
+}
+
+static void crypto_dma_out_event(struct dma_xfer *xfer, uint32_t events)
+{
+	struct crypto_dma *c = xfer->user;
+
+	if (events & DMA_XFER_EVT_ERROR) {
+		c->error = true;
+		dma_xfer_abort(&c->in);
+	} else if (!(events & DMA_XFER_EVT_COMPLETE)) {
+		return;
+	}
+	crypto_dma_finish(c);
+}
+
+static void crypto_dma_in_event(struct dma_xfer *xfer, uint32_t events)
+{
+	struct crypto_dma *c = xfer->user;
+
+	/* Completion is taken from the output side, which finishes last. */
+	if (events & DMA_XFER_EVT_ERROR) {
+		c->error = true;
+		dma_xfer_abort(&c->out);
+		crypto_dma_finish(c);
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief CRYP DMA Initialise
+
+@param[in] c CRYP DMA state, callback and user fields filled in
+@param[in] dma DMA controller base address: DMA2
+@param[in] in_stream DMA stream connected to CRYP_IN
+@param[in] in_request Request routing of CRYP_IN, see struct dma_xfer
+@param[in] out_stream DMA stream connected to CRYP_OUT
+@param[in] out_request Request routing of CRYP_OUT, see struct dma_xfer
+@returns false if one of the DMA streams is in use
+*/
+bool crypto_dma_init(struct crypto_dma *c, uint32_t dma,
+		     uint8_t in_stream, uint8_t in_request,
+		     uint8_t out_stream, uint8_t out_request)
+{
+	c->busy = false;
+
+	c->in.dst = (uint32_t)&CRYP_DIN;
+	c->in.direction = DMA_XFER_MEM_TO_PERIPH;
+	c->in.src_width = DMA_XFER_WIDTH_32BIT;
+	c->in.dst_width = DMA_XFER_WIDTH_32BIT;
+	c->in.flags = DMA_XFER_SRC_INC;
+	c->in.priority = 1;
+	c->in.request = in_request;
+	c->in.callback = crypto_dma_in_event;
+	c->in.user = c;
+
+	c->out.src = (uint32_t)&CRYP_DOUT;
+	c->out.direction = DMA_XFER_PERIPH_TO_MEM;
+	c->out.src_width = DMA_XFER_WIDTH_32BIT;
+	c->out.dst_width = DMA_XFER_WIDTH_32BIT;
+	c->out.flags = DMA_XFER_DST_INC;
+	c->out.priority = 2;
+	c->out.request = out_request;
+	c->out.callback = crypto_dma_out_event;
+	c->out.user = c;
+
+	if (!dma_xfer_claim(&c->in, dma, in_stream)) {
+		return false;
+	}
+	if (!dma_xfer_claim(&c->out, dma, out_stream)) {
+		dma_xfer_release(&c->in);
+		return false;
+	}
+	return true;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief CRYP DMA Process a Buffer
+
+The DMA counterpart of crypto_process_block(). Key, initialisation vector,
+data type and algorithm must have been set up. The processor is started if
+it is not running yet.
+
+@param[in] c CRYP DMA state
+@param[in] inp Input words, word aligned
+@param[out] outp Output words, word aligned
+@param[in] length Number of words, a whole number of cipher blocks
+@returns false if a buffer is still in progress
+*/
+bool crypto_process_block_dma(struct crypto_dma *c, const uint32_t *inp,
+			      uint32_t *outp, uint16_t length)
+{
+	if (c->busy) {
+		return false;
+	}
+
+	c->error = false;
+	if (length == 0) {
+		if (c->callback) {
+			c->callback(c);
+		}
+		return true;
+	}
+
+	c->busy = true;
+	c->out.dst = (uint32_t)outp;
+	c->out.count = length;
+	c->in.src = (uint32_t)inp;
+	c->in.count = length;
+
+	dma_xfer_submit(&c->out);
+	dma_xfer_submit(&c->in);
+	CRYP_DMACR = CRYP_DMACR_DIEN | CRYP_DMACR_DOEN;
+	crypto_start();
+	return true;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief CRYP DMA Busy
+
+@param[in] c CRYP DMA state
+@returns true while a buffer is being processed
+*/
+bool crypto_dma_busy(const struct crypto_dma *c)
+{
+	return c->busy;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief CRYP DMA Wait for the Buffer
+
+The DMA interrupts must be able to run.
+
+@param[in] c CRYP DMA state
+*/
+void crypto_dma_wait(const struct crypto_dma *c)
+{
+	while (c->busy);
+}
+
+/**@}*/
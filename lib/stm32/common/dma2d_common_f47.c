@@ -7,6 +7,16 @@
  * This library supports the DMA2D Peripheral in the STM32F4xx and STM32F7xx
  * series of ARM Cortex Microcontrollers by ST Microelectronics.
  *
+ * Fills, copies, pixel format conversions, blends and CLUT loads are
+ * described by a struct dma2d_op and queued with dma2d_submit(), which
+ * returns at once. The operations run back to back, each one started from
+ * the interrupt of the previous one, so the CPU keeps rendering while the
+ * DMA2D draws. The DMA2D vector must call dma2d_irq_handler() and be
+ * enabled in the NVIC.
+ *
+ * After dma2d_set_software(), the same operations are rendered by the CPU
+ * instead, on parts without a DMA2D or to check its output.
+ *
  * LGPL License Terms @ref lgpl_license
  */
 /*
@@ -26,8 +36,562 @@
  * along with this library.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-#include <libopencm3/stm32/common/dma2d_common_f47.h>
+#include <stddef.h>
+#include <string.h>
+#include <libopencm3/cm3/cortex.h>
+#include <libopencm3/stm32/dma2d.h>
 
 /**@{*/
 
+#define DMA2D_IRQ_ENABLES	(DMA2D_CR_CEIE | DMA2D_CR_CTCIE | \
+				 DMA2D_CR_CAEIE | DMA2D_CR_TCIE | \
+				 DMA2D_CR_TEIE)
+#define DMA2D_ISR_ERRORS	(DMA2D_ISR_CEIF | DMA2D_ISR_CAEIF | \
+				 DMA2D_ISR_TEIF)
+#define DMA2D_ISR_ALL		(DMA2D_ISR_ERRORS | DMA2D_ISR_CTCIF | \
+				 DMA2D_ISR_TWIF | DMA2D_ISR_TCIF)
+
+static struct dma2d_op *volatile dma2d_head;
+static struct dma2d_op *dma2d_tail;
+
+/* Software rendering: selected, draining the queue, foreground CLUT */
+static bool dma2d_soft;
+static bool dma2d_soft_busy;
+static uint32_t dma2d_soft_clut[256];
+
+/* Bits per pixel, indexed by DMA2D_xPFCCR_CM_* */
+static const uint8_t dma2d_bits[] = {
+	32, 24, 16, 16, 16, 8, 8, 16, 4, 8, 4
+};
+
+/* Rounded down to a byte for the 4 bit formats */
+static uint32_t dma2d_address(const struct dma2d_surface *s,
+			      uint16_t x, uint16_t y)
+{
+	return (uint32_t)s->pixels +
+	       ((uint32_t)y * s->stride + x) * dma2d_bits[s->format] / 8;
+}
+
+static void dma2d_op_clear(struct dma2d_op *op, uint32_t mode,
+			   const struct dma2d_surface *dst,
+			   uint16_t x, uint16_t y, uint16_t w, uint16_t h)
+{
+	op->cr = mode << DMA2D_CR_MODE_SHIFT;
+	op->fgmar = 0;
+	op->fgor = 0;
+	op->fgpfccr = 0;
+	op->fgcolr = 0;
+	op->fgcmar = 0;
+	op->bgmar = 0;
+	op->bgor = 0;
+	op->bgpfccr = 0;
+	op->opfccr = dst ? dst->format : 0;
+	op->ocolr = 0;
+	op->omar = dst ? dma2d_address(dst, x, y) : 0;
+	op->oor = dst ? dst->stride - w : 0;
+	op->nlr = ((uint32_t)w << DMA2D_NLR_PL_SHIFT) | h;
+}
+
+static void dma2d_start(struct dma2d_op *op)
+{
+	op->error = false;
+
+	if (op->fgpfccr & DMA2D_xPFCCR_START) {
+		/* CLUT load, runs on its own and raises CTCIF. */
+		DMA2D_CR = DMA2D_IRQ_ENABLES;
+		DMA2D_FGCMAR = op->fgcmar;
+		DMA2D_FGPFCCR = op->fgpfccr;
+		return;
+	}
+
+	DMA2D_FGMAR = op->fgmar;
+	DMA2D_FGOR = op->fgor;
+	DMA2D_FGPFCCR = op->fgpfccr;
+	DMA2D_FGCOLR = op->fgcolr;
+	DMA2D_BGMAR = op->bgmar;
+	DMA2D_BGOR = op->bgor;
+	DMA2D_BGPFCCR = op->bgpfccr;
+	DMA2D_OPFCCR = op->opfccr;
+	DMA2D_OCOLR = op->ocolr;
+	DMA2D_OMAR = op->omar;
+	DMA2D_OOR = op->oor;
+	DMA2D_NLR = op->nlr;
+	DMA2D_CR = op->cr | DMA2D_IRQ_ENABLES | DMA2D_CR_START;
+}
+
+/* Widen a colour component to 8 bits, repeating its top bits */
+#define DMA2D_EXPAND5(c)	(((c) << 3) | ((c) >> 2))
+#define DMA2D_EXPAND6(c)	(((c) << 2) | ((c) >> 4))
+
+/* Pixel i from p, as ARGB8888 before the alpha mode is applied */
+static uint32_t dma2d_soft_read(const uint8_t *p, uint32_t i,
+				uint32_t pfccr, uint32_t color)
+{
+	uint32_t v;
+
+	switch (pfccr & DMA2D_xPFCCR_CM_MASK) {
+	case DMA2D_xPFCCR_CM_ARGB8888:
+		p += i * 4;
+		return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+	case DMA2D_xPFCCR_CM_RGB888:
+		p += i * 3;
+		return 0xff000000 | p[0] | (p[1] << 8) | (p[2] << 16);
+	case DMA2D_xPFCCR_CM_RGB565:
+		v = p[i * 2] | (p[i * 2 + 1] << 8);
+		return 0xff000000 | (DMA2D_EXPAND5(v >> 11) << 16) |
+		       (DMA2D_EXPAND6((v >> 5) & 0x3f) << 8) |
+		       DMA2D_EXPAND5(v & 0x1f);
+	case DMA2D_xPFCCR_CM_ARGB1555:
+		v = p[i * 2] | (p[i * 2 + 1] << 8);
+		return ((v & 0x8000) ? 0xff000000 : 0) |
+		       (DMA2D_EXPAND5((v >> 10) & 0x1f) << 16) |
+		       (DMA2D_EXPAND5((v >> 5) & 0x1f) << 8) |
+		       DMA2D_EXPAND5(v & 0x1f);
+	case DMA2D_xPFCCR_CM_ARGB4444:
+		v = p[i * 2] | (p[i * 2 + 1] << 8);
+		return ((v >> 12) * 17 << 24) | (((v >> 8) & 0xf) * 17 << 16) |
+		       (((v >> 4) & 0xf) * 17 << 8) | ((v & 0xf) * 17);
+	case DMA2D_xPFCCR_CM_L8:
+		return dma2d_soft_clut[p[i]];
+	case DMA2D_xPFCCR_CM_AL44:
+		v = p[i];
+		return ((v >> 4) * 17 << 24) |
+		       (dma2d_soft_clut[v & 0xf] & 0xffffff);
+	case DMA2D_xPFCCR_CM_AL88:
+		v = p[i * 2] | (p[i * 2 + 1] << 8);
+		return ((v >> 8) << 24) | (dma2d_soft_clut[v & 0xff] & 0xffffff);
+	case DMA2D_xPFCCR_CM_L4:
+		/* The first pixel of a byte is in its low nibble */
+		return dma2d_soft_clut[(p[i / 2] >> ((i & 1) * 4)) & 0xf];
+	case DMA2D_xPFCCR_CM_A8:
+		return ((uint32_t)p[i] << 24) | color;
+	case DMA2D_xPFCCR_CM_A4:
+		v = (p[i / 2] >> ((i & 1) * 4)) & 0xf;
+		return (v * 17 << 24) | color;
+	default:
+		return 0;
+	}
+}
+
+static uint32_t dma2d_soft_alpha(uint32_t argb, uint32_t pfccr)
+{
+	uint32_t a = argb >> 24;
+	uint32_t alpha = (pfccr >> DMA2D_xPFCCR_ALPHA_SHIFT) &
+			 DMA2D_xPFCCR_ALPHA_MASK;
+
+	switch ((pfccr >> DMA2D_xPFCCR_AM_SHIFT) & DMA2D_xPFCCR_AM_MASK) {
+	case DMA2D_xPFCCR_AM_FORCE:
+		a = alpha;
+		break;
+	case DMA2D_xPFCCR_AM_PRODUCT:
+		a = a * alpha / 255;
+		break;
+	default:
+		break;
+	}
+
+	return (argb & 0xffffff) | (a << 24);
+}
+
+/* Foreground over background, with the formula of the reference manual */
+static uint32_t dma2d_soft_blend(uint32_t fg, uint32_t bg)
+{
+	uint32_t af = fg >> 24;
+	uint32_t ab = bg >> 24;
+	uint32_t mult = af * ab / 255;
+	uint32_t ao = af + ab - mult;
+	uint32_t out = ao << 24;
+	int shift;
+
+	if (ao == 0) {
+		return 0;
+	}
+
+	for (shift = 0; shift < 24; shift += 8) {
+		uint32_t cf = (fg >> shift) & 0xff;
+		uint32_t cb = (bg >> shift) & 0xff;
+
+		out |= ((cf * af + cb * ab - cb * mult) / ao) << shift;
+	}
+
+	return out;
+}
+
+static void dma2d_soft_write(uint8_t *p, uint32_t i, uint32_t format,
+			     uint32_t pixel)
+{
+	uint32_t n = dma2d_bits[format] / 8;
+
+	for (p += i * n; n > 0; n--, pixel >>= 8) {
+		*p++ = pixel;
+	}
+}
+
+static void dma2d_soft_load_clut(const struct dma2d_op *op)
+{
+	const uint8_t *p = (const uint8_t *)op->fgcmar;
+	uint32_t n = ((op->fgpfccr >> DMA2D_xPFCCR_CS_SHIFT) &
+		      DMA2D_xPFCCR_CS_MASK) + 1;
+	uint32_t i;
+
+	for (i = 0; i < n; i++) {
+		if (op->fgpfccr & DMA2D_xPFCCR_CCM_RGB888) {
+			dma2d_soft_clut[i] = dma2d_soft_read(p, i,
+					DMA2D_xPFCCR_CM_RGB888, 0);
+		} else {
+			dma2d_soft_clut[i] = dma2d_soft_read(p, i,
+					DMA2D_xPFCCR_CM_ARGB8888, 0);
+		}
+	}
+}
+
+/* Carries out an operation as the DMA2D would */
+static void dma2d_soft_render(struct dma2d_op *op)
+{
+	uint32_t mode = (op->cr >> DMA2D_CR_MODE_SHIFT) & DMA2D_CR_MODE_MASK;
+	uint32_t w = (op->nlr >> DMA2D_NLR_PL_SHIFT) & DMA2D_NLR_PL_MASK;
+	uint32_t h = (op->nlr >> DMA2D_NLR_NL_SHIFT) & DMA2D_NLR_NL_MASK;
+	uint32_t bytes = dma2d_bits[op->opfccr] / 8;
+	uint8_t *out = (uint8_t *)op->omar;
+	const uint8_t *fg = (const uint8_t *)op->fgmar;
+	const uint8_t *bg = (const uint8_t *)op->bgmar;
+	uint32_t x, y;
+
+	op->error = false;
+
+	if (op->fgpfccr & DMA2D_xPFCCR_START) {
+		dma2d_soft_load_clut(op);
+		return;
+	}
+
+	for (y = 0; y < h; y++) {
+		for (x = 0; x < w; x++) {
+			uint32_t o = y * (w + op->oor) + x;
+			uint32_t f = y * (w + op->fgor) + x;
+			uint32_t b = y * (w + op->bgor) + x;
+			uint32_t argb;
+
+			switch (mode) {
+			case DMA2D_CR_MODE_R2M:
+				dma2d_soft_write(out, o, op->opfccr, op->ocolr);
+				continue;
+			case DMA2D_CR_MODE_M2M:
+				memcpy(out + o * bytes, fg + f * bytes, bytes);
+				continue;
+			case DMA2D_CR_MODE_M2MWPFC:
+				argb = dma2d_soft_alpha(dma2d_soft_read(fg, f,
+						op->fgpfccr, op->fgcolr),
+						op->fgpfccr);
+				break;
+			default:
+				argb = dma2d_soft_blend(
+					dma2d_soft_alpha(dma2d_soft_read(fg, f,
+						op->fgpfccr, op->fgcolr),
+						op->fgpfccr),
+					dma2d_soft_alpha(dma2d_soft_read(bg, b,
+						op->bgpfccr, 0), op->bgpfccr));
+				break;
+			}
+			dma2d_soft_write(out, o, op->opfccr,
+					 dma2d_color(op->opfccr, argb));
+		}
+	}
+}
+
+/* Runs the queue on the CPU, with the operations queued by the callbacks */
+static void dma2d_soft_drain(void)
+{
+	struct dma2d_op *op;
+
+	dma2d_soft_busy = true;
+	while ((op = dma2d_head) != NULL) {
+		dma2d_soft_render(op);
+
+		CM_ATOMIC_BLOCK() {
+			dma2d_head = op->next;
+			if (dma2d_head == NULL) {
+				dma2d_tail = NULL;
+			}
+		}
+
+		if (op->callback) {
+			op->callback(op);
+		}
+	}
+	dma2d_soft_busy = false;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief DMA2D Convert a Colour to an Output Format
+
+@param[in] format Output pixel format, DMA2D_OPFCCR_CM_*
+@param[in] argb8888 Colour as 0xAARRGGBB
+@returns the colour as stored in a pixel of @p format
+*/
+uint32_t dma2d_color(uint8_t format, uint32_t argb8888)
+{
+	uint32_t a = argb8888 >> 24;
+	uint32_t r = (argb8888 >> 16) & 0xff;
+	uint32_t g = (argb8888 >> 8) & 0xff;
+	uint32_t b = argb8888 & 0xff;
+
+	switch (format) {
+	case DMA2D_OPFCCR_CM_RGB888:
+		return argb8888 & 0xffffff;
+	case DMA2D_OPFCCR_CM_RGB565:
+		return ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3);
+	case DMA2D_OPFCCR_CM_ARGB1555:
+		return ((a >> 7) << 15) | ((r >> 3) << 10) |
+		       ((g >> 3) << 5) | (b >> 3);
+	case DMA2D_OPFCCR_CM_ARGB4444:
+		return ((a >> 4) << 12) | ((r >> 4) << 8) |
+		       ((g >> 4) << 4) | (b >> 4);
+	default:
+		return argb8888;
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief DMA2D Set up a Rectangle Fill
+
+@param[out] op Operation
+@param[in] dst Destination surface, in an output format
+@param[in] x Left edge of the rectangle
+@param[in] y Top edge of the rectangle
+@param[in] w Width in pixels
+@param[in] h Height in lines
+@param[in] argb8888 Fill colour as 0xAARRGGBB
+*/
+void dma2d_op_fill(struct dma2d_op *op, const struct dma2d_surface *dst,
+		   uint16_t x, uint16_t y, uint16_t w, uint16_t h,
+		   uint32_t argb8888)
+{
+	dma2d_op_clear(op, DMA2D_CR_MODE_R2M, dst, x, y, w, h);
+	op->ocolr = dma2d_color(dst->format, argb8888);
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief DMA2D Set up a Copy
+
+Copies a rectangle between surfaces of any stride. If the formats differ
+the pixels are converted; indexed sources (L8, L4, AL44) need the colour
+table loaded first with dma2d_op_load_clut().
+
+The DMA2D addresses whole bytes: with an L4 source, the first pixel must
+start a byte, that is sy * stride + sx must be even. Otherwise the copy
+starts one pixel to the left.
+
+@param[out] op Operation
+@param[in] src Source surface
+@param[in] sx Left edge in the source
+@param[in] sy Top edge in the source
+@param[in] dst Destination surface, in an output format
+@param[in] dx Left edge in the destination
+@param[in] dy Top edge in the destination
+@param[in] w Width in pixels
+@param[in] h Height in lines
+*/
+void dma2d_op_copy(struct dma2d_op *op,
+		   const struct dma2d_surface *src, uint16_t sx, uint16_t sy,
+		   const struct dma2d_surface *dst, uint16_t dx, uint16_t dy,
+		   uint16_t w, uint16_t h)
+{
+	uint32_t mode = src->format == dst->format ? DMA2D_CR_MODE_M2M :
+						     DMA2D_CR_MODE_M2MWPFC;
+
+	dma2d_op_clear(op, mode, dst, dx, dy, w, h);
+	op->fgmar = dma2d_address(src, sx, sy);
+	op->fgor = src->stride - w;
+	op->fgpfccr = src->format;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief DMA2D Set up a Blend
+
+Blends a foreground rectangle over a background rectangle into a third one,
+which may be the background itself. The foreground alpha is, depending on
+@p alpha_mode:
+- DMA2D_xPFCCR_AM_NONE: the per pixel alpha of the foreground,
+- DMA2D_xPFCCR_AM_FORCE: the constant @p alpha,
+- DMA2D_xPFCCR_AM_PRODUCT: the per pixel alpha scaled by @p alpha.
+
+A8 and A4 foregrounds are alpha masks, for example rendered glyphs, and
+take their colour from dma2d_op_set_color(). The DMA2D addresses whole
+bytes: with an A4 or L4 foreground, fy * stride + fx must be even, otherwise
+the blend starts one pixel to the left in the foreground.
+
+@param[out] op Operation
+@param[in] fg Foreground surface
+@param[in] fx Left edge in the foreground
+@param[in] fy Top edge in the foreground
+@param[in] bg Background surface
+@param[in] bx Left edge in the background
+@param[in] by Top edge in the background
+@param[in] dst Destination surface, in an output format
+@param[in] dx Left edge in the destination
+@param[in] dy Top edge in the destination
+@param[in] w Width in pixels
+@param[in] h Height in lines
+@param[in] alpha_mode Foreground alpha mode, DMA2D_xPFCCR_AM_*
+@param[in] alpha Constant alpha, 255 is opaque
+*/
+void dma2d_op_blend(struct dma2d_op *op,
+		    const struct dma2d_surface *fg, uint16_t fx, uint16_t fy,
+		    const struct dma2d_surface *bg, uint16_t bx, uint16_t by,
+		    const struct dma2d_surface *dst, uint16_t dx, uint16_t dy,
+		    uint16_t w, uint16_t h, uint32_t alpha_mode, uint8_t alpha)
+{
+	dma2d_op_clear(op, DMA2D_CR_MODE_M2MWB, dst, dx, dy, w, h);
+	op->fgmar = dma2d_address(fg, fx, fy);
+	op->fgor = fg->stride - w;
+	op->fgpfccr = fg->format |
+		      (alpha_mode << DMA2D_xPFCCR_AM_SHIFT) |
+		      ((uint32_t)alpha << DMA2D_xPFCCR_ALPHA_SHIFT);
+	op->bgmar = dma2d_address(bg, bx, by);
+	op->bgor = bg->stride - w;
+	op->bgpfccr = bg->format;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief DMA2D Set the Foreground Colour of an Operation
+
+Used by A8 and A4 foregrounds, call it after setting up the operation.
+
+@param[in,out] op Operation
+@param[in] rgb888 Colour as 0xRRGGBB
+*/
+void dma2d_op_set_color(struct dma2d_op *op, uint32_t rgb888)
+{
+	op->fgcolr = rgb888 & 0xffffff;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief DMA2D Set up a Foreground Colour Table Load
+
+The table stays loaded for the following operations with an indexed
+foreground.
+
+@param[out] op Operation
+@param[in] clut Colour table in memory, word aligned
+@param[in] entries Number of entries, 1 to 256
+@param[in] rgb888 true for packed 24 bit entries, false for ARGB8888
+*/
+void dma2d_op_load_clut(struct dma2d_op *op, const void *clut,
+			uint16_t entries, bool rgb888)
+{
+	dma2d_op_clear(op, 0, NULL, 0, 0, 0, 0);
+	op->fgcmar = (uint32_t)clut;
+	op->fgpfccr = DMA2D_xPFCCR_CM_L8 | DMA2D_xPFCCR_START |
+		      (rgb888 ? DMA2D_xPFCCR_CCM_RGB888 :
+				DMA2D_xPFCCR_CCM_ARGB8888) |
+		      ((uint32_t)(entries - 1) << DMA2D_xPFCCR_CS_SHIFT);
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief DMA2D Queue an Operation
+
+The operation starts straight away if the DMA2D is idle, otherwise after the
+ones queued before it. It and the memory it refers to must stay valid until
+its callback has run.
+
+When rendering in software, the queue is run before the function returns,
+and the callbacks are called from it rather than from the interrupt.
+
+@param[in] op Operation
+*/
+void dma2d_submit(struct dma2d_op *op)
+{
+	op->next = NULL;
+
+	CM_ATOMIC_BLOCK() {
+		if (dma2d_head == NULL) {
+			dma2d_head = op;
+			dma2d_tail = op;
+			if (!dma2d_soft) {
+				dma2d_start(op);
+			}
+		} else {
+			dma2d_tail->next = op;
+			dma2d_tail = op;
+		}
+	}
+
+	if (dma2d_soft && !dma2d_soft_busy) {
+		dma2d_soft_drain();
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief DMA2D Interrupt Handler
+
+Call this from the DMA2D interrupt vector. It completes the current operation
+and starts the next one.
+*/
+void dma2d_irq_handler(void)
+{
+	uint32_t isr = DMA2D_ISR;
+	struct dma2d_op *op = dma2d_head;
+	struct dma2d_op *next;
+
+	DMA2D_IFCR = isr & DMA2D_ISR_ALL;
+	if (op == NULL) {
+		return;
+	}
+
+	if (isr & DMA2D_ISR_ERRORS) {
+		op->error = true;
+	} else if (!(isr & (DMA2D_ISR_TCIF | DMA2D_ISR_CTCIF))) {
+		return;
+	}
+
+	next = op->next;
+	dma2d_head = next;
+	if (next == NULL) {
+		dma2d_tail = NULL;
+	} else {
+		dma2d_start(next);
+	}
+
+	/* Last, as the callback may submit: an operation it queues is
+	 * started by dma2d_submit() or, later, by this handler. */
+	if (op->callback) {
+		op->callback(op);
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief DMA2D Select Software Rendering
+
+The operations are then carried out by the CPU, with the results the DMA2D
+gives. The software and the DMA2D have separate colour tables, load the
+table again after switching. Switch only while the queue is empty.
+
+@param[in] enable true to render in software, false to use the DMA2D
+*/
+void dma2d_set_software(bool enable)
+{
+	dma2d_soft = enable;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief DMA2D Busy
+
+@returns true while operations are queued or in progress
+*/
+bool dma2d_busy(void)
+{
+	return dma2d_head != NULL;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief DMA2D Wait for the Queue to Drain
+
+Call this before the CPU touches pixels an operation writes. The DMA2D
+interrupt must be able to run.
+*/
+void dma2d_wait(void)
+{
+	while (dma2d_head != NULL);
+}
+
 /**@}*/
@@ -0,0 +1,146 @@
+/** @addtogroup dma_file
+
+The descriptor based transfer API describes a whole transfer in a single
+struct dma_xfer and programs the stream or channel registers in one pass when
+it is submitted. Streams and channels are handed out from a small pool so
+that drivers can share a controller without knowing about each other.
+
+ */
+/*
+ * This file is part of the libopencm3 project.
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**@{*/
+
+#include <stddef.h>
+#include <libopencm3/cm3/cortex.h>
+#include <libopencm3/stm32/dma.h>
+
+static struct dma_xfer *dma_xfer_owner[2][DMA_XFER_MAX_CHANNELS];
+
+static struct dma_xfer **dma_xfer_slot(uint32_t dma, uint8_t channel)
+{
+	uint8_t index = channel - DMA_XFER_FIRST_CHANNEL;
+
+	if (index >= DMA_XFER_MAX_CHANNELS) {
+		return NULL;
+	}
+	return &dma_xfer_owner[(dma == DMA1) ? 0 : 1][index];
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief DMA Transfer Claim a Stream or Channel
+
+Bind the descriptor to the given stream or channel. This fails if the stream
+or channel is already owned by another descriptor.
+
+@param[in] xfer Transfer descriptor
+@param[in] dma DMA controller base address: DMA1 or DMA2
+@param[in] channel Stream (@ref dma_st_number) or channel (@ref dma_ch) number
+@returns true if the stream or channel is now owned by @p xfer
+*/
+bool dma_xfer_claim(struct dma_xfer *xfer, uint32_t dma, uint8_t channel)
+{
+	struct dma_xfer **slot = dma_xfer_slot(dma, channel);
+	bool ok = false;
+
+	if (slot == NULL) {
+		return false;
+	}
+
+	CM_ATOMIC_BLOCK() {
+		if (*slot == NULL || *slot == xfer) {
+			*slot = xfer;
+			ok = true;
+		}
+	}
+
+	if (ok) {
+		xfer->dma = dma;
+		xfer->channel = channel;
+		xfer->busy = false;
+	}
+	return ok;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief DMA Transfer Claim any Free Stream or Channel
+
+Bind the descriptor to the lowest numbered free stream or channel among the
+candidates. On parts with hardwired request mapping the candidates are the
+streams or channels the peripheral request is connected to, on parts with a
+DMAMUX any stream or channel can be used.
+
+@param[in] xfer Transfer descriptor
+@param[in] dma DMA controller base address: DMA1 or DMA2
+@param[in] channel_mask Candidates, bit n set allows stream or channel n
+@returns true if a stream or channel was claimed
+*/
+bool dma_xfer_claim_any(struct dma_xfer *xfer, uint32_t dma,
+			uint32_t channel_mask)
+{
+	uint8_t channel;
+
+	for (channel = DMA_XFER_FIRST_CHANNEL;
+	     channel < DMA_XFER_FIRST_CHANNEL + DMA_XFER_MAX_CHANNELS;
+	     channel++) {
+		if ((channel_mask & (1 << channel)) &&
+		    dma_xfer_claim(xfer, dma, channel)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief DMA Transfer Release the Stream or Channel
+
+Any transfer in progress is aborted and the stream or channel is returned to
+the pool.
+
+@param[in] xfer Transfer descriptor
+*/
+void dma_xfer_release(struct dma_xfer *xfer)
+{
+	struct dma_xfer **slot;
+
+	if (xfer->dma == 0) {
+		return;
+	}
+
+	dma_xfer_abort(xfer);
+	slot = dma_xfer_slot(xfer->dma, xfer->channel);
+	if (slot != NULL && *slot == xfer) {
+		*slot = NULL;
+	}
+	xfer->dma = 0;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief DMA Transfer Get the Owner of a Stream or Channel
+
+@param[in] dma DMA controller base address: DMA1 or DMA2
+@param[in] channel Stream (@ref dma_st_number) or channel (@ref dma_ch) number
+@returns descriptor bound to the stream or channel, or NULL
+*/
+struct dma_xfer *dma_xfer_get_owner(uint32_t dma, uint8_t channel)
+{
+	struct dma_xfer **slot = dma_xfer_slot(dma, channel);
+
+	return (slot != NULL) ? *slot : NULL;
+}
+
+/**@}*/
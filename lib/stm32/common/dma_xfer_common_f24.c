@@ -0,0 +1,222 @@
+/** @addtogroup dma_file
+
+Descriptor based transfers on the multi stream controller found in
+f2/f4/f7/h7 parts.
+
+ */
+/*
+ * This file is part of the libopencm3 project.
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**@{*/
+
+#include <stddef.h>
+#include <libopencm3/stm32/dma.h>
+
+#if defined(STM32H7)
+#include <libopencm3/stm32/dmamux.h>
+/* DMA1 streams are routed by DMAMUX1 channels 1..8, DMA2 by 9..16 */
+#define DMA_XFER_DMAMUX_CHANNEL(dma, stream) \
+	(((dma) == DMA1 ? 1 : 9) + (stream))
+#endif
+
+static uint32_t dma_xfer_read_flags(uint32_t dma, uint8_t stream)
+{
+	uint32_t isr = (stream < 4) ? DMA_LISR(dma) : DMA_HISR(dma);
+
+	return (isr >> DMA_ISR_OFFSET(stream)) & DMA_ISR_FLAGS;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief DMA Transfer Submit
+
+The stream is stopped if needed, all of its registers are written from the
+descriptor and it is enabled again. The peripheral side of the transfer must
+have its DMA request enabled separately.
+
+FIFO mode is selected automatically when the source and destination widths
+differ or for memory to memory transfers, where direct mode is not available.
+
+@param[in] xfer Claimed transfer descriptor
+@returns false if the descriptor is unbound or still busy
+*/
+bool dma_xfer_submit(struct dma_xfer *xfer)
+{
+	uint32_t dma = xfer->dma;
+	uint8_t stream = xfer->channel;
+	uint32_t scr, par, mar, psize, msize;
+	bool pinc, minc;
+
+	if (dma == 0 || xfer->busy) {
+		return false;
+	}
+
+	if (xfer->direction == DMA_XFER_MEM_TO_PERIPH) {
+		par = xfer->dst;
+		mar = xfer->src;
+		psize = xfer->dst_width;
+		msize = xfer->src_width;
+		pinc = xfer->flags & DMA_XFER_DST_INC;
+		minc = xfer->flags & DMA_XFER_SRC_INC;
+		scr = DMA_SxCR_DIR_MEM_TO_PERIPHERAL;
+	} else {
+		par = xfer->src;
+		mar = xfer->dst;
+		psize = xfer->src_width;
+		msize = xfer->dst_width;
+		pinc = xfer->flags & DMA_XFER_SRC_INC;
+		minc = xfer->flags & DMA_XFER_DST_INC;
+		scr = (xfer->direction == DMA_XFER_MEM_TO_MEM) ?
+		      DMA_SxCR_DIR_MEM_TO_MEM : DMA_SxCR_DIR_PERIPHERAL_TO_MEM;
+	}
+
+	scr |= (psize << DMA_SxCR_PSIZE_SHIFT) |
+	       (msize << DMA_SxCR_MSIZE_SHIFT) |
+	       ((uint32_t)(xfer->priority & 3) << DMA_SxCR_PL_SHIFT) |
+	       DMA_SxCR_TCIE | DMA_SxCR_TEIE;
+	if (pinc) {
+		scr |= DMA_SxCR_PINC;
+	}
+	if (minc) {
+		scr |= DMA_SxCR_MINC;
+	}
+	if ((xfer->flags & DMA_XFER_CIRCULAR) &&
+	    xfer->direction != DMA_XFER_MEM_TO_MEM) {
+		scr |= DMA_SxCR_CIRC;
+	}
+	if (xfer->flags & DMA_XFER_HALF_IRQ) {
+		scr |= DMA_SxCR_HTIE;
+	}
+#if !defined(STM32H7)
+	scr |= DMA_SxCR_CHSEL(xfer->request & 7);
+#endif
+
+	/* Stream must be disabled, and seen disabled, before reconfiguring. */
+	DMA_SCR(dma, stream) &= ~DMA_SxCR_EN;
+	while (DMA_SCR(dma, stream) & DMA_SxCR_EN);
+
+	if (psize != msize || xfer->direction == DMA_XFER_MEM_TO_MEM) {
+		DMA_SFCR(dma, stream) = DMA_SxFCR_DMDIS | DMA_SxFCR_FTH_2_4_FULL;
+	} else {
+		DMA_SFCR(dma, stream) = 0;
+		scr |= DMA_SxCR_DMEIE;
+	}
+
+	dma_clear_interrupt_flags(dma, stream, DMA_ISR_FLAGS);
+	DMA_SNDTR(dma, stream) = xfer->count;
+	DMA_SPAR(dma, stream) = (void *)par;
+	DMA_SM0AR(dma, stream) = (void *)mar;
+#if defined(STM32H7)
+	DMAMUX_CxCR(DMAMUX1, DMA_XFER_DMAMUX_CHANNEL(dma, stream)) =
+		(xfer->direction == DMA_XFER_MEM_TO_MEM) ? 0 :
+		((uint32_t)xfer->request << DMAMUX_CxCR_DMAREQ_ID_SHIFT);
+#endif
+
+	xfer->busy = true;
+	DMA_SCR(dma, stream) = scr | DMA_SxCR_EN;
+	return true;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief DMA Transfer Abort
+
+The stream is stopped and its flags cleared. No callback is made.
+
+@param[in] xfer Claimed transfer descriptor
+*/
+void dma_xfer_abort(struct dma_xfer *xfer)
+{
+	uint32_t dma = xfer->dma;
+	uint8_t stream = xfer->channel;
+
+	if (dma == 0) {
+		return;
+	}
+
+	DMA_SCR(dma, stream) &= ~(DMA_SxCR_EN | DMA_SxCR_TCIE |
+				  DMA_SxCR_HTIE | DMA_SxCR_TEIE |
+				  DMA_SxCR_DMEIE);
+	while (DMA_SCR(dma, stream) & DMA_SxCR_EN);
+	dma_clear_interrupt_flags(dma, stream, DMA_ISR_FLAGS);
+	xfer->busy = false;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief DMA Transfer Get Remaining Data Items
+
+@param[in] xfer Claimed transfer descriptor
+@returns number of data items not yet transferred
+*/
+uint16_t dma_xfer_remaining(const struct dma_xfer *xfer)
+{
+	if (xfer->dma == 0) {
+		return 0;
+	}
+	return DMA_SNDTR(xfer->dma, xfer->channel);
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief DMA Transfer Interrupt Handler
+
+Call this from the stream interrupt vector. Pending flags are cleared and
+translated into @ref dma_xfer_evt for the callback of the owning descriptor.
+A non circular transfer is no longer busy when the callback runs, so it may
+submit the next transfer straight away.
+
+@param[in] dma DMA controller base address: DMA1 or DMA2
+@param[in] channel Stream number: @ref dma_st_number
+*/
+void dma_xfer_irq_handler(uint32_t dma, uint8_t channel)
+{
+	struct dma_xfer *xfer = dma_xfer_get_owner(dma, channel);
+	uint32_t flags = dma_xfer_read_flags(dma, channel);
+	uint32_t events = 0;
+
+	dma_clear_interrupt_flags(dma, channel, flags);
+	if (xfer == NULL) {
+		return;
+	}
+
+	if (flags & DMA_TEIF) {
+		events |= DMA_XFER_EVT_ERROR;
+	}
+	if (flags & DMA_DMEIF) {
+		/* Unlike a transfer error, a direct mode error leaves the
+		 * stream running: stop it before the descriptor goes idle. */
+		dma_xfer_abort(xfer);
+		events |= DMA_XFER_EVT_ERROR;
+	}
+	if ((flags & DMA_HTIF) && (xfer->flags & DMA_XFER_HALF_IRQ)) {
+		events |= DMA_XFER_EVT_HALF;
+	}
+	if (flags & DMA_TCIF) {
+		events |= DMA_XFER_EVT_COMPLETE;
+	}
+
+	if (events & DMA_XFER_EVT_ERROR) {
+		/* The stream has been disabled by hardware or above. */
+		xfer->busy = false;
+	} else if ((events & DMA_XFER_EVT_COMPLETE) &&
+		   !(DMA_SCR(dma, channel) & DMA_SxCR_CIRC)) {
+		xfer->busy = false;
+	}
+
+	if (events && xfer->callback) {
+		xfer->callback(xfer, events);
+	}
+}
+
+/**@}*/
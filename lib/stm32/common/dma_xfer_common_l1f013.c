@@ -0,0 +1,212 @@
+/** @addtogroup dma_file
+
+Descriptor based transfers on the channel based controller found in
+f0/f1/f3/g0/g4/l0/l1/l4 parts.
+
+ */
+/*
+ * This file is part of the libopencm3 project.
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**@{*/
+
+#include <stddef.h>
+#include <libopencm3/stm32/dma.h>
+
+#if defined(STM32G0) || defined(STM32G4)
+#include <libopencm3/stm32/dmamux.h>
+
+/* DMAMUX channel routing DMA2 channel 1. DMA1 channels come first and the
+ * number of them depends on the part, override for parts with fewer. */
+#ifndef DMA_XFER_DMAMUX_DMA2_OFFSET
+#if defined(STM32G0)
+#define DMA_XFER_DMAMUX_DMA2_OFFSET	7
+#else
+#define DMA_XFER_DMAMUX_DMA2_OFFSET	8
+#endif
+#endif
+
+#define DMA_XFER_DMAMUX_CHANNEL(dma, channel) \
+	(((dma) == DMA1 ? 0 : DMA_XFER_DMAMUX_DMA2_OFFSET) + (channel))
+#endif
+
+/*---------------------------------------------------------------------------*/
+/** @brief DMA Transfer Submit
+
+The channel is stopped, all of its registers are written from the descriptor
+and it is enabled again. The peripheral side of the transfer must have its
+DMA request enabled separately. The request selection is written to CSELR or
+to the DMAMUX channel on parts that have one.
+
+@param[in] xfer Claimed transfer descriptor
+@returns false if the descriptor is unbound or still busy
+*/
+bool dma_xfer_submit(struct dma_xfer *xfer)
+{
+	uint32_t dma = xfer->dma;
+	uint8_t channel = xfer->channel;
+	uint32_t ccr, par, mar, psize, msize;
+	bool pinc, minc;
+
+	if (dma == 0 || xfer->busy) {
+		return false;
+	}
+
+	if (xfer->direction == DMA_XFER_MEM_TO_PERIPH) {
+		par = xfer->dst;
+		mar = xfer->src;
+		psize = xfer->dst_width;
+		msize = xfer->src_width;
+		pinc = xfer->flags & DMA_XFER_DST_INC;
+		minc = xfer->flags & DMA_XFER_SRC_INC;
+		ccr = DMA_CCR_DIR;
+	} else {
+		/* Memory to memory reads from the "peripheral" address. */
+		par = xfer->src;
+		mar = xfer->dst;
+		psize = xfer->src_width;
+		msize = xfer->dst_width;
+		pinc = xfer->flags & DMA_XFER_SRC_INC;
+		minc = xfer->flags & DMA_XFER_DST_INC;
+		ccr = (xfer->direction == DMA_XFER_MEM_TO_MEM) ?
+		      DMA_CCR_MEM2MEM : 0;
+	}
+
+	ccr |= (psize << DMA_CCR_PSIZE_SHIFT) |
+	       (msize << DMA_CCR_MSIZE_SHIFT) |
+	       ((uint32_t)(xfer->priority & 3) << DMA_CCR_PL_SHIFT) |
+	       DMA_CCR_TCIE | DMA_CCR_TEIE;
+	if (pinc) {
+		ccr |= DMA_CCR_PINC;
+	}
+	if (minc) {
+		ccr |= DMA_CCR_MINC;
+	}
+	if ((xfer->flags & DMA_XFER_CIRCULAR) &&
+	    xfer->direction != DMA_XFER_MEM_TO_MEM) {
+		ccr |= DMA_CCR_CIRC;
+	}
+	if (xfer->flags & DMA_XFER_HALF_IRQ) {
+		ccr |= DMA_CCR_HTIE;
+	}
+
+	DMA_CCR(dma, channel) = 0;
+	DMA_IFCR(dma) = DMA_IFCR_CIF(channel);
+	DMA_CNDTR(dma, channel) = xfer->count;
+	DMA_CPAR(dma, channel) = par;
+	DMA_CMAR(dma, channel) = mar;
+#if defined(DMA_XFER_DMAMUX_CHANNEL)
+	DMAMUX_CxCR(DMAMUX1, DMA_XFER_DMAMUX_CHANNEL(dma, channel)) =
+		(xfer->direction == DMA_XFER_MEM_TO_MEM) ? 0 :
+		((uint32_t)xfer->request << DMAMUX_CxCR_DMAREQ_ID_SHIFT);
+#elif defined(DMA_CSELR)
+	if (xfer->direction != DMA_XFER_MEM_TO_MEM) {
+		dma_set_channel_request(dma, channel, xfer->request);
+	}
+#endif
+
+	xfer->busy = true;
+	DMA_CCR(dma, channel) = ccr | DMA_CCR_EN;
+	return true;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief DMA Transfer Abort
+
+The channel is stopped and its flags cleared. No callback is made.
+
+@param[in] xfer Claimed transfer descriptor
+*/
+void dma_xfer_abort(struct dma_xfer *xfer)
+{
+	if (xfer->dma == 0) {
+		return;
+	}
+
+	DMA_CCR(xfer->dma, xfer->channel) &= ~(DMA_CCR_EN | DMA_CCR_TCIE |
+					       DMA_CCR_HTIE | DMA_CCR_TEIE);
+	DMA_IFCR(xfer->dma) = DMA_IFCR_CIF(xfer->channel);
+	xfer->busy = false;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief DMA Transfer Get Remaining Data Items
+
+@param[in] xfer Claimed transfer descriptor
+@returns number of data items not yet transferred
+*/
+uint16_t dma_xfer_remaining(const struct dma_xfer *xfer)
+{
+	if (xfer->dma == 0) {
+		return 0;
+	}
+	return DMA_CNDTR(xfer->dma, xfer->channel);
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief DMA Transfer Interrupt Handler
+
+Call this from the channel interrupt vector. Where several channels share a
+vector, call it once for each of them; channels without pending flags return
+straight away. Pending flags are cleared and translated into
+@ref dma_xfer_evt for the callback of the owning descriptor. A non circular
+transfer is no longer busy when the callback runs, so it may submit the next
+transfer straight away.
+
+@param[in] dma DMA controller base address: DMA1 or DMA2
+@param[in] channel Channel number: @ref dma_ch
+*/
+void dma_xfer_irq_handler(uint32_t dma, uint8_t channel)
+{
+	struct dma_xfer *xfer;
+	uint32_t flags = (DMA_ISR(dma) >> DMA_FLAG_OFFSET(channel)) &
+			 DMA_IFCR_CIF_BIT;
+	uint32_t events = 0;
+
+	if (flags == 0) {
+		return;
+	}
+	DMA_IFCR(dma) = flags << DMA_FLAG_OFFSET(channel);
+
+	xfer = dma_xfer_get_owner(dma, channel);
+	if (xfer == NULL) {
+		return;
+	}
+
+	if (flags & DMA_TEIF) {
+		events |= DMA_XFER_EVT_ERROR;
+	}
+	if ((flags & DMA_HTIF) && (xfer->flags & DMA_XFER_HALF_IRQ)) {
+		events |= DMA_XFER_EVT_HALF;
+	}
+	if (flags & DMA_TCIF) {
+		events |= DMA_XFER_EVT_COMPLETE;
+	}
+
+	if (events & DMA_XFER_EVT_ERROR) {
+		/* The channel has been disabled by hardware. */
+		xfer->busy = false;
+	} else if ((events & DMA_XFER_EVT_COMPLETE) &&
+		   !(DMA_CCR(dma, channel) & DMA_CCR_CIRC)) {
+		xfer->busy = false;
+	}
+
+	if (events && xfer->callback) {
+		xfer->callback(xfer, events);
+	}
+}
+
+/**@}*/
@@ -31,4 +31,100 @@
 
 /**@{*/
 
+/*---------------------------------------------------------------------------*/
+/** @brief DSI Send a DCS Write Command
+
+Sent as a short packet for up to one parameter, as a long packet otherwise.
+Waits for room in the command and payload FIFOs, not for the transmission.
+
+@param[in] vcid Virtual channel of the panel
+@param[in] cmd DCS command
+@param[in] params Command parameters, may be NULL if @p len is 0
+@param[in] len Number of parameter bytes
+*/
+void dsi_dcs_write(uint8_t vcid, uint8_t cmd, const uint8_t *params,
+		   uint16_t len)
+{
+	uint32_t header = (uint32_t)vcid << DSI_GHCR_VCID_SHIFT;
+	uint32_t word = cmd;
+	uint16_t i;
+
+	while (DSI_GPSR & DSI_GPSR_CMDFF);
+
+	if (len <= 1) {
+		header |= (uint32_t)cmd << DSI_GHCR_DATA0_SHIFT;
+		if (len) {
+			header |= DSI_GHCR_DT_DCS_SHORT_WRITE1 |
+				  ((uint32_t)params[0] << DSI_GHCR_DATA1_SHIFT);
+		} else {
+			header |= DSI_GHCR_DT_DCS_SHORT_WRITE0;
+		}
+		DSI_GHCR = header;
+		return;
+	}
+
+	/* The payload is the command byte followed by the parameters. */
+	for (i = 0; i < len; i++) {
+		word |= (uint32_t)params[i] << (((i + 1) % 4) * 8);
+		if ((i + 1) % 4 == 3) {
+			while (DSI_GPSR & DSI_GPSR_PWRFF);
+			DSI_GPDR = word;
+			word = 0;
+		}
+	}
+	if (len % 4 != 3) {
+		while (DSI_GPSR & DSI_GPSR_PWRFF);
+		DSI_GPDR = word;
+	}
+
+	DSI_GHCR = header | DSI_GHCR_DT_DCS_LONG_WRITE |
+		   ((uint32_t)(len + 1) << DSI_GHCR_WCLSB_SHIFT);
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief DSI Set the Panel Area of the next Refresh
+
+For adapted command mode. Programs the column and page address window of
+the panel and the LTDC command size; the LTDC must output exactly this
+area, see ltdc_fb_set_window().
+
+@param[in] vcid Virtual channel of the panel
+@param[in] x Left edge of the area
+@param[in] y Top edge of the area
+@param[in] w Width of the area in pixels
+@param[in] h Height of the area in lines
+*/
+void dsi_set_update_area(uint8_t vcid, uint16_t x, uint16_t y,
+			 uint16_t w, uint16_t h)
+{
+	uint16_t x1 = x + w - 1;
+	uint16_t y1 = y + h - 1;
+	uint8_t columns[4] = { x >> 8, x & 0xff, x1 >> 8, x1 & 0xff };
+	uint8_t pages[4] = { y >> 8, y & 0xff, y1 >> 8, y1 & 0xff };
+
+	dsi_dcs_write(vcid, DSI_DCS_SET_COLUMN_ADDRESS, columns, 4);
+	dsi_dcs_write(vcid, DSI_DCS_SET_PAGE_ADDRESS, pages, 4);
+	DSI_LCCR = w;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief DSI Start a Refresh in Adapted Command Mode
+
+The LTDC sends one frame of its active area to the panel.
+*/
+void dsi_refresh(void)
+{
+	DSI_WCR |= DSI_WCR_LTDCEN;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief DSI Refresh in Progress
+
+@returns true while the LTDC frame is being transferred
+*/
+bool dsi_refresh_busy(void)
+{
+	return DSI_WISR & DSI_WISR_BUSY;
+}
+
 /**@}*/
@@ -116,6 +116,81 @@ static void fdcan_get_fill_rxfifo(uint32_t canport, uint8_t fifo_id, unsigned *g
 		& FDCAN_RXFIFO_FL_MASK;
 }
 
+/** Copy payload into message RAM.
+ *
+ * Message RAM can only be accessed in 32bit quantities, while payload buffers
+ * provided by the caller need not be word aligned. Bytes are therefore packed
+ * into words explicitly, which is also safe on cores without unaligned access.
+ *
+ * @param [out] dst Payload area of message RAM element
+ * @param [in] src Payload data
+ * @param [in] length Payload length in bytes
+ */
+static void fdcan_copy_to_msg_ram(uint32_t *dst, const uint8_t *src, unsigned length)
+{
+	for (unsigned q = 0; q < length; q += 4) {
+		uint32_t word = 0;
+
+		for (unsigned b = 0; b < 4 && q + b < length; b++) {
+			word |= (uint32_t) src[q + b] << (8 * b);
+		}
+		dst[q / 4] = word;
+	}
+}
+
+/** Copy payload out of message RAM.
+ *
+ * Counterpart of @ref fdcan_copy_to_msg_ram. Only length bytes are written
+ * into destination buffer.
+ *
+ * @param [out] dst Buffer for payload data
+ * @param [in] src Payload area of message RAM element
+ * @param [in] length Payload length in bytes
+ */
+static void fdcan_copy_from_msg_ram(uint8_t *dst, const uint32_t *src, unsigned length)
+{
+	for (unsigned q = 0; q < length; q += 4) {
+		uint32_t word = src[q / 4];
+
+		for (unsigned b = 0; b < 4 && q + b < length; b++) {
+			dst[q + b] = (uint8_t) (word >> (8 * b));
+		}
+	}
+}
+
+/** Fill transmit buffer element in message RAM.
+ *
+ * @param [out] tx_buffer Transmit buffer element
+ * @param [in] id Message ID
+ * @param [in] ext Extended message ID
+ * @param [in] rtr Request transmit
+ * @param [in] flags Aggregate of FDF, BRS, EFC flags and message marker
+ * @param [in] dlc Data length code of the message
+ * @param [in] length Message payload length
+ * @param [in] data Message payload data
+ */
+static void fdcan_write_txbuf(struct fdcan_tx_buffer_element *tx_buffer, uint32_t id,
+		bool ext, bool rtr, uint32_t flags, uint32_t dlc, uint8_t length,
+		const uint8_t *data)
+{
+	if (ext) {
+		tx_buffer->identifier_flags = FDCAN_FIFO_XTD
+			| ((id & FDCAN_FIFO_EID_MASK) << FDCAN_FIFO_EID_SHIFT);
+	} else {
+		tx_buffer->identifier_flags =
+			(id & FDCAN_FIFO_SID_MASK) << FDCAN_FIFO_SID_SHIFT;
+	}
+
+	if (rtr) {
+		tx_buffer->identifier_flags |= FDCAN_FIFO_RTR;
+	}
+
+	tx_buffer->evt_fmt_dlc_res =
+		(dlc << FDCAN_FIFO_DLC_SHIFT) | flags;
+
+	fdcan_copy_to_msg_ram(tx_buffer->data, data, length);
+}
+
 /** Returns standard filter start address in message RAM
  *
  * @param [in] canport FDCAN block base address. See @ref fdcan_block.
@@ -506,18 +581,6 @@ int fdcan_transmit(uint32_t canport, uint32_t id, bool ext, bool rtr,
 		return FDCAN_E_INVALID;
 	}
 
-	if (ext) {
-		tx_buffer->identifier_flags = FDCAN_FIFO_XTD
-			| ((id & FDCAN_FIFO_EID_MASK) << FDCAN_FIFO_EID_SHIFT);
-	} else {
-		tx_buffer->identifier_flags =
-			(id & FDCAN_FIFO_SID_MASK) << FDCAN_FIFO_SID_SHIFT;
-	}
-
-	if (rtr) {
-		tx_buffer->identifier_flags |= FDCAN_FIFO_RTR;
-	}
-
 	if (fdcan_fmt) {
 		flags |= FDCAN_FIFO_FDF;
 	}
@@ -526,18 +589,117 @@ int fdcan_transmit(uint32_t canport, uint32_t id, bool ext, bool rtr,
 		flags |= FDCAN_FIFO_BRS;
 	}
 
-	tx_buffer->evt_fmt_dlc_res =
-		(dlc << FDCAN_FIFO_DLC_SHIFT) | flags;
-
-	for (int q = 0; q < length; q += 4) {
-		tx_buffer->data[q / 4] = *((uint32_t *) &data[q]);
-	}
+	fdcan_write_txbuf(tx_buffer, id, ext, rtr, flags, dlc, length, data);
 
 	FDCAN_TXBAR(canport) |= 1 << mailbox;
 
 	return mailbox;
 }
 
+/** Transmit batch of messages using FDCAN
+ *
+ * Copies as many of the frames as there are free transmit buffers into
+ * message RAM and requests transmission of all of them by a single write
+ * into FDCAN_TXBAR. Works in both FIFO and queue mode, see @ref fdcan_set_can.
+ * In FIFO mode, frames are sent in order given, in queue mode they are
+ * arbitrated by their ID. Free buffers are taken from the FIFO free level
+ * in FIFO mode and counted from FDCAN_TXBRP in queue mode.
+ *
+ * Frames with event flag set store an entry into transmit event FIFO once
+ * sent, which can be read using @ref fdcan_get_tx_event.
+ *
+ * @param [in] canport CAN block register base. See @ref fdcan_block.
+ * @param [in] frames Frames to be sent
+ * @param [in] count Number of frames
+ * @returns Number of frames queued for transmission, which may be less than
+ * count. FDCAN_E_BUSY if no transmit buffer is free, FDCAN_E_INVALID if any
+ * of the frames has invalid length, nothing is queued in such case.
+ * See @ref fdcan_error.
+ */
+int fdcan_transmit_batch(uint32_t canport, const struct fdcan_frame *frames,
+		unsigned count)
+{
+	unsigned size, free_level, index, n = 0;
+	uint32_t pending, requests = 0;
+
+	for (unsigned i = 0; i < count; i++) {
+		if (fdcan_length_to_dlc(frames[i].length) == 0xFF) {
+			return FDCAN_E_INVALID;
+		}
+	}
+
+	if (count == 0) {
+		return 0;
+	} else if (FDCAN_TXFQS(canport) & FDCAN_TXFQS_TFQF) {
+		return FDCAN_E_BUSY;
+	}
+
+	size = fdcan_get_txbuf_count(canport);
+	pending = FDCAN_TXBRP(canport);
+
+	/* The free level is only maintained in FIFO mode. */
+	if (FDCAN_TXBC(canport) & FDCAN_TXBC_TFQM) {
+		free_level = 0;
+		for (unsigned i = 0; i < size; i++) {
+			if ((pending & (1U << i)) == 0) {
+				free_level++;
+			}
+		}
+	} else {
+		free_level = (FDCAN_TXFQS(canport) >> FDCAN_TXFQS_TFFL_SHIFT)
+			& FDCAN_TXFQS_TFFL_MASK;
+	}
+
+	if (free_level == 0) {
+		return FDCAN_E_BUSY;
+	}
+
+	/* Free buffers follow the put index. In FIFO mode they form one
+	 * contiguous range, in queue mode they may be interleaved with
+	 * pending ones.
+	 */
+	index = (FDCAN_TXFQS(canport) >> FDCAN_TXFQS_TFQPI_SHIFT)
+		& FDCAN_TXFQS_TFQPI_MASK;
+
+	for (unsigned scanned = 0; scanned < size && n < count && n < free_level;
+			scanned++) {
+		if ((pending & (1U << index)) == 0) {
+			const struct fdcan_frame *frame = &frames[n];
+			uint32_t flags = 0;
+
+			if (frame->fdcan_fmt) {
+				flags |= FDCAN_FIFO_FDF;
+			}
+
+			if (frame->btr_switch) {
+				flags |= FDCAN_FIFO_BRS;
+			}
+
+			if (frame->event) {
+				flags |= FDCAN_FIFO_EFC
+					| ((uint32_t) frame->marker << FDCAN_FIFO_MM_SHIFT);
+			}
+
+			fdcan_write_txbuf(fdcan_get_txbuf_addr(canport, index),
+					frame->id, frame->ext, frame->rtr, flags,
+					fdcan_length_to_dlc(frame->length), frame->length,
+					frame->data);
+
+			requests |= 1U << index;
+			n++;
+		}
+
+		if (++index == size) {
+			index = 0;
+		}
+	}
+
+	/* Writing zero bits has no effect on FDCAN_TXBAR. */
+	FDCAN_TXBAR(canport) = requests;
+
+	return n;
+}
+
 /** Receive Message from FDCAN FIFO
  *
  * Reads one message from receive FIFO. Returns message ID, type of ID, message length
@@ -604,9 +766,7 @@ int fdcan_receive(uint32_t canport, uint8_t fifo_id, bool release, uint32_t *id,
 		*rtr = ((fifo->identifier_flags & FDCAN_FIFO_RTR) == FDCAN_FIFO_RTR);
 	}
 
-	for (unsigned int q = 0; q < len; q += 4) {
-		*((uint32_t *) &data[q]) = fifo->data[q / 4];
-	}
+	fdcan_copy_from_msg_ram(data, fifo->data, len);
 
 	if (release) {
 		FDCAN_RXFIA(canport, fifo_id) = get_index << FDCAN_RXFIFO_AI_SHIFT;
@@ -615,6 +775,138 @@ int fdcan_receive(uint32_t canport, uint8_t fifo_id, bool release, uint32_t *id,
 	return FDCAN_E_OK;
 }
 
+/** Receive batch of messages from FDCAN FIFO
+ *
+ * Reads up to max messages from receive FIFO and releases all of them by
+ * a single acknowledge. Meant to drain the FIFO from interrupt handler at once,
+ * rather than taking one interrupt per frame. On devices implementing FIFO
+ * watermark, the interrupt can be deferred until several frames are pending.
+ *
+ * @param [in] canport FDCAN block base address. See @ref fdcan_block
+ * @param [in] fifo_id FIFO id.
+ * @param [out] frames Buffer for received frames
+ * @param [in] max Maximum number of frames to be read
+ * @returns Number of frames read, 0 if FIFO is empty.
+ */
+int fdcan_receive_batch(uint32_t canport, uint8_t fifo_id,
+		struct fdcan_frame *frames, unsigned max)
+{
+	unsigned pending_frames, get_index, size, n;
+
+	fdcan_get_fill_rxfifo(canport, fifo_id, &get_index, &pending_frames);
+
+	if (pending_frames > max) {
+		pending_frames = max;
+	}
+
+	if (pending_frames == 0) {
+		return 0;
+	}
+
+	size = fdcan_get_fifo_size(canport, fifo_id);
+
+	for (n = 0; n < pending_frames; n++) {
+		const struct fdcan_rx_fifo_element *fifo = fdcan_get_rxfifo_addr(canport,
+				fifo_id, get_index);
+		struct fdcan_frame *frame = &frames[n];
+		uint32_t identifier_flags = fifo->identifier_flags;
+		uint32_t filt_fmt_dlc_ts = fifo->filt_fmt_dlc_ts;
+
+		frame->ext = (identifier_flags & FDCAN_FIFO_XTD) == FDCAN_FIFO_XTD;
+		if (frame->ext) {
+			frame->id = (identifier_flags >> FDCAN_FIFO_EID_SHIFT)
+				& FDCAN_FIFO_EID_MASK;
+		} else {
+			frame->id = (identifier_flags >> FDCAN_FIFO_SID_SHIFT)
+				& FDCAN_FIFO_SID_MASK;
+		}
+
+		frame->rtr = (identifier_flags & FDCAN_FIFO_RTR) == FDCAN_FIFO_RTR;
+		frame->fdcan_fmt = (filt_fmt_dlc_ts & FDCAN_FIFO_FDF) == FDCAN_FIFO_FDF;
+		frame->btr_switch = (filt_fmt_dlc_ts & FDCAN_FIFO_BRS) == FDCAN_FIFO_BRS;
+		frame->event = false;
+		frame->marker = 0;
+		frame->fmi = (uint8_t) ((filt_fmt_dlc_ts >> FDCAN_FIFO_FIDX_SHIFT)
+			& FDCAN_FIFO_FIDX_MASK);
+		frame->timestamp = (uint16_t) ((filt_fmt_dlc_ts >> FDCAN_FIFO_RXTS_SHIFT)
+			& FDCAN_FIFO_RXTS_MASK);
+		frame->length = fdcan_dlc_to_length((filt_fmt_dlc_ts >> FDCAN_FIFO_DLC_SHIFT)
+			& FDCAN_FIFO_DLC_MASK);
+
+		fdcan_copy_from_msg_ram(frame->data, fifo->data, frame->length);
+
+		if (n + 1 < pending_frames && ++get_index == size) {
+			get_index = 0;
+		}
+	}
+
+	/* Acknowledging last element read releases all preceding ones too. */
+	FDCAN_RXFIA(canport, fifo_id) = get_index << FDCAN_RXFIFO_AI_SHIFT;
+
+	return n;
+}
+
+/** Read transmit event
+ *
+ * Reads the oldest entry from transmit event FIFO and releases it. Entries are
+ * stored for frames transmitted with event flag set, see
+ * @ref fdcan_transmit_batch. The timestamp is captured at start of frame,
+ * timestamp counter has to be configured in FDCAN_TSCC. Optional outputs
+ * may be NULL.
+ *
+ * @param [in] canport FDCAN block base address. See @ref fdcan_block
+ * @param [out] id Returned message ID. Optional.
+ * @param [out] ext Returned type of the message ID (true if extended). Optional.
+ * @param [out] marker Returned message marker given on transmit. Optional.
+ * @param [out] timestamp Returned timestamp of transmitted frame. Optional.
+ * @returns Operation error status. See @ref fdcan_error.
+ */
+int fdcan_get_tx_event(uint32_t canport, uint32_t *id, bool *ext,
+		uint8_t *marker, uint16_t *timestamp)
+{
+	uint32_t txefs = FDCAN_TXEFS(canport);
+	unsigned get_index;
+
+	if (((txefs >> FDCAN_TXEFS_EFFL_SHIFT) & FDCAN_TXEFS_EFFL_MASK) == 0) {
+		return FDCAN_E_NOTAVAIL;
+	}
+
+	get_index = (txefs >> FDCAN_TXEFS_EFGI_SHIFT) & FDCAN_TXEFS_EFGI_MASK;
+
+	const struct fdcan_tx_event_element *event =
+		fdcan_get_txevt_addr(canport) + get_index;
+	uint32_t identifier_flags = event->identifier_flags;
+	uint32_t evt_fmt_dlc_ts = event->evt_fmt_dlc_ts;
+
+	if (ext) {
+		*ext = (identifier_flags & FDCAN_FIFO_XTD) == FDCAN_FIFO_XTD;
+	}
+
+	if (id) {
+		if ((identifier_flags & FDCAN_FIFO_XTD) == FDCAN_FIFO_XTD) {
+			*id = (identifier_flags >> FDCAN_FIFO_EID_SHIFT)
+				& FDCAN_FIFO_EID_MASK;
+		} else {
+			*id = (identifier_flags >> FDCAN_FIFO_SID_SHIFT)
+				& FDCAN_FIFO_SID_MASK;
+		}
+	}
+
+	if (marker) {
+		*marker = (uint8_t) ((evt_fmt_dlc_ts >> FDCAN_FIFO_MM_SHIFT)
+			& FDCAN_FIFO_MM_MASK);
+	}
+
+	if (timestamp) {
+		*timestamp = (uint16_t) ((evt_fmt_dlc_ts >> FDCAN_FIFO_TXTS_SHIFT)
+			& FDCAN_FIFO_TXTS_MASK);
+	}
+
+	FDCAN_TXEFA(canport) = get_index << FDCAN_TXEFA_EFAI_SHIFT;
+
+	return FDCAN_E_OK;
+}
+
 /** Release receive oldest FIFO entry.
  *
  * This function will mask oldest entry in FIFO as released making
@@ -629,14 +921,10 @@ void fdcan_release_fifo(uint32_t canport, uint8_t fifo_id)
 {
 	unsigned pending_frames, get_index;
 
-	get_index = (FDCAN_RXFIS(canport, fifo_id) >> FDCAN_RXFIFO_GI_SHIFT)
-		& FDCAN_RXFIFO_GI_SHIFT;
-
-	pending_frames = (FDCAN_RXFIS(canport, fifo_id) >> FDCAN_RXFIFO_FL_SHIFT)
-		& FDCAN_RXFIFO_FL_SHIFT;
+	fdcan_get_fill_rxfifo(canport, fifo_id, &get_index, &pending_frames);
 
 	if (pending_frames) {
-		FDCAN_RXFIA(canport, fifo_id) |= get_index << FDCAN_RXFIFO_AI_SHIFT;
+		FDCAN_RXFIA(canport, fifo_id) = get_index << FDCAN_RXFIFO_AI_SHIFT;
 	}
 }
 
@@ -190,10 +190,129 @@ void flash_program_byte(uint32_t address, uint8_t data)
 	FLASH_CR &= ~FLASH_CR_PG;		/* Disable the PG bit. */
 }
 
+/* Status flags that abort a bulk programming run. */
+#if defined(FLASH_SR_PGSERR)
+#define FLASH_PROGRAM_ERRORS	(FLASH_SR_PGSERR | FLASH_SR_PGPERR | \
+				 FLASH_SR_PGAERR | FLASH_SR_WRPERR)
+#else
+#define FLASH_PROGRAM_ERRORS	(FLASH_SR_ERSERR | FLASH_SR_PGPERR | \
+				 FLASH_SR_PGAERR | FLASH_SR_WRPERR)
+#endif
+
+/* The bulk programming loop is shared by the flash and RAM resident entry
+ * points, so it must not call out of line code. */
+#define FLASH_INLINE	static inline __attribute__((always_inline))
+
+FLASH_INLINE void flash_fast_wait(void)
+{
+	/* Make sure the write has left the write buffer (F7 AXI) */
+	__asm__ volatile("dsb":::"memory");
+	while (FLASH_SR & FLASH_SR_BSY);
+}
+
+FLASH_INLINE void flash_fast_set_size(uint32_t psize)
+{
+	FLASH_CR &= ~FLASH_CR_PG;
+	FLASH_CR = (FLASH_CR & ~(FLASH_CR_PROGRAM_MASK << FLASH_CR_PROGRAM_SHIFT)) |
+		   (psize << FLASH_CR_PROGRAM_SHIFT) | FLASH_CR_PG;
+}
+
+FLASH_INLINE uint32_t flash_fast_load32(const uint8_t *p)
+{
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+	       ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+FLASH_INLINE uint32_t flash_fast_bytes(uint32_t address, const uint8_t *data,
+				       uint32_t len)
+{
+	uint32_t i;
+
+	for (i = 0; i < len; i++) {
+		MMIO8(address + i) = data[i];
+		flash_fast_wait();
+		if (FLASH_SR & FLASH_PROGRAM_ERRORS) {
+			break;
+		}
+	}
+	return FLASH_SR & FLASH_PROGRAM_ERRORS;
+}
+
+FLASH_INLINE uint32_t flash_fast_run(uint32_t address, const uint8_t *data,
+				     uint32_t len, uint32_t program_size)
+{
+	uint32_t unit;
+	uint32_t head;
+	uint32_t body;
+	uint32_t err;
+
+	program_size &= FLASH_CR_PROGRAM_MASK;
+	unit = 1U << program_size;
+	head = (unit - (address & (unit - 1))) & (unit - 1);
+
+	if (head > len) {
+		head = len;
+	}
+	body = (len - head) & ~(unit - 1);
+
+	while (FLASH_SR & FLASH_SR_BSY);
+	FLASH_SR = FLASH_PROGRAM_ERRORS;
+
+	/* Unaligned head bytes */
+	flash_fast_set_size(FLASH_CR_PROGRAM_X8);
+	err = flash_fast_bytes(address, data, head);
+	address += head;
+	data += head;
+	len -= head;
+
+	if (!err && body) {
+		uint32_t end = address + body;
+
+		flash_fast_set_size(program_size);
+		while (address < end) {
+			switch (program_size) {
+			case FLASH_CR_PROGRAM_X64:
+				MMIO32(address) = flash_fast_load32(data);
+				MMIO32(address + 4) = flash_fast_load32(data + 4);
+				break;
+			case FLASH_CR_PROGRAM_X32:
+				MMIO32(address) = flash_fast_load32(data);
+				break;
+			case FLASH_CR_PROGRAM_X16:
+				MMIO16(address) = (uint16_t)(data[0] |
+							     (data[1] << 8));
+				break;
+			default:
+				MMIO8(address) = data[0];
+				break;
+			}
+			flash_fast_wait();
+			if (FLASH_SR & FLASH_PROGRAM_ERRORS) {
+				err = FLASH_SR & FLASH_PROGRAM_ERRORS;
+				break;
+			}
+			address += unit;
+			data += unit;
+		}
+		len -= body;
+	}
+
+	/* Unaligned tail bytes, also everything when less than a unit */
+	if (!err && len) {
+		flash_fast_set_size(FLASH_CR_PROGRAM_X8);
+		err = flash_fast_bytes(address, data, len);
+	}
+
+	FLASH_CR &= ~FLASH_CR_PG;
+	return err;
+}
+
 /*---------------------------------------------------------------------------*/
 /** @brief Program a Data Block to FLASH
 
-This programs an arbitrary length data block to FLASH memory.
+This programs an arbitrary length data block to FLASH memory, a byte at a
+time so that it is safe at any supply voltage. Use flash_program_fast() with
+a wider programming size when the supply allows it.
 The program error flag should be checked separately for the event that memory
 was not properly erased.
 
@@ -204,13 +323,78 @@ was not properly erased.
 
 void flash_program(uint32_t address, const uint8_t *data, uint32_t len)
 {
-	/* TODO: Use dword and word size program operations where possible for
-	 * turbo speed.
-	 */
-	uint32_t i;
-	for (i = 0; i < len; i++) {
-		flash_program_byte(address+i, data[i]);
+	flash_fast_run(address, data, len, FLASH_CR_PROGRAM_X8);
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Select the Program Parallelism for a Supply Voltage
+
+Picks the widest programming size allowed by the reference manual for the
+given supply: x8 below 2.1V, x16 below 2.7V, x32 above and x64 when an
+external programming voltage is applied to VPP.
+
+@param[in] vdd_mv Supply voltage in millivolts.
+@param[in] external_vpp True if 8-9V is applied to the VPP pin.
+@returns Programming size: @ref flash_cr_program_width
+*/
+
+uint32_t flash_program_size_for_voltage(uint32_t vdd_mv, bool external_vpp)
+{
+	if (vdd_mv < 2100) {
+		return FLASH_CR_PROGRAM_X8;
+	}
+	if (vdd_mv < 2700) {
+		return FLASH_CR_PROGRAM_X16;
 	}
+	return external_vpp ? FLASH_CR_PROGRAM_X64 : FLASH_CR_PROGRAM_X32;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Program a Data Block to FLASH with Wide Writes
+
+Programs an arbitrary length data block with PG kept set for the whole run.
+Bytes up to the first address aligned to the programming size and after the
+last one are programmed a byte at a time, the rest in units of the
+programming size. The source buffer needs no particular alignment. The run
+stops at the first programming error.
+
+The flash must be unlocked and the target area erased.
+
+@param[in] address Starting address in Flash.
+@param[in] data Pointer to start of data block.
+@param[in] len Length of data block.
+@param[in] program_size Programming size allowed by the supply voltage:
+	@ref flash_cr_program_width, see flash_program_size_for_voltage()
+@returns Error flags of FLASH_SR, 0 on success.
+*/
+
+uint32_t flash_program_fast(uint32_t address, const uint8_t *data,
+			    uint32_t len, uint32_t program_size)
+{
+	return flash_fast_run(address, data, len, program_size);
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Program a Data Block to FLASH with Wide Writes, from RAM
+
+Same as flash_program_fast(), but the code runs from RAM (the .ramfunc
+section, copied along with .data at startup), so the loop never fetches
+from the flash being programmed and does not stall on reads while a write is
+in progress. Interrupt handlers that execute from flash will still stall.
+
+@param[in] address Starting address in Flash.
+@param[in] data Pointer to start of data block, not in the bank programmed.
+@param[in] len Length of data block.
+@param[in] program_size Programming size allowed by the supply voltage:
+	@ref flash_cr_program_width, see flash_program_size_for_voltage()
+@returns Error flags of FLASH_SR, 0 on success.
+*/
+
+__attribute__((section(".ramfunc.flash_program_fast_ram"), noinline))
+uint32_t flash_program_fast_ram(uint32_t address, const uint8_t *data,
+				uint32_t len, uint32_t program_size)
+{
+	return flash_fast_run(address, data, len, program_size);
 }
 
 /*---------------------------------------------------------------------------*/
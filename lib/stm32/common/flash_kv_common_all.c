@@ -0,0 +1,575 @@
+/** @defgroup flash_kv_file Flash key/value store
+@ingroup peripheral_apis
+
+@brief Log structured key/value store with wear levelling on internal flash.
+
+Each sector starts with an 8 byte header holding a magic number and a
+sequence number that orders the sectors of the log. Records follow back to
+back, 8 byte aligned:
+
+@code
+	uint16_t key;
+	uint16_t len;		(FLASH_KV_TOMBSTONE for a deletion)
+	uint32_t crc;		(CRC-32 of key, len and data)
+	uint8_t data[len];
+@endcode
+
+The record header is programmed before the data so that the log can always
+be walked, and a sector in which a damaged record is found is closed for
+appends, so flash is never programmed twice.
+
+LGPL License Terms @ref lgpl_license
+*/
+/*
+ * This file is part of the libopencm3 project.
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**@{*/
+
+#include <stddef.h>
+#include <libopencm3/stm32/flash_kv.h>
+
+#define FLASH_KV_MAGIC		0x564b4c31
+#define FLASH_KV_TOMBSTONE	0xfffe
+#define FLASH_KV_HDR_SIZE	8
+#define FLASH_KV_ALIGN(x)	(((x) + 7) & ~7U)
+
+/* Erased flash reads as ones, except on the L0/L1 program memory. */
+#if defined(LIBOPENCM3_FLASH_COMMON_L01_H)
+#define FLASH_KV_ERASED		0x00000000U
+#else
+#define FLASH_KV_ERASED		0xffffffffU
+#endif
+
+/*---------------------------------------------------------------------------*/
+/* Family specific erase and program */
+
+#if defined(LIBOPENCM3_FLASH_COMMON_F24_H)
+
+static void flash_kv_erase_raw(const struct flash_kv *kv,
+			       const struct flash_kv_sector *s)
+{
+	flash_erase_sector(s->erase, kv->program_size);
+}
+
+static void flash_kv_program_raw(const struct flash_kv *kv, uint32_t address,
+				 const uint8_t *data, uint32_t len)
+{
+	flash_program_fast(address, data, len, kv->program_size);
+}
+
+#elif defined(LIBOPENCM3_FLASH_COMMON_F01_H)
+
+static void flash_kv_erase_raw(const struct flash_kv *kv,
+			       const struct flash_kv_sector *s)
+{
+	uint32_t a;
+
+	(void)kv;
+	for (a = s->address; a < s->address + s->size; a += s->erase) {
+		flash_erase_page(a);
+	}
+}
+
+static void flash_kv_program_raw(const struct flash_kv *kv, uint32_t address,
+				 const uint8_t *data, uint32_t len)
+{
+	uint32_t i;
+
+	(void)kv;
+	for (i = 0; i < len; i += 2) {
+		uint16_t hw = data[i];
+		hw |= (i + 1 < len) ? (data[i + 1] << 8) : 0xff00;
+		flash_program_half_word(address + i, hw);
+	}
+}
+
+#elif defined(LIBOPENCM3_FLASH_COMMON_L01_H)
+
+static void flash_kv_erase_raw(const struct flash_kv *kv,
+			       const struct flash_kv_sector *s)
+{
+	uint32_t a;
+
+	(void)kv;
+	for (a = s->address; a < s->address + s->size; a += s->erase) {
+		flash_erase_page(a);
+	}
+}
+
+static void flash_kv_program_raw(const struct flash_kv *kv, uint32_t address,
+				 const uint8_t *data, uint32_t len)
+{
+	uint32_t i;
+	uint32_t j;
+
+	(void)kv;
+	for (i = 0; i < len; i += 4) {
+		uint32_t w = 0;
+		for (j = 0; j < 4 && i + j < len; j++) {
+			w |= (uint32_t)data[i + j] << (8 * j);
+		}
+		MMIO32(address + i) = w;
+		while (FLASH_SR & FLASH_SR_BSY);
+	}
+}
+
+#else
+#error "flash_kv is not supported on this family"
+#endif
+
+/*---------------------------------------------------------------------------*/
+
+static uint32_t flash_kv_crc(uint32_t crc, const uint8_t *p, uint32_t len)
+{
+	int k;
+
+	crc = ~crc;
+	while (len--) {
+		crc ^= *p++;
+		for (k = 0; k < 8; k++) {
+			crc = (crc >> 1) ^ (0xedb88320U & -(crc & 1));
+		}
+	}
+	return ~crc;
+}
+
+static bool flash_kv_blank(uint32_t address, uint32_t len)
+{
+	uint32_t i;
+
+	for (i = 0; i < len; i += 4) {
+		if (MMIO32(address + i) != FLASH_KV_ERASED) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/* Program and read back. */
+static bool flash_kv_program(const struct flash_kv *kv, uint32_t address,
+			     const uint8_t *data, uint32_t len)
+{
+	uint32_t i;
+
+	flash_kv_program_raw(kv, address, data, len);
+	for (i = 0; i < len; i++) {
+		if (MMIO8(address + i) != data[i]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool flash_kv_erase(const struct flash_kv *kv, uint8_t n)
+{
+	const struct flash_kv_sector *s = &kv->sectors[n];
+
+	flash_kv_erase_raw(kv, s);
+	return flash_kv_blank(s->address, s->size);
+}
+
+static uint8_t flash_kv_head(const struct flash_kv *kv)
+{
+	return (kv->oldest + kv->used - 1) % kv->nsectors;
+}
+
+static uint32_t flash_kv_end(const struct flash_kv *kv, uint8_t n)
+{
+	return kv->sectors[n].address + kv->sectors[n].size;
+}
+
+/* Start a new sector at the head of the log. */
+static bool flash_kv_open(struct flash_kv *kv)
+{
+	uint8_t n = (kv->oldest + kv->used) % kv->nsectors;
+	const struct flash_kv_sector *s = &kv->sectors[n];
+	uint32_t hdr[2] = { FLASH_KV_MAGIC, kv->seq + 1 };
+
+	if (!flash_kv_blank(s->address, s->size) && !flash_kv_erase(kv, n)) {
+		return false;
+	}
+
+	if (!flash_kv_program(kv, s->address, (const uint8_t *)hdr,
+			      sizeof(hdr))) {
+		/* Left to be erased by the next attempt */
+		return false;
+	}
+	kv->used++;
+	kv->seq++;
+	kv->write = s->address + FLASH_KV_HDR_SIZE;
+	return true;
+}
+
+static bool flash_kv_compact(struct flash_kv *kv);
+
+static bool flash_kv_fits(const struct flash_kv *kv, uint32_t size)
+{
+	return kv->write + size <= flash_kv_end(kv, flash_kv_head(kv));
+}
+
+static bool flash_kv_append(struct flash_kv *kv, uint16_t key,
+			    const uint8_t *data, uint16_t len)
+{
+	uint16_t stored = (len == FLASH_KV_TOMBSTONE) ? 0 : len;
+	uint32_t size = FLASH_KV_HDR_SIZE + FLASH_KV_ALIGN(stored);
+	uint32_t hdr[2];
+	uint32_t address;
+
+	if (!flash_kv_fits(kv, size)) {
+		/* The last free sector is kept for compaction. */
+		if (!kv->compacting && kv->nsectors - kv->used < 2 &&
+		    !flash_kv_compact(kv)) {
+			return false;
+		}
+		if (!flash_kv_fits(kv, size) &&
+		    (kv->used == kv->nsectors || !flash_kv_open(kv) ||
+		     !flash_kv_fits(kv, size))) {
+			return false;
+		}
+	}
+
+	hdr[0] = key | ((uint32_t)len << 16);
+	hdr[1] = flash_kv_crc(flash_kv_crc(0, (const uint8_t *)&hdr[0], 4),
+			      data, stored);
+
+	address = kv->write;
+	kv->write += size;
+	if (!flash_kv_program(kv, address, (const uint8_t *)hdr, sizeof(hdr)) ||
+	    !flash_kv_program(kv, address + FLASH_KV_HDR_SIZE, data, stored)) {
+		/* Close the sector, the next append opens a new one. */
+		kv->write = flash_kv_end(kv, flash_kv_head(kv));
+		return false;
+	}
+
+	kv->index[key] = (len == FLASH_KV_TOMBSTONE) ? 0 : address;
+	return true;
+}
+
+/* Move the live records of the oldest sector to the head and erase it. With
+ * a single sector in use, that sector is closed and copied to a new one. */
+static bool flash_kv_compact(struct flash_kv *kv)
+{
+	uint8_t n = kv->oldest;
+	uint32_t address = kv->sectors[n].address + FLASH_KV_HDR_SIZE;
+	uint32_t end = flash_kv_end(kv, n);
+	bool ok = true;
+
+	if (flash_kv_head(kv) == n) {
+		kv->write = end;
+	}
+
+	kv->compacting = true;
+	while (ok && address + FLASH_KV_HDR_SIZE <= end) {
+		uint32_t word = MMIO32(address);
+		uint16_t key = word & 0xffff;
+		uint16_t len = word >> 16;
+		uint16_t stored = (len == FLASH_KV_TOMBSTONE) ? 0 : len;
+
+		if ((word == FLASH_KV_ERASED &&
+		     MMIO32(address + 4) == FLASH_KV_ERASED) ||
+		    stored > FLASH_KV_MAX_LEN) {
+			break;
+		}
+		/* Only the latest value of a key is live. Deletions are
+		 * dropped, nothing older than this sector is left. */
+		if (key < kv->keys && kv->index[key] == address) {
+			ok = flash_kv_append(kv, key, (const uint8_t *)address +
+					     FLASH_KV_HDR_SIZE, len);
+		}
+		address += FLASH_KV_HDR_SIZE + FLASH_KV_ALIGN(stored);
+	}
+	kv->compacting = false;
+
+	if (!ok) {
+		return false;
+	}
+
+	kv->oldest = (n + 1) % kv->nsectors;
+	kv->used--;
+	if (!flash_kv_erase(kv, n)) {
+		return false;
+	}
+	return kv->used || flash_kv_open(kv);
+}
+
+/* Walk the records of a sector, returns the end of the valid log in it.
+ * Sets *damaged if the walk stopped on a record that is not intact. */
+static uint32_t flash_kv_replay(struct flash_kv *kv, uint8_t n,
+				bool *damaged)
+{
+	uint32_t address = kv->sectors[n].address + FLASH_KV_HDR_SIZE;
+	uint32_t end = flash_kv_end(kv, n);
+
+	*damaged = false;
+	while (address + FLASH_KV_HDR_SIZE <= end) {
+		uint32_t word = MMIO32(address);
+		uint16_t key = word & 0xffff;
+		uint16_t len = word >> 16;
+		uint16_t stored = (len == FLASH_KV_TOMBSTONE) ? 0 : len;
+		uint32_t crc;
+
+		if (word == FLASH_KV_ERASED &&
+		    MMIO32(address + 4) == FLASH_KV_ERASED) {
+			break;
+		}
+		if (stored > FLASH_KV_MAX_LEN ||
+		    address + FLASH_KV_HDR_SIZE + stored > end) {
+			*damaged = true;
+			return end;
+		}
+
+		crc = flash_kv_crc(0, (const uint8_t *)address, 4);
+		crc = flash_kv_crc(crc, (const uint8_t *)address +
+				   FLASH_KV_HDR_SIZE, stored);
+		if (crc != MMIO32(address + 4)) {
+			*damaged = true;
+		} else if (key < kv->keys) {
+			kv->index[key] = (len == FLASH_KV_TOMBSTONE) ? 0 :
+					 address;
+		}
+		address += FLASH_KV_HDR_SIZE + FLASH_KV_ALIGN(stored);
+	}
+	return address;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Flash KV Mount the Store
+
+Finds the log, rebuilds the index and cleans up after an interrupted
+operation. Sectors that are not part of the log are erased if needed, and an
+empty store is initialised.
+
+@param[in] kv Store with the public fields filled in
+@returns false if the flash could not be erased or programmed
+*/
+bool flash_kv_mount(struct flash_kv *kv)
+{
+	uint32_t min_seq = 0;
+	bool found = false;
+	bool damaged = false;
+	uint16_t key;
+	uint8_t n;
+	uint8_t i;
+
+	for (key = 0; key < kv->keys; key++) {
+		kv->index[key] = 0;
+	}
+	kv->compacting = false;
+
+	/* The log starts at the valid sector with the lowest sequence. */
+	for (n = 0; n < kv->nsectors; n++) {
+		uint32_t a = kv->sectors[n].address;
+		if (MMIO32(a) == FLASH_KV_MAGIC &&
+		    (!found || MMIO32(a + 4) < min_seq)) {
+			min_seq = MMIO32(a + 4);
+			kv->oldest = n;
+			found = true;
+		}
+	}
+
+	if (!found) {
+		return flash_kv_format(kv);
+	}
+
+	/* and continues through the sectors with consecutive sequences. */
+	kv->seq = min_seq;
+	kv->used = 1;
+	while (kv->used < kv->nsectors) {
+		uint32_t a = kv->sectors[(kv->oldest + kv->used) %
+					 kv->nsectors].address;
+		if (MMIO32(a) != FLASH_KV_MAGIC ||
+		    MMIO32(a + 4) != kv->seq + 1) {
+			break;
+		}
+		kv->seq++;
+		kv->used++;
+	}
+
+	for (i = 0; i < kv->used; i++) {
+		kv->write = flash_kv_replay(kv, (kv->oldest + i) % kv->nsectors,
+					    &damaged);
+	}
+	if (damaged) {
+		kv->write = flash_kv_end(kv, flash_kv_head(kv));
+	}
+
+	/* Anything outside the log is left over from an interrupted
+	 * sector open or erase. */
+	for (i = kv->used; i < kv->nsectors; i++) {
+		n = (kv->oldest + i) % kv->nsectors;
+		if (!flash_kv_blank(kv->sectors[n].address,
+				    kv->sectors[n].size) &&
+		    !flash_kv_erase(kv, n)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Flash KV Erase the Store
+
+@param[in] kv Store with the public fields filled in
+@returns false if the flash could not be erased or programmed
+*/
+bool flash_kv_format(struct flash_kv *kv)
+{
+	uint16_t i;
+	uint8_t n;
+
+	for (i = 0; i < kv->keys; i++) {
+		kv->index[i] = 0;
+	}
+	for (n = 0; n < kv->nsectors; n++) {
+		if (!flash_kv_blank(kv->sectors[n].address,
+				    kv->sectors[n].size) &&
+		    !flash_kv_erase(kv, n)) {
+			return false;
+		}
+	}
+
+	kv->compacting = false;
+	kv->oldest = 0;
+	kv->used = 0;
+	kv->seq = 0;
+	return flash_kv_open(kv);
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Flash KV Find a Value
+
+@param[in] kv Store
+@param[in] key Key
+@param[out] len Length of the value
+@returns Pointer to the value in flash, NULL if the key is not set
+*/
+const void *flash_kv_find(const struct flash_kv *kv, uint16_t key,
+			  uint16_t *len)
+{
+	uint32_t address;
+
+	if (key >= kv->keys || kv->index[key] == 0) {
+		return NULL;
+	}
+	address = kv->index[key];
+	*len = MMIO32(address) >> 16;
+	return (const void *)(address + FLASH_KV_HDR_SIZE);
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Flash KV Read a Value
+
+@param[in] kv Store
+@param[in] key Key
+@param[out] buf Destination
+@param[in] size Size of the destination, a longer value is truncated
+@returns Length of the stored value, -1 if the key is not set
+*/
+int32_t flash_kv_get(const struct flash_kv *kv, uint16_t key,
+		     void *buf, uint16_t size)
+{
+	const uint8_t *src;
+	uint8_t *dst = buf;
+	uint16_t len;
+	uint16_t i;
+
+	src = flash_kv_find(kv, key, &len);
+	if (src == NULL) {
+		return -1;
+	}
+	for (i = 0; i < len && i < size; i++) {
+		dst[i] = src[i];
+	}
+	return len;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Flash KV Write a Value
+
+Appends a record, unless the value is unchanged. May compact the oldest
+sector first if there is no free sector left.
+
+@param[in] kv Store
+@param[in] key Key
+@param[in] data Value
+@param[in] len Length of the value, up to @ref FLASH_KV_MAX_LEN
+@returns false if the value could not be written
+*/
+bool flash_kv_set(struct flash_kv *kv, uint16_t key,
+		  const void *data, uint16_t len)
+{
+	const uint8_t *old;
+	uint16_t old_len;
+	uint16_t i;
+
+	if (key >= kv->keys || len > FLASH_KV_MAX_LEN) {
+		return false;
+	}
+
+	old = flash_kv_find(kv, key, &old_len);
+	if (old && old_len == len) {
+		for (i = 0; i < len; i++) {
+			if (old[i] != ((const uint8_t *)data)[i]) {
+				break;
+			}
+		}
+		if (i == len) {
+			return true;
+		}
+	}
+	return flash_kv_append(kv, key, data, len);
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Flash KV Delete a Value
+
+@param[in] kv Store
+@param[in] key Key
+@returns false if the deletion could not be written
+*/
+bool flash_kv_delete(struct flash_kv *kv, uint16_t key)
+{
+	if (key >= kv->keys) {
+		return false;
+	}
+	if (kv->index[key] == 0) {
+		return true;
+	}
+	return flash_kv_append(kv, key, NULL, FLASH_KV_TOMBSTONE);
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief Flash KV Compact the Oldest Sector
+
+Does nothing while more than one sector is free. Otherwise copies the live
+records of the oldest sector to the head of the log and erases it. Call
+from an idle loop to keep writes from having to wait for an erase. With
+only two sectors there is no spare to compact into ahead of time, and the
+compaction always happens in flash_kv_set().
+
+@param[in] kv Store
+@returns true if a sector was reclaimed
+*/
+bool flash_kv_gc(struct flash_kv *kv)
+{
+	if (kv->nsectors - kv->used >= 2 || kv->used < 2) {
+		return false;
+	}
+	return flash_kv_compact(kv);
+}
+
+/**@}*/
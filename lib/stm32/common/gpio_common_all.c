@@ -24,6 +24,8 @@
  * along with this library.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+/* The library always provides the out-of-line functions */
+#undef LIBOPENCM3_INLINE_ACCESSORS
 #include <libopencm3/stm32/gpio.h>
 
 /**@{*/
@@ -40,7 +42,7 @@ Set one or more pins of the given GPIO port to 1 in an atomic operation.
 */
 void gpio_set(uint32_t gpioport, uint16_t gpios)
 {
-	GPIO_BSRR(gpioport) = gpios;
+	gpio_set_inline(gpioport, gpios);
 }
 
 /*---------------------------------------------------------------------------*/
@@ -55,7 +57,7 @@ Clear one or more pins of the given GPIO port to 0 in an atomic operation.
 */
 void  gpio_clear(uint32_t gpioport, uint16_t gpios)
 {
-	GPIO_BSRR(gpioport) = (gpios << 16);
+	gpio_clear_inline(gpioport, gpios);
 }
 
 /*---------------------------------------------------------------------------*/
@@ -70,7 +72,7 @@ void  gpio_clear(uint32_t gpioport, uint16_t gpios)
 */
 uint16_t gpio_get(uint32_t gpioport, uint16_t gpios)
 {
-	return gpio_port_read(gpioport) & gpios;
+	return gpio_get_inline(gpioport, gpios);
 }
 
 /*---------------------------------------------------------------------------*/
@@ -86,8 +88,7 @@ the non-toggled pins are not affected.
 */
 void gpio_toggle(uint32_t gpioport, uint16_t gpios)
 {
-	uint32_t port = GPIO_ODR(gpioport);
-	GPIO_BSRR(gpioport) = ((port & gpios) << 16) | (~port & gpios);
+	gpio_toggle_inline(gpioport, gpios);
 }
 
 /*---------------------------------------------------------------------------*/
@@ -101,7 +102,7 @@ valid pin data.
 */
 uint16_t gpio_port_read(uint32_t gpioport)
 {
-	return (uint16_t)GPIO_IDR(gpioport);
+	return gpio_port_read_inline(gpioport);
 }
 
 /*---------------------------------------------------------------------------*/
@@ -114,7 +115,7 @@ Write a value to the given GPIO port.
 */
 void gpio_port_write(uint32_t gpioport, uint16_t data)
 {
-	GPIO_ODR(gpioport) = data;
+	gpio_port_write_inline(gpioport, data);
 }
 
 /*---------------------------------------------------------------------------*/
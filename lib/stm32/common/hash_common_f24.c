@@ -32,8 +32,13 @@
 
 /**@{*/
 
+#include <libopencm3/stm32/dbgmcu.h>
 #include <libopencm3/stm32/hash.h>
 
+/* Parts whose processor also does SHA-224/256, with HASH_CSR0..53 */
+#define DBGMCU_IDCODE_DEV_ID_STM32F42X_43X	0x419
+#define DBGMCU_IDCODE_DEV_ID_STM32F46X_47X	0x434
+
 /*---------------------------------------------------------------------------*/
 /** @brief HASH Set Mode
 
@@ -160,5 +165,67 @@ void hash_get_result(uint32_t *data)
 		data[4] = HASH_HR[4];
 	}
 }
+
+static int hash_context_count(const struct hash_context *ctx)
+{
+	uint32_t devid = DBGMCU_IDCODE & DBGMCU_IDCODE_DEV_ID_MASK;
+
+	if (!(ctx->cr & HASH_CR_MODE)) {
+		return HASH_CSR_COUNT_HASH;
+	}
+	if (devid == DBGMCU_IDCODE_DEV_ID_STM32F42X_43X ||
+	    devid == DBGMCU_IDCODE_DEV_ID_STM32F46X_47X) {
+		return HASH_CSR_COUNT;
+	}
+	return HASH_CSR_COUNT_SHA1;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief HASH Save Context
+
+Suspends the message in progress so that the processor can be used for
+another one. Must be called between blocks: not while a DMA transfer is
+feeding the processor, and not once the digest calculation has started.
+In hash mode only HASH_CSR0..37 are saved, in HMAC mode all of them: up to
+HASH_CSR50 or HASH_CSR53 depending on the processor, told apart by the
+device ID.
+
+@param[out] ctx Context storage
+*/
+
+void hash_context_save(struct hash_context *ctx)
+{
+	int i;
+
+	while (HASH_SR & HASH_SR_BUSY);
+
+	ctx->imr = HASH_IMR;
+	ctx->str = HASH_STR;
+	ctx->cr = HASH_CR & ~HASH_CR_INIT;
+	for (i = 0; i < hash_context_count(ctx); i++) {
+		ctx->csr[i] = HASH_CSR[i];
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief HASH Restore Context
+
+Resumes a message suspended with hash_context_save().
+
+@param[in] ctx Context storage
+*/
+
+void hash_context_restore(const struct hash_context *ctx)
+{
+	int i;
+
+	HASH_IMR = ctx->imr;
+	HASH_STR = ctx->str;
+	HASH_CR = ctx->cr;
+	HASH_CR |= HASH_CR_INIT;
+	for (i = 0; i < hash_context_count(ctx); i++) {
+		HASH_CSR[i] = ctx->csr[i];
+	}
+}
 /**@}*/
 
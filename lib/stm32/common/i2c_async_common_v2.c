@@ -0,0 +1,410 @@
+/** @defgroup i2c_async_file I2C transaction engine
+@ingroup peripheral_apis
+
+@brief Interrupt driven transaction queue for the STM32 I2C peripherals
+with the RELOAD/AUTOEND master (F0, F3, F7, G0, G4, L0, L4, U5).
+
+The peripheral must be configured (timing, filters) and enabled. Both the
+event and the error vectors must call i2c_bus_irq_handler(); on parts with a
+single I2C vector that one call covers both. If timeouts are used,
+i2c_bus_tick() must be called periodically.
+
+LGPL License Terms @ref lgpl_license
+*/
+/*
+ * This file is part of the libopencm3 project.
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**@{*/
+
+#include <libopencm3/cm3/cortex.h>
+#include <libopencm3/stm32/i2c_async.h>
+
+#define I2C_BUS_PHASE_WRITE	0
+#define I2C_BUS_PHASE_READ	1
+
+#define I2C_BUS_NBYTES_MAX	255
+
+#define I2C_BUS_IRQS	(I2C_CR1_ERRIE | I2C_CR1_TCIE | I2C_CR1_STOPIE | \
+			 I2C_CR1_NACKIE | I2C_CR1_RXIE | I2C_CR1_TXIE)
+
+static void i2c_bus_start(struct i2c_bus *bus);
+
+/* Program the next NBYTES chunk of the current phase. */
+static void i2c_bus_load(struct i2c_bus *bus, uint32_t cr2)
+{
+	struct i2c_transaction *t = bus->head;
+	size_t n = bus->pending;
+
+	if (n > I2C_BUS_NBYTES_MAX) {
+		n = I2C_BUS_NBYTES_MAX;
+	}
+	bus->pending -= n;
+
+	cr2 |= n << I2C_CR2_NBYTES_SHIFT;
+	if (bus->pending) {
+		cr2 |= I2C_CR2_RELOAD;
+	} else if (bus->phase == I2C_BUS_PHASE_READ || t->rn == 0) {
+		cr2 |= I2C_CR2_AUTOEND;
+	}
+	/* Otherwise TC is raised and the read follows with a repeated start */
+	I2C_CR2(bus->i2c) = cr2;
+}
+
+static void i2c_bus_start_phase(struct i2c_bus *bus, uint8_t phase)
+{
+	struct i2c_transaction *t = bus->head;
+	uint32_t i2c = bus->i2c;
+	uint32_t cr2 = ((uint32_t)t->addr << I2C_CR2_SADD_7BIT_SHIFT) |
+		       I2C_CR2_START;
+	uint32_t irqs = I2C_BUS_IRQS;
+
+	bus->phase = phase;
+	bus->pos = 0;
+	bus->pending = (phase == I2C_BUS_PHASE_READ) ? t->rn : t->wn;
+	if (phase == I2C_BUS_PHASE_READ) {
+		cr2 |= I2C_CR2_RD_WRN;
+	}
+
+#if defined(LIBOPENCM3_DMA_XFER_COMMON_ALL_H)
+	bus->dma_phase = bus->use_dma && bus->pending &&
+			 bus->pending <= UINT16_MAX;
+	if (bus->dma_phase) {
+		irqs &= ~(I2C_CR1_RXIE | I2C_CR1_TXIE);
+		if (phase == I2C_BUS_PHASE_READ) {
+			bus->rx_xfer.dst = (uint32_t)t->r;
+			bus->rx_xfer.count = bus->pending;
+			dma_xfer_submit(&bus->rx_xfer);
+			I2C_CR1(i2c) |= I2C_CR1_RXDMAEN;
+		} else {
+			bus->tx_xfer.src = (uint32_t)t->w;
+			bus->tx_xfer.count = bus->pending;
+			dma_xfer_submit(&bus->tx_xfer);
+			I2C_CR1(i2c) |= I2C_CR1_TXDMAEN;
+		}
+	}
+#endif
+
+	I2C_CR1(i2c) = (I2C_CR1(i2c) & ~I2C_BUS_IRQS) | irqs;
+	i2c_bus_load(bus, cr2);
+}
+
+static void i2c_bus_stop_dma(struct i2c_bus *bus)
+{
+#if defined(LIBOPENCM3_DMA_XFER_COMMON_ALL_H)
+	if (bus->dma_phase) {
+		I2C_CR1(bus->i2c) &= ~(I2C_CR1_RXDMAEN | I2C_CR1_TXDMAEN);
+		dma_xfer_abort(&bus->rx_xfer);
+		dma_xfer_abort(&bus->tx_xfer);
+		bus->dma_phase = false;
+	}
+#else
+	(void)bus;
+#endif
+}
+
+/* Retire the head transaction and start the next one. */
+static void i2c_bus_finish(struct i2c_bus *bus, uint8_t status)
+{
+	struct i2c_transaction *t = bus->head;
+
+	I2C_CR1(bus->i2c) &= ~I2C_BUS_IRQS;
+	i2c_bus_stop_dma(bus);
+	if (status == I2C_TRANSACTION_BUS_ERROR ||
+	    status == I2C_TRANSACTION_TIMEOUT) {
+		i2c_bus_recover(bus);
+	}
+
+	bus->head = t->next;
+	if (bus->head == NULL) {
+		bus->tail = NULL;
+	}
+	t->status = status;
+	if (t->callback) {
+		t->callback(t);
+	}
+	if (bus->head) {
+		i2c_bus_start(bus);
+	}
+}
+
+/* Abort the head transaction from outside the I2C interrupt. */
+static void i2c_bus_abort(struct i2c_bus *bus, uint8_t status)
+{
+	CM_ATOMIC_BLOCK() {
+		if (bus->head) {
+			i2c_bus_finish(bus, status);
+		}
+	}
+}
+
+static void i2c_bus_start(struct i2c_bus *bus)
+{
+	struct i2c_transaction *t = bus->head;
+
+	bus->result = I2C_TRANSACTION_PENDING;
+	bus->ticks = t->timeout;
+	i2c_bus_start_phase(bus, (t->wn || !t->rn) ?
+			    I2C_BUS_PHASE_WRITE : I2C_BUS_PHASE_READ);
+}
+
+#if defined(LIBOPENCM3_DMA_XFER_COMMON_ALL_H)
+static void i2c_bus_dma_event(struct dma_xfer *xfer, uint32_t events)
+{
+	/* Completion is signalled by the I2C itself, only errors matter. */
+	if (events & DMA_XFER_EVT_ERROR) {
+		i2c_bus_abort(xfer->user, I2C_TRANSACTION_BUS_ERROR);
+	}
+}
+#endif
+
+/*---------------------------------------------------------------------------*/
+/** @brief I2C Bus Initialise
+
+@param[in] bus Bus state
+@param[in] i2c I2C peripheral identifier @ref i2c_reg_base
+*/
+void i2c_bus_init(struct i2c_bus *bus, uint32_t i2c)
+{
+	bus->i2c = i2c;
+	bus->head = NULL;
+	bus->tail = NULL;
+	bus->recover = NULL;
+	bus->ticks = 0;
+#if defined(LIBOPENCM3_DMA_XFER_COMMON_ALL_H)
+	bus->use_dma = false;
+	bus->dma_phase = false;
+#endif
+	I2C_CR1(i2c) &= ~I2C_BUS_IRQS;
+}
+
+#if defined(LIBOPENCM3_DMA_XFER_COMMON_ALL_H)
+/*---------------------------------------------------------------------------*/
+/** @brief I2C Bus Move Data by DMA
+
+The vectors of both DMA streams/channels must call dma_xfer_irq_handler().
+Data phases longer than 65535 bytes fall back to the data interrupts.
+
+@param[in] bus Bus state, initialised with i2c_bus_init()
+@param[in] dma DMA controller base address: DMA1 or DMA2
+@param[in] rx_channel DMA stream or channel connected to the I2C RX request
+@param[in] rx_request Request routing of the RX side, see struct dma_xfer
+@param[in] tx_channel DMA stream or channel connected to the I2C TX request
+@param[in] tx_request Request routing of the TX side, see struct dma_xfer
+@returns false if one of the DMA streams or channels is in use
+*/
+bool i2c_bus_enable_dma(struct i2c_bus *bus, uint32_t dma,
+			uint8_t rx_channel, uint8_t rx_request,
+			uint8_t tx_channel, uint8_t tx_request)
+{
+	bus->rx_xfer.src = (uint32_t)&I2C_RXDR(bus->i2c);
+	bus->rx_xfer.direction = DMA_XFER_PERIPH_TO_MEM;
+	bus->rx_xfer.src_width = DMA_XFER_WIDTH_8BIT;
+	bus->rx_xfer.dst_width = DMA_XFER_WIDTH_8BIT;
+	bus->rx_xfer.flags = DMA_XFER_DST_INC;
+	bus->rx_xfer.priority = 1;
+	bus->rx_xfer.request = rx_request;
+	bus->rx_xfer.callback = i2c_bus_dma_event;
+	bus->rx_xfer.user = bus;
+
+	bus->tx_xfer.dst = (uint32_t)&I2C_TXDR(bus->i2c);
+	bus->tx_xfer.direction = DMA_XFER_MEM_TO_PERIPH;
+	bus->tx_xfer.src_width = DMA_XFER_WIDTH_8BIT;
+	bus->tx_xfer.dst_width = DMA_XFER_WIDTH_8BIT;
+	bus->tx_xfer.flags = DMA_XFER_SRC_INC;
+	bus->tx_xfer.priority = 1;
+	bus->tx_xfer.request = tx_request;
+	bus->tx_xfer.callback = i2c_bus_dma_event;
+	bus->tx_xfer.user = bus;
+
+	if (!dma_xfer_claim(&bus->rx_xfer, dma, rx_channel)) {
+		return false;
+	}
+	if (!dma_xfer_claim(&bus->tx_xfer, dma, tx_channel)) {
+		dma_xfer_release(&bus->rx_xfer);
+		return false;
+	}
+	bus->use_dma = true;
+	return true;
+}
+#endif
+
+/*---------------------------------------------------------------------------*/
+/** @brief I2C Bus Queue a Transaction
+
+The transaction starts straight away if the bus is idle, otherwise after the
+ones queued before it. It must stay valid until its callback has run, or
+until its status is no longer @ref I2C_TRANSACTION_PENDING.
+
+@param[in] bus Bus state
+@param[in] t Transaction
+*/
+void i2c_transfer_async(struct i2c_bus *bus, struct i2c_transaction *t)
+{
+	t->next = NULL;
+	t->status = I2C_TRANSACTION_PENDING;
+
+	CM_ATOMIC_BLOCK() {
+		if (bus->head == NULL) {
+			bus->head = t;
+			bus->tail = t;
+			i2c_bus_start(bus);
+		} else {
+			bus->tail->next = t;
+			bus->tail = t;
+		}
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief I2C Bus Interrupt Handler
+
+Call from the I2C event and error interrupt vectors.
+
+@param[in] bus Bus state
+*/
+void i2c_bus_irq_handler(struct i2c_bus *bus)
+{
+	uint32_t i2c = bus->i2c;
+	uint32_t isr = I2C_ISR(i2c);
+	struct i2c_transaction *t = bus->head;
+	bool dma = false;
+
+	if (t == NULL) {
+		I2C_CR1(i2c) &= ~I2C_BUS_IRQS;
+		return;
+	}
+#if defined(LIBOPENCM3_DMA_XFER_COMMON_ALL_H)
+	dma = bus->dma_phase;
+#endif
+
+	if (isr & (I2C_ISR_ARLO | I2C_ISR_BERR | I2C_ISR_OVR)) {
+		I2C_ICR(i2c) = I2C_ICR_ARLOCF | I2C_ICR_BERRCF | I2C_ICR_OVRCF;
+		/* No STOP will follow, the master has left the bus. */
+		i2c_bus_finish(bus, (isr & I2C_ISR_ARLO) ?
+			       I2C_TRANSACTION_ARLO : I2C_TRANSACTION_BUS_ERROR);
+		return;
+	}
+
+	if (isr & I2C_ISR_NACKF) {
+		/* The hardware follows up with a STOP, finish on STOPF. */
+		I2C_ICR(i2c) = I2C_ICR_NACKCF;
+		bus->result = I2C_TRANSACTION_NACK;
+		i2c_bus_stop_dma(bus);
+		dma = false;
+	}
+
+	if (!dma && (isr & I2C_ISR_RXNE)) {
+		uint8_t c = I2C_RXDR(i2c);
+		if (bus->pos < t->rn) {
+			t->r[bus->pos++] = c;
+		}
+	}
+	if (!dma && (isr & I2C_ISR_TXIS) && bus->pos < t->wn) {
+		I2C_TXDR(i2c) = t->w[bus->pos++];
+	}
+
+	if (isr & I2C_ISR_TCR) {
+		i2c_bus_load(bus, I2C_CR2(i2c) &
+			     (I2C_CR2_SADD_7BIT_MASK | I2C_CR2_RD_WRN));
+	}
+
+	if (isr & I2C_ISR_TC) {
+		i2c_bus_stop_dma(bus);
+		if (bus->phase == I2C_BUS_PHASE_WRITE && t->rn) {
+			i2c_bus_start_phase(bus, I2C_BUS_PHASE_READ);
+		} else {
+			I2C_CR2(i2c) |= I2C_CR2_STOP;
+		}
+	}
+
+	if (isr & I2C_ISR_STOPF) {
+		I2C_ICR(i2c) = I2C_ICR_STOPCF;
+		i2c_bus_finish(bus, (bus->result == I2C_TRANSACTION_PENDING) ?
+			       I2C_TRANSACTION_OK : bus->result);
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief I2C Bus Timeout Tick
+
+Counts down the timeout of the transaction in progress. When it expires the
+transaction completes with @ref I2C_TRANSACTION_TIMEOUT and the bus is reset
+with i2c_bus_recover().
+
+@param[in] bus Bus state
+*/
+void i2c_bus_tick(struct i2c_bus *bus)
+{
+	bool expired = false;
+
+	CM_ATOMIC_BLOCK() {
+		if (bus->head && bus->ticks && --bus->ticks == 0) {
+			expired = true;
+		}
+	}
+	if (expired) {
+		i2c_bus_abort(bus, I2C_TRANSACTION_TIMEOUT);
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief I2C Bus Busy
+
+@param[in] bus Bus state
+@returns true while transactions are queued or in progress
+*/
+bool i2c_bus_busy(const struct i2c_bus *bus)
+{
+	return bus->head != NULL;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief I2C Bus Wait for the Queue to Drain
+
+The I2C interrupts must be able to run.
+
+@param[in] bus Bus state
+*/
+void i2c_bus_wait(const struct i2c_bus *bus)
+{
+	while (bus->head != NULL);
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief I2C Bus Recover
+
+Resets the peripheral state machine by clearing PE, runs the recover hook
+if one is set, and enables the peripheral again. The configuration in the
+control registers is kept. Called by the library after bus errors and
+timeouts.
+
+@param[in] bus Bus state
+*/
+void i2c_bus_recover(struct i2c_bus *bus)
+{
+	uint32_t i2c = bus->i2c;
+
+	i2c_peripheral_disable(i2c);
+	/* PE must read back low before the reset is complete. */
+	while (I2C_CR1(i2c) & I2C_CR1_PE);
+	if (bus->recover) {
+		bus->recover(bus);
+	}
+	i2c_peripheral_enable(i2c);
+}
+
+/**@}*/
@@ -431,7 +431,18 @@ void i2c_clear_dma_last_transfer(uint32_t i2c)
 	I2C_CR2(i2c) &= ~I2C_CR2_LAST;
 }
 
-static void i2c_write7_v1(uint32_t i2c, int addr, const uint8_t *data, size_t n)
+/* A NACK sets AF and leaves the bus held; release it with a STOP. */
+static bool i2c_nacked_v1(uint32_t i2c)
+{
+	if (!(I2C_SR1(i2c) & I2C_SR1_AF)) {
+		return false;
+	}
+	I2C_SR1(i2c) &= ~I2C_SR1_AF;
+	i2c_send_stop(i2c);
+	return true;
+}
+
+static bool i2c_write7_v1(uint32_t i2c, int addr, const uint8_t *data, size_t n)
 {
 	while ((I2C_SR2(i2c) & I2C_SR2_BUSY)) {
 	}
@@ -446,15 +457,24 @@ static void i2c_write7_v1(uint32_t i2c, int addr, const uint8_t *data, size_t n)
 	i2c_send_7bit_address(i2c, addr, I2C_WRITE);
 
 	/* Waiting for address is transferred. */
-	while (!(I2C_SR1(i2c) & I2C_SR1_ADDR));
+	while (!(I2C_SR1(i2c) & I2C_SR1_ADDR)) {
+		if (i2c_nacked_v1(i2c)) {
+			return false;
+		}
+	}
 
 	/* Clearing ADDR condition sequence. */
 	(void)I2C_SR2(i2c);
 
 	for (size_t i = 0; i < n; i++) {
 		i2c_send_data(i2c, data[i]);
-		while (!(I2C_SR1(i2c) & (I2C_SR1_BTF)));
+		while (!(I2C_SR1(i2c) & (I2C_SR1_BTF))) {
+			if (i2c_nacked_v1(i2c)) {
+				return false;
+			}
+		}
 	}
+	return true;
 }
 
 static void i2c_read7_v1(uint32_t i2c, int addr, uint8_t *res, size_t n)
@@ -470,7 +490,11 @@ static void i2c_read7_v1(uint32_t i2c, int addr, uint8_t *res, size_t n)
 	i2c_send_7bit_address(i2c, addr, I2C_READ);
 
 	/* Waiting for address is transferred. */
-	while (!(I2C_SR1(i2c) & I2C_SR1_ADDR));
+	while (!(I2C_SR1(i2c) & I2C_SR1_ADDR)) {
+		if (i2c_nacked_v1(i2c)) {
+			return;
+		}
+	}
 	/* Clearing ADDR condition sequence. */
 	(void)I2C_SR2(i2c);
 
@@ -499,8 +523,8 @@ static void i2c_read7_v1(uint32_t i2c, int addr, uint8_t *res, size_t n)
  * @param rn number of bytes to read (r should be at least this long)
  */
 void i2c_transfer7(uint32_t i2c, uint8_t addr, const uint8_t *w, size_t wn, uint8_t *r, size_t rn) {
-	if (wn) {
-		i2c_write7_v1(i2c, addr, w, wn);
+	if (wn && !i2c_write7_v1(i2c, addr, w, wn)) {
+		return;
 	}
 	if (rn) {
 		i2c_read7_v1(i2c, addr, r, rn);
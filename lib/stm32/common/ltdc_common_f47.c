@@ -88,5 +88,222 @@ void ltdc_setup_windowing(uint8_t layer_number, uint16_t h_back_porch,
 		(v_back_porch + v_sync) << LTDC_LxWVPCR_WVSTPOS_SHIFT;
 }
 
+/* Bytes per pixel, indexed by LTDC_LxPFCR_* */
+static const uint8_t ltdc_fb_bpp[] = { 4, 3, 2, 2, 2, 1, 1, 2 };
+
+static void ltdc_fb_set_lines(const struct ltdc_fb *fb, uint16_t w,
+			      uint16_t h)
+{
+	/* The line length is programmed with 3 added. */
+	LTDC_LxCFBLR(fb->layer) = ((uint32_t)fb->pitch << LTDC_LxCFBLR_CFBP_SHIFT) |
+				  (w * fb->bpp + 3);
+	LTDC_LxCFBLNR(fb->layer) = h;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief LTDC Double Buffered Layer Setup
+
+Places a front and a back buffer of @p width x @p height pixels back to back
+at @p base, typically the start of the external SDRAM, and shows the front
+one. The layer window and pixel format must be set up already, and the
+LTDC interrupts must be enabled in the NVIC. Both LTDC vectors should call
+ltdc_fb_irq_handler().
+
+@param[out] fb Layer state
+@param[in] layer Layer number @ref ltdc_layer_num
+@param[in] base Start of the buffers, word aligned
+@param[in] width Width of the layer in pixels
+@param[in] height Height of the layer in lines
+@returns the first address after the buffers
+*/
+uint32_t ltdc_fb_init(struct ltdc_fb *fb, uint8_t layer, uint32_t base,
+		      uint16_t width, uint16_t height)
+{
+	uint32_t size;
+
+	fb->layer = layer;
+	fb->width = width;
+	fb->height = height;
+	fb->bpp = ltdc_fb_bpp[LTDC_LxPFCR(layer) & 7];
+	fb->pitch = width * fb->bpp;
+	fb->offset = 0;
+	fb->front = 0;
+	fb->pending = false;
+	fb->swaps = 0;
+	fb->underruns = 0;
+
+	size = (uint32_t)fb->pitch * height;
+	fb->buffer[0] = base;
+	fb->buffer[1] = base + size;
+
+	LTDC_LxCFBAR(layer) = fb->buffer[0];
+	ltdc_fb_set_lines(fb, width, height);
+	LTDC_SRCR = LTDC_SRCR_IMR;
+
+	LTDC_ICR = LTDC_ICR_CRRIF | LTDC_ICR_CTERRIF | LTDC_ICR_CFUIF |
+		   LTDC_ICR_CLIF;
+	LTDC_IER |= LTDC_IER_RRIE | LTDC_IER_TERRIE | LTDC_IER_FUIE;
+
+	return base + 2 * size;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief LTDC Double Buffered Layer Front Buffer
+
+@param[in] fb Layer state
+@returns the buffer being displayed
+*/
+void *ltdc_fb_front(const struct ltdc_fb *fb)
+{
+	return (void *)fb->buffer[fb->front];
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief LTDC Double Buffered Layer Back Buffer
+
+Only draw into it while no swap is pending.
+
+@param[in] fb Layer state
+@returns the buffer to render the next frame into
+*/
+void *ltdc_fb_back(const struct ltdc_fb *fb)
+{
+	return (void *)fb->buffer[fb->front ^ 1];
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief LTDC Double Buffered Layer Swap Buffers
+
+Schedules the back buffer to be shown from the next vertical blanking
+period, using the shadow register reload. The frame in progress is finished
+from the old buffer, so nothing tears.
+
+@param[in] fb Layer state
+@returns false if the previous swap has not taken effect yet
+*/
+bool ltdc_fb_swap(struct ltdc_fb *fb)
+{
+	if (fb->pending) {
+		return false;
+	}
+
+	fb->pending = true;
+	LTDC_LxCFBAR(fb->layer) = fb->buffer[fb->front ^ 1] + fb->offset;
+	LTDC_SRCR = LTDC_SRCR_VBR;
+	return true;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief LTDC Double Buffered Layer Swap Pending
+
+@param[in] fb Layer state
+@returns true from ltdc_fb_swap() until the swap has taken effect
+*/
+bool ltdc_fb_swap_pending(const struct ltdc_fb *fb)
+{
+	return fb->pending;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief LTDC Double Buffered Layer Wait for the Swap
+
+Returns once the back buffer may be drawn into again. The LTDC interrupt
+must be able to run.
+
+@param[in] fb Layer state
+*/
+void ltdc_fb_wait_swap(const struct ltdc_fb *fb)
+{
+	while (fb->pending);
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief LTDC Double Buffered Layer Line Interrupt
+
+Calls the line callback each time the given line is reached, for example to
+start rendering the next frame at a fixed point of the refresh.
+
+@param[in] fb Layer state
+@param[in] line Line number, counted from the start of the vertical sync
+*/
+void ltdc_fb_set_line_interrupt(struct ltdc_fb *fb, uint16_t line)
+{
+	(void)fb;
+	LTDC_LIPCR = line & LTDC_LIPCR_LIPOS_MASK;
+	LTDC_ICR = LTDC_ICR_CLIF;
+	LTDC_IER |= LTDC_IER_LIE;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief LTDC Double Buffered Layer Restrict Output to a Window
+
+For partial refreshes of a DSI panel in adapted command mode. The LTDC
+active area and the layer window are shrunk to the given rectangle of the
+frame buffers, and the change applied at once; send the same rectangle to the
+panel with dsi_set_update_area() and start the transfer with dsi_refresh().
+The full frame is restored with a window of the full size.
+
+The layer must cover the whole active area, and no refresh may be in
+progress.
+
+@param[in] fb Layer state
+@param[in] x Left edge of the window
+@param[in] y Top edge of the window
+@param[in] w Width of the window in pixels
+@param[in] h Height of the window in lines
+*/
+void ltdc_fb_set_window(struct ltdc_fb *fb, uint16_t x, uint16_t y,
+			uint16_t w, uint16_t h)
+{
+	uint32_t hbp = (LTDC_BPCR >> LTDC_BPCR_AHBP_SHIFT) & LTDC_BPCR_AHBP_MASK;
+	uint32_t vbp = (LTDC_BPCR >> LTDC_BPCR_AVBP_SHIFT) & LTDC_BPCR_AVBP_MASK;
+	uint32_t hfp = ((LTDC_TWCR >> LTDC_TWCR_TOTALW_SHIFT) & LTDC_TWCR_TOTALW_MASK) -
+		       ((LTDC_AWCR >> LTDC_AWCR_AAW_SHIFT) & LTDC_AWCR_AAW_MASK);
+	uint32_t vfp = ((LTDC_TWCR >> LTDC_TWCR_TOTALH_SHIFT) & LTDC_TWCR_TOTALH_MASK) -
+		       ((LTDC_AWCR >> LTDC_AWCR_AAH_SHIFT) & LTDC_AWCR_AAH_MASK);
+
+	LTDC_AWCR = ((hbp + w) << LTDC_AWCR_AAW_SHIFT) | (vbp + h);
+	LTDC_TWCR = ((hbp + w + hfp) << LTDC_TWCR_TOTALW_SHIFT) |
+		    (vbp + h + vfp);
+	LTDC_LxWHPCR(fb->layer) = ((hbp + w) << LTDC_LxWHPCR_WHSPPOS_SHIFT) |
+				  (hbp + 1);
+	LTDC_LxWVPCR(fb->layer) = ((vbp + h) << LTDC_LxWVPCR_WVSPPOS_SHIFT) |
+				  (vbp + 1);
+
+	fb->offset = (uint32_t)y * fb->pitch + (uint32_t)x * fb->bpp;
+	LTDC_LxCFBAR(fb->layer) = fb->buffer[fb->front] + fb->offset;
+	ltdc_fb_set_lines(fb, w, h);
+	LTDC_SRCR = LTDC_SRCR_IMR;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief LTDC Double Buffered Layer Interrupt Handler
+
+Call this from the LTDC and LTDC error interrupt vectors.
+
+@param[in] fb Layer state
+*/
+void ltdc_fb_irq_handler(struct ltdc_fb *fb)
+{
+	uint32_t isr = LTDC_ISR;
+
+	LTDC_ICR = isr;
+
+	if (isr & (LTDC_ISR_FUIF | LTDC_ISR_TERRIF)) {
+		fb->underruns++;
+	}
+	if ((isr & LTDC_ISR_RRIF) && fb->pending) {
+		fb->front ^= 1;
+		fb->pending = false;
+		fb->swaps++;
+		if (fb->swap_callback) {
+			fb->swap_callback(fb);
+		}
+	}
+	if ((isr & LTDC_ISR_LIF) && fb->line_callback) {
+		fb->line_callback(fb);
+	}
+}
+
 /**@}*/
 
@@ -51,6 +51,8 @@ LSB first.
  * along with this library.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+/* The library always provides the out-of-line functions */
+#undef LIBOPENCM3_INLINE_ACCESSORS
 #include <libopencm3/stm32/spi.h>
 #include <libopencm3/stm32/rcc.h>
 
@@ -131,7 +133,7 @@ Data is written to the SPI interface.
 void spi_write(uint32_t spi, uint16_t data)
 {
 	/* Write data (8 or 16 bits, depending on DFF) into DR. */
-	SPI_DR(spi) = data;
+	spi_write_inline(spi, data);
 }
 
 /*---------------------------------------------------------------------------*/
@@ -146,11 +148,8 @@ finished.
 
 void spi_send(uint32_t spi, uint16_t data)
 {
-	/* Wait for transfer finished. */
-	while (!(SPI_SR(spi) & SPI_SR_TXE));
-
-	/* Write data (8 or 16 bits, depending on DFF) into DR. */
-	SPI_DR(spi) = data;
+	/* Wait for TXE, then write data (8 or 16 bits, depending on DFF). */
+	spi_send_inline(spi, data);
 }
 
 /*---------------------------------------------------------------------------*/
@@ -164,11 +163,8 @@ Data is read from the SPI interface after the incoming transfer has finished.
 
 uint16_t spi_read(uint32_t spi)
 {
-	/* Wait for transfer finished. */
-	while (!(SPI_SR(spi) & SPI_SR_RXNE));
-
-	/* Read the data (8 or 16 bits, depending on DFF bit) from DR. */
-	return SPI_DR(spi);
+	/* Wait for RXNE, then read data (8 or 16 bits, depending on DFF). */
+	return spi_read_inline(spi);
 }
 
 /*---------------------------------------------------------------------------*/
@@ -184,13 +180,116 @@ transfer has finished.
 
 uint16_t spi_xfer(uint32_t spi, uint16_t data)
 {
-	spi_write(spi, data);
+	return spi_xfer_inline(spi, data);
+}
+
+/* Byte and halfword views of the data register. A halfword access packs two
+ * frames of up to 8 bits on cores with a data FIFO. */
+#define SPI_DR_BYTE(spi)		MMIO8((spi) + 0x0c)
+#define SPI_DR_HALF(spi)		MMIO16((spi) + 0x0c)
+
+static bool spi_frames_16bit(uint32_t spi)
+{
+#if defined(SPI_CR2_DS_MASK)
+	return (SPI_CR2(spi) & SPI_CR2_DS_MASK) > SPI_CR2_DS_8BIT;
+#else
+	return SPI_CR1(spi) & SPI_CR1_DFF;
+#endif
+}
+
+/* Exchange n data register accesses of stride bytes each, keeping up to
+ * depth of them in flight so the bus never idles between frames. */
+static void spi_transfer_loop(uint32_t spi, const uint8_t *tx, uint8_t *rx,
+			      uint16_t n, uint8_t stride, bool byte_access,
+			      uint8_t depth)
+{
+	uint16_t sent = 0;
+	uint16_t received = 0;
+	uint16_t v;
+
+	while (received < n) {
+		if (sent < n && (uint16_t)(sent - received) < depth &&
+		    (SPI_SR(spi) & SPI_SR_TXE)) {
+			v = 0xffff;
+			if (tx) {
+				v = tx[0];
+				if (stride == 2) {
+					v |= tx[1] << 8;
+				}
+				tx += stride;
+			}
+			if (byte_access) {
+				SPI_DR_BYTE(spi) = v;
+			} else {
+				SPI_DR_HALF(spi) = v;
+			}
+			sent++;
+		}
+		if (SPI_SR(spi) & SPI_SR_RXNE) {
+			v = byte_access ? SPI_DR_BYTE(spi) : SPI_DR_HALF(spi);
+			if (rx) {
+				rx[0] = v;
+				if (stride == 2) {
+					rx[1] = v >> 8;
+				}
+				rx += stride;
+			}
+			received++;
+		}
+	}
+}
 
-	/* Wait for transfer finished. */
-	while (!(SPI_SR(spi) & SPI_SR_RXNE));
+/*---------------------------------------------------------------------------*/
+/** @brief SPI Buffer Exchange.
+
+Exchange @p len frames with the SPI interface, which must be enabled in full
+duplex master mode. 16 bit frames are stored in host byte order.
+
+On cores with a data FIFO transmission is kept ahead of reception so that
+frames follow each other back to back, and 8 bit frames are moved in pairs
+with halfword accesses to the data register.
 
-	/* Read the data (8 or 16 bits, depending on DFF bit) from DR. */
-	return SPI_DR(spi);
+@param[in] spi Unsigned int32. SPI peripheral identifier @ref spi_reg_base.
+@param[in] tx Frames to send, or NULL to send all ones.
+@param[out] rx Buffer for received frames, or NULL to discard them.
+@param[in] len Unsigned int16. Number of frames.
+*/
+
+void spi_transfer(uint32_t spi, const void *tx, void *rx, uint16_t len)
+{
+	const uint8_t *txb = tx;
+	uint8_t *rxb = rx;
+
+#if defined(SPI_CR2_FRXTH)
+	uint32_t cr2 = SPI_CR2(spi);
+
+	if (spi_frames_16bit(spi)) {
+		spi_transfer_loop(spi, txb, rxb, len, 2, false, 2);
+		return;
+	}
+
+	/* Pairs of 8 bit frames: RXNE at 16 bits, two pairs fill the FIFO. */
+	if (len >= 2) {
+		SPI_CR2(spi) = cr2 & ~SPI_CR2_FRXTH;
+		spi_transfer_loop(spi, txb, rxb, len / 2, 2, false, 2);
+		if (txb) {
+			txb += len & ~1;
+		}
+		if (rxb) {
+			rxb += len & ~1;
+		}
+	}
+	if (len & 1) {
+		SPI_CR2(spi) = cr2 | SPI_CR2_FRXTH;
+		spi_transfer_loop(spi, txb, rxb, 1, 1, true, 1);
+	}
+	SPI_CR2(spi) = cr2;
+#else
+	/* Single data register, only one frame may be in flight without
+	 * risking an overrun. */
+	spi_transfer_loop(spi, txb, rxb, len, spi_frames_16bit(spi) ? 2 : 1,
+			  false, 1);
+#endif
 }
 
 /*---------------------------------------------------------------------------*/
@@ -0,0 +1,272 @@
+/** @defgroup spi_dma_file SPI DMA transactions
+@ingroup peripheral_apis
+
+@brief DMA driven transaction queue for the STM32 SPI peripherals.
+
+The SPI must be configured and enabled as a full duplex master, and the
+vectors of both DMA streams/channels must call dma_xfer_irq_handler().
+
+On cores with a data FIFO, 8 bit transactions of an even number of frames
+with halfword aligned buffers are moved as halfwords, halving the number of
+DMA bus accesses.
+
+LGPL License Terms @ref lgpl_license
+*/
+/*
+ * This file is part of the libopencm3 project.
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**@{*/
+
+#include <stddef.h>
+#include <libopencm3/cm3/cortex.h>
+#include <libopencm3/stm32/gpio.h>
+#include <libopencm3/stm32/spi_dma.h>
+
+/*
+ * BSY falls at most one SPI clock, 256 PCLK cycles, after the last frame has
+ * been received, and each read of SPI_SR takes at least one PCLK cycle.
+ */
+#define SPI_DMA_BSY_SPINS	1024
+
+/* Selects the chip and starts the DMA, false if there are no frames */
+static bool spi_dma_start(struct spi_dma *bus, struct spi_transaction *t)
+{
+	uint32_t spi = bus->spi;
+	uint8_t width = DMA_XFER_WIDTH_8BIT;
+	uint16_t count = t->len;
+
+	t->error = false;
+	if (t->cs_port) {
+		gpio_clear(t->cs_port, t->cs_gpio);
+	}
+	if (count == 0) {
+		return false;
+	}
+
+#if defined(SPI_CR2_DS_MASK)
+	if ((SPI_CR2(spi) & SPI_CR2_DS_MASK) > SPI_CR2_DS_8BIT) {
+		width = DMA_XFER_WIDTH_16BIT;
+		SPI_CR2(spi) &= ~SPI_CR2_FRXTH;
+	} else if (!(count & 1) &&
+		   !(((uint32_t)t->tx | (uint32_t)t->rx) & 1)) {
+		/* Pack pairs of frames, RXNE is raised at 16 bits. */
+		width = DMA_XFER_WIDTH_16BIT;
+		count /= 2;
+		SPI_CR2(spi) &= ~SPI_CR2_FRXTH;
+	} else {
+		SPI_CR2(spi) |= SPI_CR2_FRXTH;
+	}
+#else
+	if (SPI_CR1(spi) & SPI_CR1_DFF) {
+		width = DMA_XFER_WIDTH_16BIT;
+	}
+#endif
+
+	bus->rx_xfer.dst = t->rx ? (uint32_t)t->rx : (uint32_t)&bus->discard_rx;
+	bus->rx_xfer.flags = t->rx ? DMA_XFER_DST_INC : 0;
+	bus->rx_xfer.src_width = bus->rx_xfer.dst_width = width;
+	bus->rx_xfer.count = count;
+
+	bus->tx_xfer.src = t->tx ? (uint32_t)t->tx : (uint32_t)&bus->dummy_tx;
+	bus->tx_xfer.flags = t->tx ? DMA_XFER_SRC_INC : 0;
+	bus->tx_xfer.src_width = bus->tx_xfer.dst_width = width;
+	bus->tx_xfer.count = count;
+
+	/* Receive side first so that no frame can be missed. */
+	SPI_CR2(spi) |= SPI_CR2_RXDMAEN;
+	dma_xfer_submit(&bus->rx_xfer);
+	dma_xfer_submit(&bus->tx_xfer);
+	SPI_CR2(spi) |= SPI_CR2_TXDMAEN;
+
+	return true;
+}
+
+/*
+ * Ends t, at the head of the queue. The next transaction is started before
+ * the callback runs, so one the callback queues is not started twice, and
+ * those without frames are ended in turn.
+ */
+static void spi_dma_end(struct spi_dma *bus, struct spi_transaction *t)
+{
+	struct spi_transaction *next;
+	bool started = false;
+
+	do {
+		if (t->cs_port && !t->cs_hold) {
+			gpio_set(t->cs_port, t->cs_gpio);
+		}
+
+		CM_ATOMIC_BLOCK() {
+			next = t->next;
+			bus->head = next;
+			if (next == NULL) {
+				bus->tail = NULL;
+			}
+			started = next == NULL || spi_dma_start(bus, next);
+		}
+
+		if (t->callback) {
+			t->callback(t);
+		}
+		t = next;
+	} while (!started);
+}
+
+static void spi_dma_rx_event(struct dma_xfer *xfer, uint32_t events)
+{
+	struct spi_dma *bus = xfer->user;
+	struct spi_transaction *t = bus->head;
+	uint32_t spi = bus->spi;
+	uint32_t spins = SPI_DMA_BSY_SPINS;
+
+	if (t == NULL ||
+	    !(events & (DMA_XFER_EVT_COMPLETE | DMA_XFER_EVT_ERROR))) {
+		return;
+	}
+
+	if (events & DMA_XFER_EVT_ERROR) {
+		t->error = true;
+		dma_xfer_abort(&bus->tx_xfer);
+	}
+
+	/* The last frame has been received, let the clock finish. */
+	while (SPI_SR(spi) & SPI_SR_BSY) {
+		if (--spins == 0) {
+			t->error = true;
+			break;
+		}
+	}
+	SPI_CR2(spi) &= ~(SPI_CR2_TXDMAEN | SPI_CR2_RXDMAEN);
+
+	spi_dma_end(bus, t);
+}
+
+static void spi_dma_tx_event(struct dma_xfer *xfer, uint32_t events)
+{
+	struct spi_dma *bus = xfer->user;
+
+	/* Completion is taken from the receive side, which finishes last. */
+	if (events & DMA_XFER_EVT_ERROR) {
+		dma_xfer_abort(&bus->rx_xfer);
+		spi_dma_rx_event(&bus->rx_xfer, DMA_XFER_EVT_ERROR);
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief SPI DMA Initialise a Bus
+
+@param[in] bus Bus state
+@param[in] spi SPI peripheral identifier @ref spi_reg_base
+@param[in] dma DMA controller base address: DMA1 or DMA2
+@param[in] rx_channel DMA stream or channel connected to the SPI RX request
+@param[in] rx_request Request routing of the RX side, see struct dma_xfer
+@param[in] tx_channel DMA stream or channel connected to the SPI TX request
+@param[in] tx_request Request routing of the TX side, see struct dma_xfer
+@returns false if one of the DMA streams or channels is in use
+*/
+bool spi_dma_init(struct spi_dma *bus, uint32_t spi, uint32_t dma,
+		  uint8_t rx_channel, uint8_t rx_request,
+		  uint8_t tx_channel, uint8_t tx_request)
+{
+	bus->spi = spi;
+	bus->head = NULL;
+	bus->tail = NULL;
+	bus->dummy_tx = 0xffff;
+
+	bus->rx_xfer.src = (uint32_t)&SPI_DR(spi);
+	bus->rx_xfer.direction = DMA_XFER_PERIPH_TO_MEM;
+	bus->rx_xfer.priority = 3;
+	bus->rx_xfer.request = rx_request;
+	bus->rx_xfer.callback = spi_dma_rx_event;
+	bus->rx_xfer.user = bus;
+
+	bus->tx_xfer.dst = (uint32_t)&SPI_DR(spi);
+	bus->tx_xfer.direction = DMA_XFER_MEM_TO_PERIPH;
+	bus->tx_xfer.priority = 2;
+	bus->tx_xfer.request = tx_request;
+	bus->tx_xfer.callback = spi_dma_tx_event;
+	bus->tx_xfer.user = bus;
+
+	if (!dma_xfer_claim(&bus->rx_xfer, dma, rx_channel)) {
+		return false;
+	}
+	if (!dma_xfer_claim(&bus->tx_xfer, dma, tx_channel)) {
+		dma_xfer_release(&bus->rx_xfer);
+		return false;
+	}
+	return true;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief SPI DMA Queue a Transaction
+
+The transaction starts straight away if the bus is idle, otherwise after the
+ones queued before it. It must stay valid until its callback has run.
+
+A transaction without frames only selects the chip, and deselects it unless
+held. On an idle bus it ends before the function returns, which then calls
+its callback.
+
+@param[in] bus Bus state
+@param[in] t Transaction
+*/
+void spi_transfer_async(struct spi_dma *bus, struct spi_transaction *t)
+{
+	bool started = true;
+
+	t->next = NULL;
+
+	CM_ATOMIC_BLOCK() {
+		if (bus->head == NULL) {
+			bus->head = t;
+			bus->tail = t;
+			started = spi_dma_start(bus, t);
+		} else {
+			bus->tail->next = t;
+			bus->tail = t;
+		}
+	}
+
+	if (!started) {
+		spi_dma_end(bus, t);
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief SPI DMA Bus Busy
+
+@param[in] bus Bus state
+@returns true while transactions are queued or in progress
+*/
+bool spi_dma_busy(const struct spi_dma *bus)
+{
+	return bus->head != NULL;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief SPI DMA Wait for the Queue to Drain
+
+The DMA interrupts must be able to run.
+
+@param[in] bus Bus state
+*/
+void spi_dma_wait(const struct spi_dma *bus)
+{
+	while (bus->head != NULL);
+}
+
+/**@}*/
@@ -0,0 +1,515 @@
+/** @defgroup usart_dma_file USART DMA streaming
+@ingroup peripheral_apis
+
+@brief DMA driven receive ring and transmit queue for the STM32 USARTs.
+
+The receiver is left running in circular mode. The consumer asks for the
+next contiguous span with usart_rx_dma_peek(), processes it in place and
+hands it back with usart_rx_dma_consume().
+
+The transmit queue copies writes into a ring and returns immediately. The
+ring is drained by the transmit interrupt, or by DMA in contiguous chunks
+after usart_txq_enable_dma().
+
+Interrupts needed:
+- the DMA stream/channel vectors must call dma_xfer_irq_handler(),
+- the USART vector must call usart_rx_dma_irq_handler() and/or
+  usart_txq_irq_handler().
+
+On parts with USART FIFOs the FIFOs are enabled: the receive FIFO lets the
+DMA fall behind by a few characters under bus contention without an overrun,
+and the transmit queue refills the FIFO from its threshold interrupt.
+
+LGPL License Terms @ref lgpl_license
+*/
+/*
+ * This file is part of the libopencm3 project.
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**@{*/
+
+#include <libopencm3/stm32/usart_dma.h>
+
+#include <libopencm3/cm3/cortex.h>
+
+#if defined(USART_RDR)
+#define USART_DMA_RX_REG(usart)		((uint32_t)&USART_RDR(usart))
+#define USART_DMA_TX_DATA(usart)	USART_TDR(usart)
+#define USART_DMA_STATUS(usart)		USART_ISR(usart)
+#define USART_DMA_STATUS_TXE		USART_ISR_TXE
+#define USART_DMA_STATUS_TC		USART_ISR_TC
+#else
+#define USART_DMA_RX_REG(usart)		((uint32_t)&USART_DR(usart))
+#define USART_DMA_TX_DATA(usart)	USART_DR(usart)
+#define USART_DMA_STATUS(usart)		USART_SR(usart)
+#define USART_DMA_STATUS_TXE		USART_SR_TXE
+#define USART_DMA_STATUS_TC		USART_SR_TC
+#endif
+
+#if defined(USART_CR1_FIFOEN)
+static void usart_dma_enable_fifos(uint32_t usart)
+{
+	uint32_t cr1 = USART_CR1(usart);
+
+	/* FIFOEN can only be changed while the USART is disabled. */
+	if (!(cr1 & USART_CR1_FIFOEN)) {
+		USART_CR1(usart) = cr1 & ~USART_CR1_UE;
+		USART_CR1(usart) = (cr1 & ~USART_CR1_UE) | USART_CR1_FIFOEN;
+		USART_CR1(usart) = cr1 | USART_CR1_FIFOEN;
+	}
+}
+#endif
+
+static bool usart_dma_idle_pending(uint32_t usart)
+{
+#if defined(USART_ICR)
+	if (USART_ISR(usart) & USART_ISR_IDLE) {
+		USART_ICR(usart) = USART_ICR_IDLECF;
+		return true;
+	}
+#else
+	/* IDLE is cleared by a read of SR followed by a read of DR. */
+	if (USART_SR(usart) & USART_SR_IDLE) {
+		(void)USART_DR(usart);
+		return true;
+	}
+#endif
+	return false;
+}
+
+static void usart_rx_dma_update(struct usart_rx_dma *rx)
+{
+	uint16_t head = rx->size - dma_xfer_remaining(&rx->xfer);
+	uint16_t used, added;
+
+	if (head >= rx->size) {
+		head = 0;
+	}
+	if (head == rx->head) {
+		return;
+	}
+
+	used = (rx->head + rx->size - rx->tail) % rx->size;
+	added = (head + rx->size - rx->head) % rx->size;
+	if (used + added >= rx->size) {
+		/* The oldest data has been overwritten, keep the newest. */
+		rx->overruns++;
+		rx->tail = (head + 1) % rx->size;
+	}
+
+	rx->head = head;
+	if (rx->callback) {
+		rx->callback(rx);
+	}
+}
+
+static void usart_rx_dma_event(struct dma_xfer *xfer, uint32_t events)
+{
+	struct usart_rx_dma *rx = xfer->user;
+
+	(void)events;
+	usart_rx_dma_update(rx);
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief USART DMA Receive Start
+
+The USART must be configured already. The DMA stream or channel is claimed,
+the ring is started in circular mode and the idle line interrupt is enabled;
+the corresponding interrupts must be enabled in the NVIC by the caller.
+
+@param[in] rx Receive ring state
+@param[in] usart USART block register address base @ref usart_reg_base
+@param[in] dma DMA controller base address: DMA1 or DMA2
+@param[in] channel DMA stream or channel connected to the USART RX request
+@param[in] request Request routing, see struct dma_xfer
+@param[in] buf Ring storage
+@param[in] size Ring size in bytes
+@returns false if the DMA stream or channel is in use
+*/
+bool usart_rx_dma_start(struct usart_rx_dma *rx, uint32_t usart,
+			uint32_t dma, uint8_t channel, uint8_t request,
+			uint8_t *buf, uint16_t size)
+{
+	struct dma_xfer *xfer = &rx->xfer;
+
+	rx->usart = usart;
+	rx->buf = buf;
+	rx->size = size;
+	rx->head = 0;
+	rx->tail = 0;
+	rx->overruns = 0;
+
+	xfer->src = USART_DMA_RX_REG(usart);
+	xfer->dst = (uint32_t)buf;
+	xfer->count = size;
+	xfer->direction = DMA_XFER_PERIPH_TO_MEM;
+	xfer->src_width = DMA_XFER_WIDTH_8BIT;
+	xfer->dst_width = DMA_XFER_WIDTH_8BIT;
+	xfer->priority = 2;
+	xfer->flags = DMA_XFER_DST_INC | DMA_XFER_CIRCULAR | DMA_XFER_HALF_IRQ;
+	xfer->request = request;
+	xfer->callback = usart_rx_dma_event;
+	xfer->user = rx;
+
+	if (!dma_xfer_claim(xfer, dma, channel)) {
+		return false;
+	}
+
+#if defined(USART_CR1_FIFOEN)
+	usart_dma_enable_fifos(usart);
+#endif
+
+	usart_dma_idle_pending(usart);
+	dma_xfer_submit(xfer);
+	usart_enable_rx_dma(usart);
+	usart_enable_idle_interrupt(usart);
+	return true;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief USART DMA Receive Stop
+
+@param[in] rx Receive ring state
+*/
+void usart_rx_dma_stop(struct usart_rx_dma *rx)
+{
+	usart_disable_idle_interrupt(rx->usart);
+	usart_disable_rx_dma(rx->usart);
+	dma_xfer_release(&rx->xfer);
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief USART DMA Receive Interrupt Handler
+
+Call this from the USART interrupt vector. It publishes data received since
+the last half or full transfer event when the line goes idle.
+
+@param[in] rx Receive ring state
+*/
+void usart_rx_dma_irq_handler(struct usart_rx_dma *rx)
+{
+	if (usart_dma_idle_pending(rx->usart)) {
+		usart_rx_dma_update(rx);
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief USART DMA Receive Poll
+
+Publish whatever the DMA has written so far, without waiting for an
+interrupt. Must not race with the interrupt handlers, call it with them
+masked or from the same priority.
+
+@param[in] rx Receive ring state
+*/
+void usart_rx_dma_poll(struct usart_rx_dma *rx)
+{
+	usart_rx_dma_update(rx);
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief USART DMA Receive Available Bytes
+
+@param[in] rx Receive ring state
+@returns number of published bytes not yet consumed
+*/
+uint16_t usart_rx_dma_available(const struct usart_rx_dma *rx)
+{
+	return (rx->head + rx->size - rx->tail) % rx->size;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief USART DMA Receive Peek at the next Contiguous Span
+
+The span ends at the write index or at the end of the ring, whichever comes
+first; after consuming it a second call returns the wrapped part.
+
+@param[in] rx Receive ring state
+@param[out] data Start of the span in the ring
+@returns length of the span in bytes, 0 if the ring is empty
+*/
+uint16_t usart_rx_dma_peek(const struct usart_rx_dma *rx,
+			   const uint8_t **data)
+{
+	uint16_t head = rx->head;
+	uint16_t tail = rx->tail;
+
+	*data = &rx->buf[tail];
+	if (head >= tail) {
+		return head - tail;
+	}
+	return rx->size - tail;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief USART DMA Receive Consume Bytes
+
+@param[in] rx Receive ring state
+@param[in] len Number of bytes handed back, at most usart_rx_dma_available()
+*/
+void usart_rx_dma_consume(struct usart_rx_dma *rx, uint16_t len)
+{
+	rx->tail = (rx->tail + len) % rx->size;
+}
+
+static void usart_txq_clear_tc(uint32_t usart)
+{
+#if defined(USART_ICR)
+	USART_ICR(usart) = USART_ICR_TCCF;
+#else
+	USART_SR(usart) = ~USART_SR_TC;
+#endif
+}
+
+static void usart_txq_enable_tx_irq(uint32_t usart)
+{
+#if defined(USART_CR1_FIFOEN)
+	usart_enable_tx_fifo_threshold_interrupt(usart);
+#else
+	usart_enable_tx_interrupt(usart);
+#endif
+}
+
+static void usart_txq_disable_tx_irq(uint32_t usart)
+{
+#if defined(USART_CR1_FIFOEN)
+	usart_disable_tx_fifo_threshold_interrupt(usart);
+#else
+	usart_disable_tx_interrupt(usart);
+#endif
+}
+
+/* Move bytes into the transmit data register (or FIFO) while it has room. */
+static void usart_txq_fill(struct usart_txq *q)
+{
+	while (txq_used(&q->ring) &&
+	       (USART_DMA_STATUS(q->usart) & USART_DMA_STATUS_TXE)) {
+		USART_DMA_TX_DATA(q->usart) = txq_get(&q->ring);
+	}
+}
+
+/* Queue is empty: wait for the last character to leave the shifter. */
+static void usart_txq_drain(struct usart_txq *q)
+{
+	USART_CR1(q->usart) |= USART_CR1_TCIE;
+}
+
+/* Start draining the ring, q->active must already be set. */
+static void usart_txq_start(struct usart_txq *q)
+{
+	const uint8_t *data;
+
+	if (q->use_dma) {
+		q->dma_len = txq_span(&q->ring, &data);
+		q->xfer.src = (uint32_t)data;
+		q->xfer.count = q->dma_len;
+		usart_txq_clear_tc(q->usart);
+		dma_xfer_submit(&q->xfer);
+		return;
+	}
+
+	usart_txq_fill(q);
+	if (txq_used(&q->ring)) {
+		usart_txq_enable_tx_irq(q->usart);
+	} else {
+		usart_txq_drain(q);
+	}
+}
+
+static void usart_txq_dma_event(struct dma_xfer *xfer, uint32_t events)
+{
+	struct usart_txq *q = xfer->user;
+
+	if (!(events & (DMA_XFER_EVT_COMPLETE | DMA_XFER_EVT_ERROR))) {
+		return;
+	}
+
+	/* On error the chunk is dropped, there is no way to tell how much of
+	 * it went out. */
+	txq_advance(&q->ring, q->dma_len);
+	q->dma_len = 0;
+	if (txq_used(&q->ring)) {
+		usart_txq_start(q);
+	} else {
+		usart_txq_drain(q);
+	}
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief USART Transmit Queue Initialise
+
+The USART must be configured already. The queue drains through the transmit
+interrupt until usart_txq_enable_dma() is called; the USART interrupt must be
+enabled in the NVIC by the caller.
+
+@param[in] q Transmit queue state
+@param[in] usart USART block register address base @ref usart_reg_base
+@param[in] buf Ring storage
+@param[in] size Ring size in bytes, one byte is kept free
+*/
+void usart_txq_init(struct usart_txq *q, uint32_t usart,
+		    uint8_t *buf, uint16_t size)
+{
+	q->usart = usart;
+	txq_init(&q->ring, buf, size);
+	q->active = false;
+	q->use_dma = false;
+	q->dma_len = 0;
+
+#if defined(USART_CR1_FIFOEN)
+	usart_dma_enable_fifos(usart);
+	usart_set_tx_fifo_threshold(usart, USART_FIFO_THRESH_HALF);
+#endif
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief USART Transmit Queue Drain by DMA
+
+Each contiguous run of queued bytes is handed to the DMA in one transfer.
+Must be called while the queue is idle.
+
+@param[in] q Transmit queue state
+@param[in] dma DMA controller base address: DMA1 or DMA2
+@param[in] channel DMA stream or channel connected to the USART TX request
+@param[in] request Request routing, see struct dma_xfer
+@returns false if the DMA stream or channel is in use
+*/
+bool usart_txq_enable_dma(struct usart_txq *q, uint32_t dma,
+			  uint8_t channel, uint8_t request)
+{
+	struct dma_xfer *xfer = &q->xfer;
+
+	xfer->dst = (uint32_t)&USART_DMA_TX_DATA(q->usart);
+	xfer->direction = DMA_XFER_MEM_TO_PERIPH;
+	xfer->src_width = DMA_XFER_WIDTH_8BIT;
+	xfer->dst_width = DMA_XFER_WIDTH_8BIT;
+	xfer->priority = 1;
+	xfer->flags = DMA_XFER_SRC_INC;
+	xfer->request = request;
+	xfer->callback = usart_txq_dma_event;
+	xfer->user = q;
+
+	if (!dma_xfer_claim(xfer, dma, channel)) {
+		return false;
+	}
+
+	usart_enable_tx_dma(q->usart);
+	q->use_dma = true;
+	return true;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief USART Transmit Queue Write
+
+Copy as much of @p data as fits into the queue and start the transmitter if
+it is idle. Never blocks.
+
+@param[in] q Transmit queue state
+@param[in] data Bytes to send
+@param[in] len Number of bytes
+@returns number of bytes queued
+*/
+uint16_t usart_txq_write(struct usart_txq *q, const void *data,
+			 uint16_t len)
+{
+	uint16_t n = txq_put(&q->ring, data, len);
+
+	CM_ATOMIC_BLOCK() {
+		if (!q->active && txq_used(&q->ring)) {
+			q->active = true;
+			usart_txq_start(q);
+		}
+	}
+	return n;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief USART Transmit Queue Free Space
+
+@param[in] q Transmit queue state
+@returns number of bytes usart_txq_write() will accept
+*/
+uint16_t usart_txq_space(const struct usart_txq *q)
+{
+	return txq_space(&q->ring);
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief USART Transmit Queue Busy
+
+@param[in] q Transmit queue state
+@returns true until the queue is empty and the last character has been sent
+*/
+bool usart_txq_busy(const struct usart_txq *q)
+{
+	return q->active;
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief USART Transmit Queue Flush
+
+Wait until everything queued so far has left the transmitter. The
+interrupts draining the queue must be able to run.
+
+@param[in] q Transmit queue state
+*/
+void usart_txq_flush(struct usart_txq *q)
+{
+	while (q->active);
+}
+
+/*---------------------------------------------------------------------------*/
+/** @brief USART Transmit Queue Interrupt Handler
+
+Call this from the USART interrupt vector.
+
+@param[in] q Transmit queue state
+*/
+void usart_txq_irq_handler(struct usart_txq *q)
+{
+	uint32_t usart = q->usart;
+	uint32_t status = USART_DMA_STATUS(usart);
+
+#if defined(USART_CR1_FIFOEN)
+	if (USART_CR3(usart) & USART_CR3_TXFTIE) {
+#else
+	if (USART_CR1(usart) & USART_CR1_TXEIE) {
+#endif
+		usart_txq_fill(q);
+		if (!txq_used(&q->ring)) {
+			usart_txq_disable_tx_irq(usart);
+			usart_txq_drain(q);
+		}
+		return;
+	}
+
+	if ((USART_CR1(usart) & USART_CR1_TCIE) &&
+	    (status & USART_DMA_STATUS_TC)) {
+		USART_CR1(usart) &= ~USART_CR1_TCIE;
+		if (txq_used(&q->ring)) {
+			/* Written while the last character was going out. */
+			usart_txq_start(q);
+			return;
+		}
+		q->active = false;
+		if (q->callback) {
+			q->callback(q);
+		}
+	}
+}
+
+/**@}*/
@@ -81,6 +81,42 @@ unsigned fdcan_get_txbuf_element_size(uint32_t canport)
 	return sizeof(struct fdcan_tx_buffer_element);
 }
 
+/** Returns number of elements in receive FIFO for given CAN port.
+ *
+ * For G4 it returns constant value as G4 has three elements per receive FIFO.
+ * G4 does not implement the FIFO watermark, so batched draining is triggered
+ * by the new message or FIFO full interrupts.
+ *
+ * @param [in] canport FDCAN block base address. See @ref fdcan_block. Unused.
+ * @param [in] fifo_id ID of FIFO whose size is queried. Unused.
+ * @returns Number of elements in the FIFO.
+ */
+unsigned fdcan_get_fifo_size(uint32_t canport, unsigned fifo_id)
+{
+	/* Silences compiler. Variables are present for API compatibility
+	 * with STM32H7
+	 */
+	(void) (canport);
+	(void) (fifo_id);
+	return 3;
+}
+
+/** Returns number of transmit buffers in transmit queue/FIFO for given CAN port.
+ *
+ * For G4 it returns constant value as G4 has three transmit buffers.
+ *
+ * @param [in] canport FDCAN block base address. See @ref fdcan_block. Unused.
+ * @returns Number of transmit buffers.
+ */
+unsigned fdcan_get_txbuf_count(uint32_t canport)
+{
+	/* Silences compiler. Variables are present for API compatibility
+	 * with STM32H7
+	 */
+	(void) (canport);
+	return 3;
+}
+
 /** Configure amount of filters and initialize filtering block.
  *
  * This function allows to configure global amount of filters present.
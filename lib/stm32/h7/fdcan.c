@@ -98,6 +98,27 @@ unsigned fdcan_get_txbuf_element_size(uint32_t canport)
 	return 8 + fdcan_dlc_to_length((element_size & FDCAN_TXESC_TBDS_MASK) | 0x8);
 }
 
+/** Returns number of elements in receive FIFO for given CAN port.
+ *
+ * @param [in] canport FDCAN block base address. See @ref fdcan_block.
+ * @param [in] fifo_id ID of FIFO whose size is queried.
+ * @returns Number of elements allocated to the FIFO in message RAM.
+ */
+unsigned fdcan_get_fifo_size(uint32_t canport, unsigned fifo_id)
+{
+	return (FDCAN_RXFIC(canport, fifo_id) >> FDCAN_RXFIC_FIS_SHIFT) & FDCAN_RXFIC_FIS_MASK;
+}
+
+/** Returns number of transmit buffers in transmit queue/FIFO for given CAN port.
+ *
+ * @param [in] canport FDCAN block base address. See @ref fdcan_block.
+ * @returns Number of transmit buffers allocated in message RAM.
+ */
+unsigned fdcan_get_txbuf_count(uint32_t canport)
+{
+	return (FDCAN_TXBC(canport) >> FDCAN_TXBC_TFQS_SHIFT) & FDCAN_TXBC_TFQS_MASK;
+}
+
 /** Initialize allocation of standard filter block in CAN message RAM.
  *
  * Allows specifying size of standard filtering block (in term of available filtering
@@ -151,6 +172,22 @@ void fdcan_init_fifo_ram(uint32_t canport, unsigned fifo_id, uint32_t fxsa, uint
 		| (fxsa & (FDCAN_RXFIC_FISA_MASK << FDCAN_RXFIC_FISA_SHIFT));
 }
 
+/** Set receive FIFO watermark.
+ *
+ * Once the fill level of the FIFO reaches the watermark, the FIFO watermark
+ * interrupt flag is raised. Together with @ref fdcan_receive_batch this allows
+ * to take one interrupt per several received frames instead of one per frame.
+ * @param [in] canport FDCAN block base address. See @ref fdcan_block.
+ * @param [in] fifo_id ID of fifo being configured
+ * @param [in] level fill level triggering the interrupt, 0 disables the watermark
+ */
+void fdcan_set_rx_watermark(uint32_t canport, unsigned fifo_id, uint8_t level)
+{
+	FDCAN_RXFIC(canport, fifo_id) = (FDCAN_RXFIC(canport, fifo_id)
+		& ~(FDCAN_RXFIC_FIWM_MASK << FDCAN_RXFIC_FIWM_SHIFT))
+		| ((level & FDCAN_RXFIC_FIWM_MASK) << FDCAN_RXFIC_FIWM_SHIFT);
+}
+
 /** Initialize allocation of transmit event block in CAN message RAM.
  *
  * Allows specifying size of transmit event block (in term of allocated events and block
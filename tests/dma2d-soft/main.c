@@ -0,0 +1,285 @@
+/*
+ * This file is part of the libopencm3 project.
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define _GNU_SOURCE
+
+#include <libopencm3/stm32/dma2d.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+static int failures;
+
+#define CHECK(cond) \
+	do { \
+		if (!(cond)) { \
+			printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+			failures++; \
+		} \
+	} while (0)
+
+/* The library keeps pixel addresses in 32 bits */
+static void *alloc(size_t size)
+{
+	static uint8_t *arena;
+	static size_t used;
+	const size_t arena_size = 1 << 20;
+	int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+	void *p;
+
+	if (!arena) {
+#ifdef MAP_32BIT
+		flags |= MAP_32BIT;
+#endif
+		arena = mmap((void *)0x20000000, arena_size,
+			     PROT_READ | PROT_WRITE, flags, -1, 0);
+		if (arena == MAP_FAILED ||
+		    (uintptr_t)arena + arena_size > UINT32_MAX) {
+			fprintf(stderr, "no memory below 4G\n");
+			exit(2);
+		}
+	}
+
+	size = (size + 3) & ~(size_t)3;
+	if (used + size > arena_size) {
+		fprintf(stderr, "out of memory\n");
+		exit(2);
+	}
+	p = arena + used;
+	used += size;
+	memset(p, 0, size);
+
+	return p;
+}
+
+static void run(struct dma2d_op *op)
+{
+	op->callback = NULL;
+	dma2d_submit(op);
+	CHECK(!dma2d_busy());
+	CHECK(!op->error);
+}
+
+static void test_fill(void)
+{
+	struct dma2d_surface dst = { alloc(8 * 4 * 2), 8,
+				     DMA2D_OPFCCR_CM_RGB565 };
+	uint16_t *px = dst.pixels;
+	struct dma2d_op op;
+	int x, y;
+
+	dma2d_op_fill(&op, &dst, 2, 1, 3, 2, 0xff00ff00);
+	run(&op);
+
+	for (y = 0; y < 4; y++) {
+		for (x = 0; x < 8; x++) {
+			bool in = x >= 2 && x < 5 && y >= 1 && y < 3;
+
+			CHECK(px[y * 8 + x] == (in ? 0x07e0 : 0));
+		}
+	}
+}
+
+static void test_copy_convert(void)
+{
+	struct dma2d_surface src = { alloc(4 * 2 * 4), 4,
+				     DMA2D_xPFCCR_CM_ARGB8888 };
+	struct dma2d_surface dst = { alloc(6 * 2 * 2), 6,
+				     DMA2D_OPFCCR_CM_RGB565 };
+	struct dma2d_surface out = { alloc(4 * 2 * 4), 4,
+				     DMA2D_OPFCCR_CM_ARGB8888 };
+	uint32_t *s = src.pixels;
+	uint16_t *d = dst.pixels;
+	uint32_t *o = out.pixels;
+	struct dma2d_op op;
+	int i;
+
+	for (i = 0; i < 8; i++) {
+		s[i] = 0xff000000 | (i * 0x203040);
+	}
+
+	/* Conversion, then straight copy of the same format */
+	dma2d_op_copy(&op, &src, 1, 0, &dst, 0, 0, 3, 2);
+	run(&op);
+	dma2d_op_copy(&op, &src, 0, 0, &out, 0, 0, 4, 2);
+	run(&op);
+
+	for (i = 0; i < 3; i++) {
+		CHECK(d[i] == dma2d_color(DMA2D_OPFCCR_CM_RGB565, s[1 + i]));
+		CHECK(d[6 + i] == dma2d_color(DMA2D_OPFCCR_CM_RGB565,
+					      s[5 + i]));
+	}
+	CHECK(d[3] == 0 && d[9] == 0);
+	CHECK(!memcmp(o, s, 4 * 2 * 4));
+
+	/* RGB565 back to ARGB8888 repeats the top bits */
+	dma2d_op_copy(&op, &(struct dma2d_surface){ d, 6,
+			DMA2D_xPFCCR_CM_RGB565 }, 0, 0, &out, 0, 0, 1, 1);
+	d[0] = 0xf81f;
+	run(&op);
+	CHECK(o[0] == 0xffff00ff);
+}
+
+static void test_clut(void)
+{
+	static const uint32_t clut[] = {
+		0xff000000, 0xffff0000, 0xff00ff00, 0x800000ff,
+	};
+	uint32_t *table = alloc(sizeof(clut));
+	uint8_t *rgb = alloc(3 * 2);
+	struct dma2d_surface l8 = { alloc(4), 4, DMA2D_xPFCCR_CM_L8 };
+	struct dma2d_surface l4 = { alloc(8), 5, DMA2D_xPFCCR_CM_L4 };
+	struct dma2d_surface out = { alloc(4 * 2 * 4), 4,
+				     DMA2D_OPFCCR_CM_ARGB8888 };
+	uint8_t *p8 = l8.pixels;
+	uint8_t *p4 = l4.pixels;
+	uint32_t *o = out.pixels;
+	struct dma2d_op op;
+
+	memcpy(table, clut, sizeof(clut));
+	dma2d_op_load_clut(&op, table, 4, false);
+	run(&op);
+
+	p8[0] = 3;
+	p8[1] = 1;
+	p8[2] = 2;
+	dma2d_op_copy(&op, &l8, 0, 0, &out, 0, 0, 3, 1);
+	run(&op);
+	CHECK(o[0] == clut[3] && o[1] == clut[1] && o[2] == clut[2]);
+
+	/* Low nibble first; the second line starts mid byte, stride 5 */
+	p4[0] = 0x21;		/* pixels 0, 1 */
+	p4[1] = 0x03;		/* pixels 2, 3 */
+	p4[2] = 0x10;		/* pixels 4, 5 */
+	p4[3] = 0x32;		/* pixels 6, 7 */
+	dma2d_op_copy(&op, &l4, 0, 0, &out, 0, 0, 3, 2);
+	run(&op);
+	CHECK(o[0] == clut[1] && o[1] == clut[2] && o[2] == clut[3]);
+	CHECK(o[4] == clut[1] && o[5] == clut[2] && o[6] == clut[3]);
+
+	/* Packed 24 bit entries are opaque */
+	rgb[0] = 0x56;
+	rgb[1] = 0x34;
+	rgb[2] = 0x12;
+	rgb[3] = 0xcc;
+	rgb[4] = 0xbb;
+	rgb[5] = 0xaa;
+	dma2d_op_load_clut(&op, rgb, 2, true);
+	run(&op);
+	p8[0] = 1;
+	p8[1] = 0;
+	dma2d_op_copy(&op, &l8, 0, 0, &out, 0, 0, 2, 1);
+	run(&op);
+	CHECK(o[0] == 0xffaabbcc && o[1] == 0xff123456);
+}
+
+static void test_blend(void)
+{
+	struct dma2d_surface mask = { alloc(4), 4, DMA2D_xPFCCR_CM_A8 };
+	struct dma2d_surface bg = { alloc(4 * 3), 4,
+				    DMA2D_xPFCCR_CM_RGB888 };
+	struct dma2d_surface fg = { alloc(4 * 4), 4,
+				    DMA2D_xPFCCR_CM_ARGB8888 };
+	struct dma2d_surface out = { alloc(4 * 4), 4,
+				     DMA2D_OPFCCR_CM_ARGB8888 };
+	uint8_t *m = mask.pixels;
+	uint8_t *b = bg.pixels;
+	uint32_t *f = fg.pixels;
+	uint32_t *o = out.pixels;
+	struct dma2d_op op;
+
+	/* A glyph mask in red over white, written back to the background */
+	memset(b, 0xff, 4 * 3);
+	m[0] = 0;
+	m[1] = 128;
+	m[2] = 255;
+	dma2d_op_blend(&op, &mask, 0, 0, &bg, 0, 0, &bg, 0, 0, 3, 1,
+		       DMA2D_xPFCCR_AM_NONE, 0);
+	dma2d_op_set_color(&op, 0xff0000);
+	run(&op);
+	CHECK(b[0] == 0xff && b[1] == 0xff && b[2] == 0xff);
+	CHECK(b[3] == 0x7f && b[4] == 0x7f && b[5] == 0xff);
+	CHECK(b[6] == 0x00 && b[7] == 0x00 && b[8] == 0xff);
+
+	/* Constant alpha replacing the pixel one, and scaling it */
+	f[0] = 0x00ffffff;
+	f[1] = 0x80ffffff;
+	memset(b, 0, 4 * 3);
+	dma2d_op_blend(&op, &fg, 0, 0, &bg, 0, 0, &out, 0, 0, 2, 1,
+		       DMA2D_xPFCCR_AM_FORCE, 255);
+	run(&op);
+	CHECK(o[0] == 0xffffffff && o[1] == 0xffffffff);
+	dma2d_op_blend(&op, &fg, 0, 0, &bg, 0, 0, &out, 0, 0, 2, 1,
+		       DMA2D_xPFCCR_AM_PRODUCT, 255);
+	run(&op);
+	CHECK(o[0] == 0xff000000 && o[1] == 0xff808080);
+}
+
+static int order[4];
+static int norder;
+static int depth;
+static struct dma2d_op chained;
+
+static void callback(struct dma2d_op *op)
+{
+	CHECK(depth == 0);
+	depth++;
+	order[norder++] = (int)(intptr_t)op->user;
+	if (op->user == (void *)1) {
+		/* Runs after this callback returns, not from within it */
+		dma2d_submit(&chained);
+		CHECK(norder == 1);
+	}
+	depth--;
+}
+
+static void test_queue(void)
+{
+	struct dma2d_surface dst = { alloc(4 * 4), 4,
+				     DMA2D_OPFCCR_CM_ARGB8888 };
+	uint32_t *px = dst.pixels;
+	struct dma2d_op op;
+
+	dma2d_op_fill(&op, &dst, 0, 0, 1, 1, 0x11111111);
+	op.callback = callback;
+	op.user = (void *)1;
+	dma2d_op_fill(&chained, &dst, 1, 0, 1, 1, 0x22222222);
+	chained.callback = callback;
+	chained.user = (void *)2;
+
+	dma2d_submit(&op);
+	CHECK(!dma2d_busy());
+	CHECK(norder == 2 && order[0] == 1 && order[1] == 2);
+	CHECK(px[0] == 0x11111111 && px[1] == 0x22222222);
+}
+
+int main(void)
+{
+	dma2d_set_software(true);
+
+	test_fill();
+	test_copy_convert();
+	test_clut();
+	test_blend();
+	test_queue();
+
+	printf("dma2d-soft: %d failures\n", failures);
+
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,354 @@
+/*
+ * This file is part of the libopencm3 project.
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include <libopencm3/ethernet/mac.h>
+
+#include "emu.h"
+
+#define EMU_REGS_SIZE		0x1058
+
+static uint32_t emu_regs[EMU_REGS_SIZE / 4];
+
+/* Inside the model the register names refer to the storage itself */
+#undef MMIO32
+#define MMIO32(addr)		emu_regs[((addr) - ETHERNET_BASE) / 4]
+
+#define REG(r)			((uint32_t)(&(r) - emu_regs))
+
+/* Descriptor word n, the DMA reads and writes memory directly */
+#define DES(n, bd)		(((volatile uint32_t *)(uintptr_t)(bd))[n])
+
+/*
+ * The status register clears the bits written as one and the poll demand
+ * registers act on any write, which plain memory cannot tell from a read.
+ * Such registers are handed out as a scratch word holding a value the
+ * driver never writes, and the access is resolved on the next one.
+ */
+#define DMASR_UNWRITTEN		(1U << 31)	/* Reserved bit */
+#define DMASR_W1C		0x0001FFFF
+#define PDR_UNWRITTEN		0xFFFFFFFF
+
+static volatile uint32_t scratch;
+static uint32_t pending;	/* Register behind the scratch word, or 0 */
+
+static bool tx_poll;
+static bool rx_poll;
+static uint32_t tx_cur;		/* Next descriptor, 0 until started */
+static uint32_t rx_cur;
+static bool tx_running;
+static bool rx_running;
+static uint32_t mfc;
+static uint32_t mfa;
+
+static emu_tx_sink tx_sink;
+static struct emu_stats stats;
+
+static uint8_t frame[ETH_TDES1_TBS1 * 2];
+
+static void emu_commit(void)
+{
+	uint32_t v = scratch;
+
+	if (pending == REG(ETH_DMASR)) {
+		if (!(v & DMASR_UNWRITTEN)) {
+			ETH_DMASR &= ~(v & DMASR_W1C);
+		}
+	} else if (pending == REG(ETH_DMATPDR)) {
+		if (v != PDR_UNWRITTEN) {
+			tx_poll = true;
+			stats.tx_polls++;
+		}
+	} else if (pending == REG(ETH_DMARPDR)) {
+		if (v != PDR_UNWRITTEN) {
+			rx_poll = true;
+			stats.rx_polls++;
+		}
+	}
+	pending = 0;
+}
+
+volatile uint32_t *emu_mmio32(uintptr_t addr)
+{
+	uint32_t r;
+
+	if (addr < ETHERNET_BASE || addr >= ETHERNET_BASE + EMU_REGS_SIZE) {
+		/* Descriptors and buffers */
+		return (volatile uint32_t *)addr;
+	}
+
+	emu_commit();
+	r = (addr - ETHERNET_BASE) / 4;
+
+	if (r == REG(ETH_DMASR)) {
+		scratch = ETH_DMASR | DMASR_UNWRITTEN;
+	} else if (r == REG(ETH_DMATPDR) || r == REG(ETH_DMARPDR)) {
+		scratch = PDR_UNWRITTEN;
+	} else if (r == REG(ETH_DMAMFBOCR)) {
+		/* Clears on read */
+		scratch = (mfc << ETH_DMAMFBOCR_MFC_SHIFT) |
+			  (mfa << ETH_DMAMFBOCR_MFA_SHIFT);
+		mfc = 0;
+		mfa = 0;
+	} else {
+		return &emu_regs[r];
+	}
+
+	pending = r;
+	return &scratch;
+}
+
+/* The driver issues barriers through the core library */
+void __dmb(void)
+{
+	__sync_synchronize();
+}
+
+void emu_reset(void)
+{
+	pending = 0;
+	memset(emu_regs, 0, sizeof(emu_regs));
+	ETH_DMABMR = 0x00020101;
+	ETH_MACCR = 0x00008000;
+	ETH_MACAHR(0) = 0x8000FFFF;
+	ETH_MACALR(0) = 0xFFFFFFFF;
+
+	tx_poll = false;
+	rx_poll = false;
+	tx_cur = 0;
+	rx_cur = 0;
+	tx_running = false;
+	rx_running = false;
+	mfc = 0;
+	mfa = 0;
+	memset(&stats, 0, sizeof(stats));
+}
+
+void *emu_dma_alloc(size_t size)
+{
+	static uint8_t *arena;
+	static size_t used;
+	const size_t arena_size = 16 << 20;
+	int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+	void *p;
+
+	if (!arena) {
+#ifdef MAP_32BIT
+		flags |= MAP_32BIT;
+#endif
+		arena = mmap((void *)0x20000000, arena_size,
+			     PROT_READ | PROT_WRITE, flags, -1, 0);
+		if (arena == MAP_FAILED ||
+		    (uintptr_t)arena + arena_size > UINT32_MAX) {
+			fprintf(stderr, "no memory below 4G for the DMA\n");
+			exit(2);
+		}
+	}
+
+	size = (size + 31) & ~(size_t)31;
+	if (used + size > arena_size) {
+		fprintf(stderr, "DMA memory exhausted\n");
+		exit(2);
+	}
+	p = arena + used;
+	used += size;
+
+	return p;
+}
+
+void emu_set_tx_sink(emu_tx_sink sink)
+{
+	tx_sink = sink;
+}
+
+/* Sends the frame starting at tx_cur, false if it is not all handed over */
+static bool emu_tx_frame(void)
+{
+	uint32_t bd = tx_cur;
+	uint32_t len = 0;
+
+	if (!(DES(0, bd) & ETH_TDES0_FS)) {
+		fprintf(stderr, "transmit descriptor %08x lacks FS\n", bd);
+		exit(2);
+	}
+
+	for (;;) {
+		uint32_t n = DES(1, bd) & ETH_TDES1_TBS1;
+
+		if (!(DES(0, bd) & ETH_TDES0_TCH)) {
+			fprintf(stderr, "transmit descriptor %08x not chained\n",
+				bd);
+			exit(2);
+		}
+		memcpy(frame + len, (const void *)(uintptr_t)DES(2, bd), n);
+		len += n;
+		if (DES(0, bd) & ETH_TDES0_LS) {
+			break;
+		}
+		bd = DES(3, bd);
+		if (!(DES(0, bd) & ETH_TDES0_OWN)) {
+			stats.tx_underflows++;
+			return false;
+		}
+	}
+
+	/* Hand the descriptors back, last one too */
+	for (;;) {
+		bool last = DES(0, tx_cur) & ETH_TDES0_LS;
+
+		DES(0, tx_cur) &= ~ETH_TDES0_OWN;
+		tx_cur = DES(3, tx_cur);
+		if (last) {
+			break;
+		}
+	}
+
+	stats.tx_frames++;
+	stats.tx_bytes += len;
+	ETH_DMASR |= ETH_DMASR_TS | ETH_DMASR_NIS;
+	if (tx_sink) {
+		tx_sink(frame, len);
+	}
+
+	return true;
+}
+
+uint32_t emu_tx_run(uint32_t max)
+{
+	uint32_t n = 0;
+
+	emu_commit();
+	if (!(ETH_DMAOMR & ETH_DMAOMR_ST)) {
+		return 0;
+	}
+	if (!tx_cur) {
+		tx_cur = ETH_DMATDLAR;
+		tx_running = true;
+	}
+	if (tx_poll) {
+		tx_poll = false;
+		tx_running = true;
+	}
+
+	while (tx_running && n < max) {
+		if (!(DES(0, tx_cur) & ETH_TDES0_OWN) || !emu_tx_frame()) {
+			tx_running = false;
+			ETH_DMASR |= ETH_DMASR_TBUS | ETH_DMASR_NIS;
+			break;
+		}
+		n++;
+	}
+
+	return n;
+}
+
+bool emu_rx_frame(const uint8_t *data, uint32_t len, uint32_t errors)
+{
+	uint32_t off = 0;
+	uint32_t des0 = ETH_RDES0_FS;
+
+	emu_commit();
+	if (!(ETH_DMAOMR & ETH_DMAOMR_SR)) {
+		return false;
+	}
+	if (!rx_cur) {
+		rx_cur = ETH_DMARDLAR;
+		rx_running = true;
+	}
+	if (rx_poll) {
+		rx_poll = false;
+		rx_running = true;
+	}
+
+	/* Only a poll demand resumes reception, a missing one loses frames */
+	if (!rx_running || !(DES(0, rx_cur) & ETH_RDES0_OWN)) {
+		rx_running = false;
+		ETH_DMASR |= ETH_DMASR_RBUS | ETH_DMASR_AIS;
+		stats.rx_missed++;
+		mfc++;
+		return false;
+	}
+
+	for (;;) {
+		uint32_t n = DES(1, rx_cur) & ETH_RDES1_RBS1;
+		uint32_t next = DES(3, rx_cur);
+
+		if (n > len - off) {
+			n = len - off;
+		}
+		memcpy((void *)(uintptr_t)DES(2, rx_cur), data + off, n);
+		off += n;
+
+		if (off == len) {
+			des0 |= ETH_RDES0_LS | (len << ETH_RDES0_FL_SHIFT) |
+				errors | (errors ? ETH_RDES0_ES : 0);
+			DES(0, rx_cur) = des0;
+			rx_cur = next;
+			break;
+		}
+
+		if (!(DES(0, next) & ETH_RDES0_OWN)) {
+			/* The rest of the frame is flushed */
+			DES(0, rx_cur) = des0 | ETH_RDES0_LS | ETH_RDES0_ES |
+					 ETH_RDES0_DCE;
+			rx_cur = next;
+			rx_running = false;
+			ETH_DMASR |= ETH_DMASR_RS | ETH_DMASR_NIS |
+				     ETH_DMASR_RBUS | ETH_DMASR_AIS;
+			stats.rx_truncated++;
+			return false;
+		}
+
+		DES(0, rx_cur) = des0;
+		des0 = 0;
+		rx_cur = next;
+	}
+
+	stats.rx_frames++;
+	ETH_DMASR |= ETH_DMASR_RS | ETH_DMASR_NIS;
+
+	return true;
+}
+
+void emu_rx_fifo_overflow(uint32_t n)
+{
+	mfa += n;
+}
+
+bool emu_irq_pending(void)
+{
+	const uint32_t normal = ETH_DMASR_TS | ETH_DMASR_TBUS | ETH_DMASR_RS |
+				ETH_DMASR_ERS;
+	uint32_t active;
+
+	emu_commit();
+	active = ETH_DMASR & ETH_DMAIER & 0x7FFF;
+
+	return ((active & normal) && (ETH_DMAIER & ETH_DMAIER_NISE)) ||
+	       ((active & ~normal) && (ETH_DMAIER & ETH_DMAIER_AISE));
+}
+
+void emu_get_stats(struct emu_stats *s)
+{
+	*s = stats;
+}
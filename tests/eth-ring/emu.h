@@ -0,0 +1,74 @@
+/*
+ * This file is part of the libopencm3 project.
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Model of the STM32F4 Ethernet MAC and DMA register block and of the DMA
+ * walking the chained descriptor rings, for running the driver on the host.
+ * The DMA only moves when told to, see emu_tx_run() and emu_rx_frame().
+ */
+
+#ifndef ETH_RING_EMU_H
+#define ETH_RING_EMU_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Counters kept by the model, independent of the driver statistics */
+struct emu_stats {
+	uint32_t tx_frames;
+	uint32_t tx_bytes;
+	/* Frames whose descriptors were not all handed over */
+	uint32_t tx_underflows;
+	uint32_t rx_frames;
+	/* Frames lost for lack of a descriptor, also in ETH_DMAMFBOCR */
+	uint32_t rx_missed;
+	/* Frames cut short by a descriptor still owned by software */
+	uint32_t rx_truncated;
+	uint32_t tx_polls;
+	uint32_t rx_polls;
+};
+
+/* Called with each frame the transmit DMA sends */
+typedef void (*emu_tx_sink)(const uint8_t *frame, uint32_t len);
+
+/* Reset values in all registers, counters cleared, both DMAs stopped */
+void emu_reset(void);
+
+/* Memory the driver can hold 32 bit addresses of, never freed */
+void *emu_dma_alloc(size_t size);
+
+void emu_set_tx_sink(emu_tx_sink sink);
+
+/* Sends up to max frames, until the DMA finds a descriptor it does not own
+ * or, when suspended, until the next transmit poll demand. Returns the
+ * number of frames sent. */
+uint32_t emu_tx_run(uint32_t max);
+
+/* Receives a frame, with the ETH_RDES0_* error bits given. Returns false
+ * if it was missed or truncated. */
+bool emu_rx_frame(const uint8_t *frame, uint32_t len, uint32_t errors);
+
+/* Counts frames lost in the receive FIFO */
+void emu_rx_fifo_overflow(uint32_t n);
+
+/* True while an enabled interrupt is pending in ETH_DMASR */
+bool emu_irq_pending(void);
+
+void emu_get_stats(struct emu_stats *stats);
+
+#endif
@@ -0,0 +1,35 @@
+/*
+ * This file is part of the libopencm3 project.
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Host build only: found ahead of the real header, it routes the 32 bit
+ * register accesses through the model, which sees each access one at a time.
+ */
+
+#ifndef ETH_RING_HOST_COMMON_H
+#define ETH_RING_HOST_COMMON_H
+
+#include_next <libopencm3/cm3/common.h>
+
+#include <stdint.h>
+
+volatile uint32_t *emu_mmio32(uintptr_t addr);
+
+#undef MMIO32
+#define MMIO32(addr)		(*emu_mmio32((uintptr_t)(addr)))
+
+#endif
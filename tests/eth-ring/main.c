@@ -0,0 +1,646 @@
+/*
+ * This file is part of the libopencm3 project.
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define _GNU_SOURCE
+
+#include <libopencm3/ethernet/mac.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_CYCLES 1
+#endif
+
+#include "emu.h"
+
+#define BUF_SIZE		1524
+#define DESC_SIZE		ETH_DES_STD_SIZE
+#define RING_MAX		32
+
+static uint8_t *ring;
+static uint32_t ring_ntx;
+static uint32_t ring_nrx;
+
+static int failures;
+
+#define CHECK(cond) \
+	do { \
+		if (!(cond)) { \
+			printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+			failures++; \
+		} \
+	} while (0)
+
+/* Address of receive descriptor i in the eth_desc_init() layout */
+static uint32_t rx_desc(uint32_t i)
+{
+	return (uint32_t)(uintptr_t)ring +
+	       (ring_ntx + i) * (DESC_SIZE + BUF_SIZE);
+}
+
+static bool rx_owned(uint32_t i)
+{
+	return ETH_DES0(rx_desc(i)) & ETH_RDES0_OWN;
+}
+
+static bool rx_all_owned(void)
+{
+	uint32_t i;
+
+	for (i = 0; i < ring_nrx; i++) {
+		if (!rx_owned(i)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static void setup(uint32_t ntx, uint32_t nrx)
+{
+	ring_ntx = ntx;
+	ring_nrx = nrx;
+	emu_reset();
+	emu_set_tx_sink(NULL);
+	eth_set_tx_callback(NULL);
+	eth_desc_init(ring, ntx, nrx, BUF_SIZE, BUF_SIZE, false);
+	eth_start();
+	/* The transmit DMA finds the ring empty and suspends */
+	emu_tx_run(1);
+}
+
+/* Frames carry a sequence number in their first word */
+static void make_frame(uint8_t *buf, uint32_t len, uint32_t seq)
+{
+	uint32_t i;
+
+	memcpy(buf, &seq, sizeof(seq));
+	for (i = sizeof(seq); i < len; i++) {
+		buf[i] = seq + i;
+	}
+}
+
+static bool frame_ok(const uint8_t *buf, uint32_t len, uint32_t seq)
+{
+	uint32_t i;
+
+	if (memcmp(buf, &seq, sizeof(seq))) {
+		return false;
+	}
+	for (i = sizeof(seq); i < len; i++) {
+		if (buf[i] != (uint8_t)(seq + i)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool inject(uint32_t len, uint32_t seq, uint32_t errors)
+{
+	static uint8_t buf[BUF_SIZE * 2];
+
+	make_frame(buf, len, seq);
+	return emu_rx_frame(buf, len, errors);
+}
+
+static bool acquire(uint8_t **frame, uint32_t len, uint32_t seq)
+{
+	uint32_t l;
+
+	return eth_rx_acquire(frame, &l) && l == len &&
+	       frame_ok(*frame, len, seq);
+}
+
+static uint32_t rx_seen;
+
+static uint8_t *rx_count(uint8_t *frame, uint32_t len)
+{
+	(void)len;
+	rx_seen++;
+	return frame;
+}
+
+static void test_rx_basic(void)
+{
+	struct eth_rx_stats st;
+	uint8_t *f;
+	uint32_t len;
+
+	setup(4, 4);
+	CHECK(inject(60, 1, 0));
+	CHECK(inject(100, 2, 0));
+	CHECK(inject(1514, 3, 0));
+
+	CHECK(acquire(&f, 60, 1));
+	eth_rx_release(f);
+	CHECK(acquire(&f, 100, 2));
+	eth_rx_release(f);
+	CHECK(acquire(&f, 1514, 3));
+	eth_rx_release(f);
+	CHECK(!eth_rx_acquire(&f, &len));
+	CHECK(rx_all_owned());
+
+	eth_rx_get_stats(&st, false);
+	CHECK(st.frames == 3);
+}
+
+/* Frames dropped while others are lent must wait for them */
+static void test_rx_lend_drop(void)
+{
+	struct eth_rx_stats st;
+	uint8_t *a, *c, *d, *f;
+	uint32_t len;
+
+	setup(4, 4);
+	CHECK(inject(60, 1, 0));
+	CHECK(inject(60, 2, ETH_RDES0_CE));
+	CHECK(inject(60, 3, 0));
+
+	CHECK(acquire(&a, 60, 1));
+	CHECK(acquire(&c, 60, 3));
+	CHECK(!rx_owned(0) && !rx_owned(1) && !rx_owned(2));
+
+	/* The DMA fills the last descriptor, then stops at the lent one */
+	CHECK(inject(60, 4, 0));
+	CHECK(!inject(60, 5, 0));
+	CHECK(frame_ok(a, 60, 1));
+
+	/* The dropped frame goes back with the one lent before it */
+	eth_rx_release(a);
+	CHECK(rx_owned(0) && rx_owned(1) && !rx_owned(2) && !rx_owned(3));
+
+	/* Release resumed the DMA, which must not reach the lent frame */
+	CHECK(inject(60, 6, 0));
+	CHECK(inject(60, 7, 0));
+	CHECK(!inject(60, 8, 0));
+	CHECK(frame_ok(c, 60, 3));
+
+	CHECK(acquire(&d, 60, 4));
+	eth_rx_release(c);
+	CHECK(rx_owned(2) && !rx_owned(3));
+	eth_rx_release(d);
+
+	CHECK(acquire(&f, 60, 6));
+	eth_rx_release(f);
+	CHECK(acquire(&f, 60, 7));
+	eth_rx_release(f);
+	CHECK(!eth_rx_acquire(&f, &len));
+	CHECK(rx_all_owned());
+
+	eth_rx_get_stats(&st, false);
+	CHECK(st.frames == 5);
+	CHECK(st.crc_errors == 1);
+	CHECK(st.missed == 2);
+}
+
+/* A frame kept by the stack is replaced by a fresh buffer */
+static void test_rx_fresh_buffer(void)
+{
+	uint8_t *fresh = emu_dma_alloc(BUF_SIZE);
+	uint8_t *f;
+	uint32_t i;
+
+	setup(4, 4);
+	CHECK(inject(60, 1, 0));
+	CHECK(acquire(&f, 60, 1));
+	eth_rx_release(fresh);
+	CHECK(ETH_DES2(rx_desc(0)) == (uint32_t)(uintptr_t)fresh);
+
+	for (i = 0; i < 4; i++) {
+		CHECK(inject(80, 10 + i, 0));
+	}
+	for (i = 0; i < 4; i++) {
+		CHECK(acquire(&f, 80, 10 + i));
+		CHECK(i != 3 || f == fresh);
+		eth_rx_release(f);
+	}
+	CHECK(rx_all_owned());
+}
+
+static void test_rx_ring_full(void)
+{
+	struct eth_rx_stats st;
+	struct emu_stats es;
+	uint32_t i;
+
+	setup(4, 4);
+	for (i = 0; i < 4; i++) {
+		CHECK(inject(60, i, 0));
+	}
+	CHECK(!inject(60, 4, 0));
+	CHECK(!inject(60, 5, 0));
+	CHECK(ETH_DMASR & ETH_DMASR_RBUS);
+
+	rx_seen = 0;
+	CHECK(eth_rx_poll(rx_count, 16) == 4);
+	CHECK(rx_seen == 4);
+	CHECK(!(ETH_DMASR & ETH_DMASR_RBUS));
+
+	emu_get_stats(&es);
+	CHECK(es.rx_polls == 1);
+	CHECK(inject(60, 6, 0));
+
+	eth_rx_get_stats(&st, true);
+	CHECK(st.frames == 4);
+	CHECK(st.missed == 2);
+	CHECK(st.ring_full == 1);
+	CHECK(st.ring_high == 4);
+}
+
+static void test_rx_errors(void)
+{
+	static const uint32_t errors[] = {
+		ETH_RDES0_CE, ETH_RDES0_LE, ETH_RDES0_RE, ETH_RDES0_LCO,
+		ETH_RDES0_RWT, ETH_RDES0_OE,
+	};
+	struct eth_rx_stats st;
+	uint8_t *f[3];
+	uint32_t i;
+
+	setup(4, 4);
+	for (i = 0; i < sizeof(errors) / sizeof(errors[0]); i++) {
+		CHECK(inject(60, i, errors[i]));
+		rx_seen = 0;
+		eth_rx_poll(rx_count, 16);
+		CHECK(rx_seen == 0);
+	}
+
+	/* Spread over two descriptors */
+	CHECK(inject(BUF_SIZE + 100, 10, 0));
+	CHECK(inject(60, 11, 0));
+	CHECK(acquire(&f[0], 60, 11));
+	eth_rx_release(f[0]);
+
+	/* Cut short by a lent descriptor */
+	for (i = 0; i < 3; i++) {
+		CHECK(inject(60, 20 + i, 0));
+		CHECK(acquire(&f[i], 60, 20 + i));
+	}
+	CHECK(!inject(BUF_SIZE + 100, 23, 0));
+	for (i = 0; i < 3; i++) {
+		eth_rx_release(f[i]);
+	}
+	CHECK(inject(60, 24, 0));
+	CHECK(acquire(&f[0], 60, 24));
+	eth_rx_release(f[0]);
+	CHECK(rx_all_owned());
+
+	emu_rx_fifo_overflow(3);
+
+	eth_rx_get_stats(&st, false);
+	CHECK(st.frames == 5);
+	CHECK(st.crc_errors == 1);
+	CHECK(st.length_errors == 1);
+	CHECK(st.phy_errors == 1);
+	CHECK(st.collisions == 1);
+	CHECK(st.watchdog == 1);
+	CHECK(st.overflows == 1);
+	CHECK(st.split == 1);
+	CHECK(st.truncated == 1);
+	CHECK(st.fifo_missed == 3);
+}
+
+/* Stands for the Ethernet interrupt, true if a poll is to be scheduled */
+static bool isr(void)
+{
+	bool poll = eth_rx_irq_handler();
+
+	eth_irq_ack_pending(ETH_DMASR_NIS);
+	return poll;
+}
+
+static void test_rx_poll_irq(void)
+{
+	uint32_t i;
+
+	setup(4, 4);
+	eth_irq_enable(ETH_DMAIER_NISE | ETH_DMAIER_RIE);
+	for (i = 0; i < 3; i++) {
+		CHECK(inject(60, i, 0));
+	}
+
+	CHECK(emu_irq_pending());
+	CHECK(isr());
+	CHECK(!emu_irq_pending());
+
+	/* Budget used up, the interrupt stays masked */
+	rx_seen = 0;
+	CHECK(eth_rx_poll(rx_count, 2) == 2);
+	CHECK(!(ETH_DMAIER & ETH_DMAIER_RIE));
+	CHECK(inject(60, 3, 0));
+	CHECK(!emu_irq_pending());
+
+	CHECK(eth_rx_poll(rx_count, 2) == 2);
+	CHECK(eth_rx_poll(rx_count, 2) == 0);
+	CHECK(ETH_DMAIER & ETH_DMAIER_RIE);
+	CHECK(rx_seen == 4);
+
+	CHECK(inject(60, 4, 0));
+	CHECK(emu_irq_pending());
+	CHECK(isr());
+	CHECK(eth_rx_poll(rx_count, 2) == 1);
+	CHECK(rx_all_owned());
+}
+
+static uint8_t tx_last[BUF_SIZE * 2];
+static uint32_t tx_last_len;
+
+static void tx_record(const uint8_t *frame, uint32_t len)
+{
+	memcpy(tx_last, frame, len);
+	tx_last_len = len;
+}
+
+static uint8_t *tx_done[8];
+static uint32_t tx_ndone;
+
+static void tx_collect(uint8_t *buf)
+{
+	if (tx_ndone < 8) {
+		tx_done[tx_ndone] = buf;
+	}
+	tx_ndone++;
+}
+
+static void test_tx_copy(void)
+{
+	uint8_t buf[BUF_SIZE];
+	uint32_t i;
+
+	setup(4, 4);
+	emu_set_tx_sink(tx_record);
+
+	for (i = 0; i < 10; i++) {
+		make_frame(buf, 100 + i, i);
+		CHECK(eth_tx(buf, 100 + i));
+		CHECK(emu_tx_run(8) == 1);
+		CHECK(tx_last_len == 100 + i && frame_ok(tx_last, 100 + i, i));
+	}
+
+	/* Ring full until the DMA is done with a frame */
+	for (i = 0; i < 4; i++) {
+		CHECK(eth_tx(buf, 60));
+	}
+	CHECK(!eth_tx(buf, 60));
+	CHECK(emu_tx_run(8) == 4);
+	CHECK(eth_tx(buf, 60));
+	CHECK(emu_tx_run(8) == 1);
+}
+
+static void test_tx_gather(void)
+{
+	struct emu_stats es;
+	struct eth_iovec iov[3];
+	uint8_t *frame = emu_dma_alloc(300);
+	uint8_t buf[64];
+	uint32_t polls;
+	uint32_t i;
+
+	setup(4, 4);
+	emu_set_tx_sink(tx_record);
+	eth_set_tx_callback(tx_collect);
+	tx_ndone = 0;
+
+	make_frame(frame, 234, 7);
+	iov[0].base = frame;
+	iov[0].len = 14;
+	iov[1].base = emu_dma_alloc(20);
+	iov[1].len = 20;
+	memcpy(iov[1].base, frame + 14, 20);
+	iov[2].base = emu_dma_alloc(200);
+	iov[2].len = 200;
+	memcpy(iov[2].base, frame + 34, 200);
+
+	/* Queued, but the DMA is not woken up */
+	CHECK(eth_tx_gather(iov, 3, ETH_TX_MORE));
+	CHECK(emu_tx_run(8) == 0);
+	eth_tx_flush();
+	CHECK(emu_tx_run(8) == 1);
+	CHECK(tx_last_len == 234 && frame_ok(tx_last, 234, 7));
+
+	CHECK(tx_ndone == 0);
+	CHECK(eth_tx_reclaim() == 1);
+	CHECK(tx_ndone == 3);
+	for (i = 0; i < 3; i++) {
+		CHECK(tx_done[i] == iov[i].base);
+	}
+
+	/* The descriptors have their own buffers back */
+	make_frame(buf, sizeof(buf), 8);
+	CHECK(eth_tx(buf, sizeof(buf)));
+	CHECK(emu_tx_run(8) == 1);
+	CHECK(frame_ok(tx_last, sizeof(buf), 8));
+
+	CHECK(!eth_tx_gather(iov, 5, 0));
+
+	/* A burst costs one poll demand */
+	emu_get_stats(&es);
+	polls = es.tx_polls;
+	CHECK(eth_tx_gather(iov, 1, ETH_TX_MORE));
+	CHECK(eth_tx_gather(iov, 2, ETH_TX_MORE));
+	CHECK(eth_tx_gather(iov, 1, 0));
+	CHECK(emu_tx_run(8) == 3);
+	emu_get_stats(&es);
+	CHECK(es.tx_polls == polls + 1);
+	CHECK(eth_tx_reclaim() == 3);
+	CHECK(tx_ndone == 7);
+}
+
+/*
+ * Benchmark: frames looped back from the transmit DMA into the receive one,
+ * with only the time spent in the driver counted.
+ */
+
+static void loopback(const uint8_t *frame, uint32_t len)
+{
+	emu_rx_frame(frame, len, 0);
+}
+
+static void tx_forget(uint8_t *buf)
+{
+	(void)buf;
+}
+
+static uint8_t *rx_keep(uint8_t *frame, uint32_t len)
+{
+	(void)len;
+	return frame;
+}
+
+struct timer {
+	uint64_t ns;
+	uint64_t cycles;
+	uint64_t start_ns;
+	uint64_t start_cycles;
+};
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void timer_start(struct timer *t)
+{
+	t->start_ns = now_ns();
+#ifdef HAVE_CYCLES
+	t->start_cycles = __rdtsc();
+#endif
+}
+
+static void timer_stop(struct timer *t)
+{
+#ifdef HAVE_CYCLES
+	t->cycles += __rdtsc() - t->start_cycles;
+#endif
+	t->ns += now_ns() - t->start_ns;
+}
+
+static void report(const char *what, uint32_t len, const struct timer *t,
+		   uint32_t frames)
+{
+	printf("%-16s %5u bytes: %10.0f frames/s %8.1f ns/frame", what, len,
+	       frames * 1e9 / t->ns, (double)t->ns / frames);
+#ifdef HAVE_CYCLES
+	printf(" %8.1f cycles/frame", (double)t->cycles / frames);
+#endif
+	printf("\n");
+}
+
+static void bench(uint32_t len, bool zero_copy, uint32_t frames)
+{
+	const uint32_t batch = 8;
+	struct timer tx = { 0 }, rx = { 0 };
+	struct eth_rx_stats st;
+	uint8_t *buf = emu_dma_alloc(len);
+	uint32_t sent = 0;
+	uint32_t i;
+
+	setup(16, 16);
+	emu_set_tx_sink(loopback);
+	eth_set_tx_callback(tx_forget);
+	make_frame(buf, len, 0);
+
+	while (sent < frames) {
+		timer_start(&tx);
+		for (i = 0; i < batch; i++) {
+			if (zero_copy) {
+				eth_tx_gather(&(struct eth_iovec){ buf, len },
+					      1, i < batch - 1 ? ETH_TX_MORE : 0);
+			} else {
+				eth_tx(buf, len);
+			}
+		}
+		timer_stop(&tx);
+
+		emu_tx_run(batch);
+
+		timer_start(&rx);
+		eth_rx_poll(rx_keep, batch);
+		timer_stop(&rx);
+
+		sent += batch;
+	}
+
+	eth_rx_get_stats(&st, false);
+	CHECK(st.frames == sent);
+
+	report(zero_copy ? "tx gather" : "tx copy", len, &tx, sent);
+	report("rx poll", len, &rx, sent);
+}
+
+/* Replays a capture file into the receive ring */
+static int replay(const char *path)
+{
+	static uint8_t buf[65536];
+	struct eth_rx_stats st;
+	struct emu_stats es;
+	struct timer rx = { 0 };
+	uint32_t hdr[6];
+	uint32_t rec[4];
+	bool swap;
+	FILE *fp;
+
+	fp = fopen(path, "rb");
+	if (!fp || fread(hdr, sizeof(hdr), 1, fp) != 1) {
+		fprintf(stderr, "%s: cannot read\n", path);
+		return 2;
+	}
+	swap = hdr[0] == 0xd4c3b2a1 || hdr[0] == 0x4d3cb2a1;
+	if (!swap && hdr[0] != 0xa1b2c3d4 && hdr[0] != 0xa1b23c4d) {
+		fprintf(stderr, "%s: not a pcap file\n", path);
+		return 2;
+	}
+
+	setup(4, 16);
+	while (fread(rec, sizeof(rec), 1, fp) == 1) {
+		uint32_t len = swap ? __builtin_bswap32(rec[2]) : rec[2];
+
+		if (len > sizeof(buf) || fread(buf, len, 1, fp) != 1) {
+			break;
+		}
+		emu_rx_frame(buf, len, 0);
+
+		timer_start(&rx);
+		eth_rx_poll(rx_keep, 16);
+		timer_stop(&rx);
+	}
+	fclose(fp);
+
+	eth_rx_get_stats(&st, false);
+	emu_get_stats(&es);
+	printf("%s: %u frames, %u delivered, %u split, %u missed\n", path,
+	       es.rx_frames + es.rx_missed + es.rx_truncated, st.frames,
+	       st.split, st.missed);
+	if (st.frames) {
+		report("rx replay", 0, &rx, st.frames);
+	}
+
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	ring = emu_dma_alloc(RING_MAX * (DESC_SIZE + BUF_SIZE));
+
+	if (argc > 1) {
+		return replay(argv[1]);
+	}
+
+	test_rx_basic();
+	test_rx_lend_drop();
+	test_rx_fresh_buffer();
+	test_rx_ring_full();
+	test_rx_errors();
+	test_rx_poll_irq();
+	test_tx_copy();
+	test_tx_gather();
+
+	bench(64, false, 1000000);
+	bench(64, true, 1000000);
+	bench(1514, false, 200000);
+	bench(1514, true, 200000);
+
+	printf("eth-ring: %d failures\n", failures);
+
+	return failures ? 1 : 0;
+}
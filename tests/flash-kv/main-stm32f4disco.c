@@ -0,0 +1,100 @@
+/*
+ * This file is part of the libopencm3 project.
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <libopencm3/stm32/flash.h>
+#include <libopencm3/stm32/flash_kv.h>
+#include <libopencm3/stm32/gpio.h>
+#include <libopencm3/stm32/rcc.h>
+
+#include <stdio.h>
+#include <string.h>
+
+/* Sectors 6 and 7, the last two of the 512K parts, well above the image */
+static const struct flash_kv_sector sectors[] = {
+	{ 0x08040000, 0x20000, 6 },
+	{ 0x08060000, 0x20000, 7 },
+};
+
+static uint32_t kv_index[8];
+
+static struct flash_kv kv = {
+	.sectors = sectors,
+	.nsectors = 2,
+	.index = kv_index,
+	.keys = 8,
+	.program_size = FLASH_CR_PROGRAM_X32,
+};
+
+static int failures;
+
+#define CHECK(cond) \
+	do { \
+		if (!(cond)) { \
+			printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+			failures++; \
+		} \
+	} while (0)
+
+/* Store a value and read it back, from the RAM index and after a remount. */
+static void check_value(uint16_t key, const uint8_t *data, uint16_t len)
+{
+	uint8_t buf[16];
+
+	CHECK(flash_kv_set(&kv, key, data, len));
+	memset(buf, 0xa5, sizeof(buf));
+	CHECK(flash_kv_get(&kv, key, buf, sizeof(buf)) == len);
+	CHECK(memcmp(buf, data, len) == 0);
+
+	CHECK(flash_kv_mount(&kv));
+	memset(buf, 0xa5, sizeof(buf));
+	CHECK(flash_kv_get(&kv, key, buf, sizeof(buf)) == len);
+	CHECK(memcmp(buf, data, len) == 0);
+}
+
+int main(void)
+{
+	static const uint8_t data[] = { 0x5a, 0x01, 0x02, 0x03, 0x04, 0x05,
+					0x06, 0x07, 0x08 };
+	uint16_t len;
+
+	rcc_clock_setup_pll(&rcc_hse_8mhz_3v3[RCC_CLOCK_3V3_168MHZ]);
+
+	/* LEDS on discovery board: green is pass, red is fail */
+	rcc_periph_clock_enable(RCC_GPIOD);
+	gpio_mode_setup(GPIOD, GPIO_MODE_OUTPUT,
+			GPIO_PUPD_NONE, GPIO12 | GPIO14);
+
+	flash_unlock();
+	CHECK(flash_kv_format(&kv));
+
+	/* Shorter than one program unit, from an aligned record */
+	check_value(0, data, 1);
+	check_value(1, data, 3);
+	/* A whole unit plus a tail */
+	check_value(2, data, 5);
+	check_value(3, data, sizeof(data));
+	/* Update of a short value, then delete it */
+	check_value(0, data + 1, 1);
+	CHECK(flash_kv_delete(&kv, 0));
+	CHECK(flash_kv_find(&kv, 0, &len) == NULL);
+	flash_lock();
+
+	printf("flash-kv: %d failures\n", failures);
+	gpio_set(GPIOD, failures ? GPIO14 : GPIO12);
+
+	while (1);
+}
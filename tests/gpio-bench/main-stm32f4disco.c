@@ -0,0 +1,104 @@
+/*
+ * This file is part of the libopencm3 project.
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <libopencm3/cm3/dwt.h>
+#include <libopencm3/stm32/gpio.h>
+#include <libopencm3/stm32/rcc.h>
+
+#include <stdio.h>
+
+#define TOGGLES		10000
+
+/* Orange LED, also a probe point for the toggle rate */
+#define PORT		GPIOD
+#define PIN		GPIO13
+
+/*
+ * The same loop through the library call and through the inline accessor
+ * that LIBOPENCM3_INLINE_ACCESSORS selects. Kept out of line so that their
+ * sizes show up separately in the symbol table.
+ */
+__attribute__((noinline)) static void toggle_call(uint32_t n)
+{
+	while (n--) {
+		gpio_toggle(PORT, PIN);
+	}
+}
+
+__attribute__((noinline)) static void toggle_inline(uint32_t n)
+{
+	while (n--) {
+		gpio_toggle_inline(PORT, PIN);
+	}
+}
+
+__attribute__((noinline)) static void set_clear_call(uint32_t n)
+{
+	while (n--) {
+		gpio_set(PORT, PIN);
+		gpio_clear(PORT, PIN);
+	}
+}
+
+__attribute__((noinline)) static void set_clear_inline(uint32_t n)
+{
+	while (n--) {
+		gpio_set_inline(PORT, PIN);
+		gpio_clear_inline(PORT, PIN);
+	}
+}
+
+static uint32_t measure(void (*loop)(uint32_t))
+{
+	uint32_t start = DWT_CYCCNT;
+
+	loop(TOGGLES);
+	return DWT_CYCCNT - start;
+}
+
+static void report(const char *name, void (*loop)(uint32_t))
+{
+	uint32_t cycles;
+
+	/* Once to fill the flash accelerator caches */
+	measure(loop);
+	cycles = measure(loop);
+	printf("%-16s %5lu.%02lu cycles/iteration\n", name,
+	       (unsigned long)(cycles / TOGGLES),
+	       (unsigned long)(cycles % TOGGLES * 100 / TOGGLES));
+}
+
+int main(void)
+{
+	rcc_clock_setup_pll(&rcc_hse_8mhz_3v3[RCC_CLOCK_3V3_168MHZ]);
+
+	rcc_periph_clock_enable(RCC_GPIOD);
+	gpio_mode_setup(PORT, GPIO_MODE_OUTPUT, GPIO_PUPD_NONE, PIN);
+	gpio_set_output_options(PORT, GPIO_OTYPE_PP, GPIO_OSPEED_100MHZ, PIN);
+
+	if (!dwt_enable_cycle_counter()) {
+		printf("gpio-bench: no cycle counter\n");
+		while (1);
+	}
+
+	report("toggle call", toggle_call);
+	report("toggle inline", toggle_inline);
+	report("set/clear call", set_clear_call);
+	report("set/clear inline", set_clear_inline);
+
+	while (1);
+}